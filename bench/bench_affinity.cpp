@@ -0,0 +1,87 @@
+// JSON compare throughput on rt::ThreadPool under different worker
+// placements: unpinned, pinned per core, and pinned per NUMA node with
+// node-local queues. Differences only show on multi-socket hosts.
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "bench_common.hpp"
+#include "core/IComparator.hpp"
+#include "core/PluginManager.hpp"
+#include "runtime/Parallel.hpp"
+#include "runtime/ThreadPool.hpp"
+#include "runtime/Topology.hpp"
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// A pair of ~100 KB documents differing in every 7th leaf.
+struct Inputs {
+    fs::path dir, ours, golden;
+
+    Inputs() {
+        dir = fs::temp_directory_path() / "spf_bench_affinity";
+        fs::create_directories(dir);
+        ours = dir / "ours.json";
+        golden = dir / "golden.json";
+        std::ofstream a(ours), b(golden);
+        a << "{\"items\":[";
+        b << "{\"items\":[";
+        for (int i = 0; i < 2000; ++i) {
+            const char* sep = i ? "," : "";
+            a << sep << "{\"id\":" << i << ",\"name\":\"item-" << i << "\",\"v\":" << i * 3 << "}";
+            b << sep << "{\"id\":" << i << ",\"name\":\"item-" << i << "\",\"v\":" << (i % 7 ? i * 3 : -i) << "}";
+        }
+        a << "]}";
+        b << "]}";
+    }
+    ~Inputs() {
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+    }
+};
+
+std::shared_ptr<core::IComparator> comparator() {
+    static bool loaded = bench::loadPlugin("json_compare");
+    if (!loaded) return nullptr;
+    return core::PluginManager::instance().createTyped<core::IComparator>("default_json_compare");
+}
+
+// range(0): 0 = unpinned, 1 = pinned per core, 2 = per node + NUMA queues
+void BM_JsonCompareParallel(benchmark::State& state) {
+    static Inputs inputs;
+    auto cmp = comparator();
+    if (!cmp) { state.SkipWithError("json_compare plugin not built"); return; }
+
+    rt::PoolOptions opts;
+    opts.threads = rt::CpuTopology::system().cpuCount();
+    switch (state.range(0)) {
+    case 1: opts.affinity = rt::Affinity::Core; break;
+    case 2: opts.affinity = rt::Affinity::Node; opts.numaAware = true; break;
+    default: break;
+    }
+    rt::ThreadPool pool(opts);
+    const size_t jobs = pool.size() * 4;
+
+    std::atomic<bool> failed{false};
+    for (auto _ : state) {
+        rt::parallel_for(pool, 0, jobs, [&](size_t i) {
+            const auto report = inputs.dir / ("report-" + std::to_string(i) + ".html");
+            if (!cmp->compareFiles(inputs.ours.string(), inputs.golden.string(), report.string()))
+                failed = true;
+        }, 1);
+    }
+    if (failed) state.SkipWithError("compareFiles failed");
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(jobs));
+    state.counters["nodes"] = static_cast<double>(rt::CpuTopology::system().nodes.size());
+    state.counters["shards"] = static_cast<double>(pool.shardCount());
+}
+
+} // namespace
+
+BENCHMARK(BM_JsonCompareParallel)->Arg(0)->Arg(1)->Arg(2)->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,98 @@
+// Helpers shared by the benchmark files: plugin paths, quiet stdout,
+// generated JSON documents and the size ladder for document benchmarks.
+#pragma once
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <streambuf>
+#include <string>
+
+#include "core/PluginManager.hpp"
+
+namespace bench {
+
+namespace fs = std::filesystem;
+
+inline std::string pluginFile(const std::string& name) {
+#if defined(_WIN32)
+    return std::string(SPF_PLUGIN_DIR) + "/" + name + ".dll";
+#elif defined(__APPLE__)
+    return std::string(SPF_PLUGIN_DIR) + "/lib" + name + ".dylib";
+#else
+    return std::string(SPF_PLUGIN_DIR) + "/lib" + name + ".so";
+#endif
+}
+
+// The plugins log every call to std::cout; keep that out of the results.
+class QuietStdout {
+public:
+    QuietStdout() : old_(std::cout.rdbuf(&null_)) {}
+    ~QuietStdout() { std::cout.rdbuf(old_); }
+    QuietStdout(const QuietStdout&) = delete;
+    QuietStdout& operator=(const QuietStdout&) = delete;
+
+private:
+    struct NullBuf : std::streambuf {
+        int overflow(int c) override { return traits_type::not_eof(c); }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    } null_;
+    std::streambuf* old_;
+};
+
+// Loads plugin `name` into PluginManager::instance() once per process.
+inline bool loadPlugin(const std::string& name) {
+    QuietStdout quiet;
+    return core::PluginManager::instance().loadPlugin(pluginFile(name));
+}
+
+// A JSON object of roughly `bytes` bytes:
+//   {"meta":{...},"items":[{"id":0,"name":"item-0","tags":["a","b"],"attrs":{"v":0,"w":1.5}}, ...]}
+// `divergeEvery` > 0 changes attrs.v of every n-th item, for compare
+// benchmarks against the undiverged document.
+inline std::string makeDocument(size_t bytes, int divergeEvery = 0) {
+    std::string out;
+    out.reserve(bytes + 256);
+    out += R"({"meta":{"version":3,"generator":"bench","nested":{"a":{"b":{"c":42}}}},"items":[)";
+    for (int64_t i = 0; out.size() < bytes; ++i) {
+        const int64_t v = divergeEvery > 0 && i % divergeEvery == 0 ? -i : i;
+        if (i) out += ',';
+        out += R"({"id":)" + std::to_string(i) + R"(,"name":"item-)" + std::to_string(i) +
+               R"(","tags":["a","b"],"attrs":{"v":)" + std::to_string(v) + R"(,"w":1.5}})";
+    }
+    out += "]}";
+    return out;
+}
+
+// Document sizes for the 1 KB .. 1 GB ladder. Sizes above
+// SPF_BENCH_MAX_BYTES (default 32 MB) are left out so a default run stays
+// short; set it to 1073741824 to include the 1 GB case.
+inline int64_t maxDocumentBytes() {
+    if (const char* env = std::getenv("SPF_BENCH_MAX_BYTES")) {
+        const long long v = std::atoll(env);
+        if (v > 0) return v;
+    }
+    return int64_t(32) << 20;
+}
+
+inline void documentSizes(benchmark::internal::Benchmark* b) {
+    for (int64_t bytes = 1 << 10; bytes <= (int64_t(1) << 30); bytes *= 32) {
+        if (bytes <= maxDocumentBytes()) b->Arg(bytes);
+    }
+}
+
+// Scratch directory removed at exit.
+struct TempDir {
+    fs::path path;
+    explicit TempDir(const std::string& name) : path(fs::temp_directory_path() / name) {
+        fs::create_directories(path);
+    }
+    ~TempDir() {
+        std::error_code ec;
+        fs::remove_all(path, ec);
+    }
+};
+
+} // namespace bench
@@ -0,0 +1,84 @@
+// wf::Executor::run over synthetic DAGs of no-op tasks: scheduling and
+// event overhead per node for the shapes real workflows take.
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <string>
+
+#include "runtime/EventBus.hpp"
+#include "runtime/Services.hpp"
+#include "runtime/ThreadPool.hpp"
+#include "workflow/Executor.hpp"
+
+namespace {
+
+class NoopTask : public wf::ITask {
+public:
+    explicit NoopTask(std::string id) : id_(std::move(id)) {}
+    std::string id() const override { return id_; }
+    wf::TaskResult run(wf::ITaskContext&) override {
+        int x = 0;
+        for (int i = 0; i < 256; ++i) benchmark::DoNotOptimize(x += i);
+        return {};
+    }
+
+private:
+    std::string id_;
+};
+
+enum Shape { Chain = 0, FanOutIn = 1, Layered = 2 };
+
+// Chain: n nodes in a line. FanOutIn: one root, n-2 parallel nodes, one
+// sink. Layered: layers of 16 where every node depends on up to 3 random
+// nodes of the previous layer (fixed seed).
+wf::WorkflowSpec makeDag(Shape shape, int n) {
+    wf::WorkflowSpec spec;
+    for (int i = 0; i < n; ++i) spec.tasks.push_back(std::make_shared<NoopTask>("n" + std::to_string(i)));
+    auto edge = [&](int a, int b) { spec.edges.push_back({"n" + std::to_string(a), "n" + std::to_string(b)}); };
+    switch (shape) {
+    case Chain:
+        for (int i = 1; i < n; ++i) edge(i - 1, i);
+        break;
+    case FanOutIn:
+        for (int i = 1; i < n - 1; ++i) { edge(0, i); edge(i, n - 1); }
+        break;
+    case Layered: {
+        constexpr int kWidth = 16;
+        std::mt19937 rng(42);
+        for (int i = kWidth; i < n; ++i) {
+            const int prevStart = (i / kWidth - 1) * kWidth;
+            for (int k = 0; k < 3; ++k) edge(prevStart + static_cast<int>(rng() % kWidth), i);
+        }
+        break;
+    }
+    }
+    return spec;
+}
+
+// range(0): shape, range(1): node count
+void BM_ExecutorRun(benchmark::State& state) {
+    const auto spec = makeDag(static_cast<Shape>(state.range(0)), static_cast<int>(state.range(1)));
+    rt::EventBus bus;
+    rt::ThreadPool pool(std::thread::hardware_concurrency());
+    rt::StdLogger logger;
+    rt::SteadyClock clock;
+    rt::LocalFS fs;
+    wf::Executor exec(bus, pool);
+    for (auto _ : state) {
+        wf::SimpleContext ctx(logger, clock, fs);
+        if (!exec.run(spec, ctx)) {
+            state.SkipWithError("run failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+
+} // namespace
+
+BENCHMARK(BM_ExecutorRun)
+    ->ArgNames({"shape", "nodes"})
+    ->ArgsProduct({{Chain, FanOutIn, Layered}, {64, 1024, 8192}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,56 @@
+// DOM allocation cost: parsing generated documents into a heap
+// ordered_json versus an ArenaJson under a JsonArena::Scope, the layout the
+// JSON plugins use. Global operator new is replaced to count calls per
+// thread; the "allocs" counter is per parse (build + destroy).
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "bench_common.hpp"
+#include "core/JsonArena.hpp"
+
+namespace {
+thread_local size_t g_newCalls = 0;
+} // namespace
+
+void* operator new(size_t size) {
+    ++g_newCalls;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+// range(0): document size, range(1): 0 = heap ordered_json, 1 = ArenaJson
+void BM_JsonParseAlloc(benchmark::State& state) {
+    const std::string doc = bench::makeDocument(static_cast<size_t>(state.range(0)));
+    const bool arena = state.range(1) != 0;
+    state.SetLabel(arena ? "arena" : "heap");
+
+    const size_t before = g_newCalls;
+    for (auto _ : state) {
+        if (arena) {
+            core::JsonArena pool;
+            core::JsonArena::Scope scope(&pool);
+            auto value = core::ArenaJson::parse(doc);
+            benchmark::DoNotOptimize(value.size());
+        } else {
+            auto value = nlohmann::ordered_json::parse(doc);
+            benchmark::DoNotOptimize(value.size());
+        }
+    }
+    state.counters["allocs"] = benchmark::Counter(static_cast<double>(g_newCalls - before),
+                                                  benchmark::Counter::kAvgIterations);
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(doc.size()));
+}
+
+} // namespace
+
+BENCHMARK(BM_JsonParseAlloc)->ArgsProduct({{64 << 10, 1 << 20, 16 << 20}, {0, 1}})->Unit(benchmark::kMillisecond);
+// Concurrent parses contend on malloc's shared state; the arena variant only
+// takes it once per chunk.
+BENCHMARK(BM_JsonParseAlloc)->Args({1 << 20, 0})->Args({1 << 20, 1})->ThreadRange(1, 8)->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,38 @@
+// The legacy pool in threadpool/threadpool.h (bounded MPMC queue, futures
+// via packaged_task) on the same flat workload as bench_threadpool.cpp.
+#include <benchmark/benchmark.h>
+
+#include <future>
+#include <vector>
+
+#include "threadpool/threadpool.h"
+
+namespace {
+
+constexpr int kTasks = 10000;
+
+// range(0): threads, range(1): 0 = fixed, 1 = cached mode
+void BM_LegacySubmit(benchmark::State& state) {
+    ::ThreadPool pool;
+    if (state.range(1)) pool.setMode(PoolMode::MODE_CACHED);
+    pool.start(static_cast<int>(state.range(0)));
+    std::vector<std::future<int>> results;
+    results.reserve(kTasks);
+    for (auto _ : state) {
+        results.clear();
+        for (int i = 0; i < kTasks; ++i) {
+            // a full queue blocks here (backpressure) rather than failing
+            results.push_back(pool.submitTaskFor(std::chrono::seconds(10), [](int v) {
+                int x = 0;
+                for (int k = 0; k < 64; ++k) benchmark::DoNotOptimize(x += k);
+                return v;
+            }, i));
+        }
+        for (auto& r : results) benchmark::DoNotOptimize(r.get());
+    }
+    state.SetItemsProcessed(state.iterations() * kTasks);
+}
+
+} // namespace
+
+BENCHMARK(BM_LegacySubmit)->ArgNames({"threads", "cached"})->ArgsProduct({{1, 2, 4, 8}, {0, 1}})->UseRealTime();
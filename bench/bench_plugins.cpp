@@ -0,0 +1,369 @@
+// Plugin hot paths: PluginManager factory lookup, JsonProcess find/add over
+// generated documents (1 KB .. 1 GB, see bench::documentSizes), find,
+// JSONPath queries and batched finds on a parsed document handle, file
+// input through a memory map, binary input formats, JsonComparator over
+// identical and divergent trees, key lookups in wide objects, and JSON
+// Lines files processed on a thread pool.
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "core/IComparator.hpp"
+#include "core/IJsonProcess.hpp"
+#include "core/JsonArena.hpp"
+#include "core/JsonCodec.hpp"
+#include "core/PluginManager.hpp"
+#include "gen/Generator.hpp"
+#include "runtime/ThreadPool.hpp"
+
+namespace {
+
+std::shared_ptr<core::IJsonProcess> jsonProcess() {
+    static bool loaded = bench::loadPlugin("json_process");
+    if (!loaded) return nullptr;
+    return core::PluginManager::instance().createTyped<core::IJsonProcess>("default_json_process");
+}
+
+std::shared_ptr<core::IComparator> jsonCompare() {
+    static bool loaded = bench::loadPlugin("json_compare");
+    if (!loaded) return nullptr;
+    return core::PluginManager::instance().createTyped<core::IComparator>("default_json_compare");
+}
+
+// range(0): 0 = typed hit, 1 = typed miss (unknown name), 2 = by clsid
+void BM_PluginCreate(benchmark::State& state) {
+    if (!jsonProcess()) { state.SkipWithError("json_process plugin not built"); return; }
+    auto& pm = core::PluginManager::instance();
+    switch (state.range(0)) {
+    case 0:
+        for (auto _ : state) benchmark::DoNotOptimize(pm.createTyped<core::IJsonProcess>("default_json_process"));
+        break;
+    case 1:
+        for (auto _ : state) benchmark::DoNotOptimize(pm.createTyped<core::IJsonProcess>("no_such_process"));
+        break;
+    default:
+        for (auto _ : state) benchmark::DoNotOptimize(pm.create("clsidJsonProcess"));
+        break;
+    }
+}
+
+void BM_JsonProcessFind(benchmark::State& state) {
+    auto proc = jsonProcess();
+    if (!proc) { state.SkipWithError("json_process plugin not built"); return; }
+    const std::string doc = bench::makeDocument(static_cast<size_t>(state.range(0)));
+    bench::QuietStdout quiet;
+    std::string out;
+    for (auto _ : state) {
+        if (!proc->processJsonFiles(doc, out, "items/attrs/v", "find")) {
+            state.SkipWithError("find failed");
+            break;
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(doc.size()));
+}
+
+// Same query on a document parsed once: traversal and report cost only.
+void BM_JsonDocumentFind(benchmark::State& state) {
+    auto proc = jsonProcess();
+    if (!proc) { state.SkipWithError("json_process plugin not built"); return; }
+    const std::string doc = bench::makeDocument(static_cast<size_t>(state.range(0)));
+    bench::QuietStdout quiet;
+    auto handle = proc->parseDocument(doc);
+    std::string out;
+    for (auto _ : state) {
+        if (!handle || !handle->find("items/attrs/v", out)) {
+            state.SkipWithError("find failed");
+            break;
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(doc.size()));
+}
+
+// Compiled JSONPath against the path walker above (BM_JsonDocumentFind runs
+// the equivalent `items/attrs/v`). range(1): 0 = plain path, 1 = with a
+// filter predicate, 2 = recursive descent.
+void BM_JsonQuery(benchmark::State& state) {
+    auto proc = jsonProcess();
+    if (!proc) { state.SkipWithError("json_process plugin not built"); return; }
+    const std::string doc = bench::makeDocument(static_cast<size_t>(state.range(0)));
+    const char* exprs[] = {"$.items[*].attrs.v", "$.items[?(@.attrs.v > 100 && @.name != 'x')].attrs.v", "$..v"};
+    const std::string expr = exprs[state.range(1)];
+    bench::QuietStdout quiet;
+    auto handle = proc->parseDocument(doc);
+    std::string out;
+    for (auto _ : state) {
+        if (!handle || !handle->query(expr, out)) {
+            state.SkipWithError("query failed");
+            break;
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(doc.size()));
+}
+
+void queryArgs(benchmark::internal::Benchmark* b) {
+    for (int64_t bytes = 1 << 10; bytes <= (int64_t(1) << 30); bytes *= 32) {
+        if (bytes > bench::maxDocumentBytes()) break;
+        for (int64_t kind = 0; kind < 3; ++kind) b->Args({bytes, kind});
+    }
+}
+
+// range(0): document size, range(1): number of paths in one findBatch call
+void BM_JsonFindBatch(benchmark::State& state) {
+    auto proc = jsonProcess();
+    if (!proc) { state.SkipWithError("json_process plugin not built"); return; }
+    const std::string doc = bench::makeDocument(static_cast<size_t>(state.range(0)));
+    const char* real[] = {"items/attrs/v", "items/attrs/w", "items/id", "items/name", "items/tags", "meta/nested/a/b"};
+    std::vector<std::string> paths;
+    for (int64_t i = 0; i < state.range(1); ++i)
+        paths.push_back(i < 6 ? real[i] : "items/attrs/f" + std::to_string(i));
+    bench::QuietStdout quiet;
+    std::string out;
+    for (auto _ : state) {
+        if (!proc->findBatch(doc, paths, out)) {
+            state.SkipWithError("findBatch failed");
+            break;
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(doc.size()));
+}
+
+void BM_JsonProcessAdd(benchmark::State& state) {
+    auto proc = jsonProcess();
+    if (!proc) { state.SkipWithError("json_process plugin not built"); return; }
+    const std::string doc = bench::makeDocument(static_cast<size_t>(state.range(0)));
+    bench::QuietStdout quiet;
+    std::string out;
+    for (auto _ : state) {
+        if (!proc->processJsonFiles(doc, out, "archive/v1|meta/nested", "add")) {
+            state.SkipWithError("add failed");
+            break;
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(doc.size()));
+}
+
+// One-shot find on a file. range(1): 0 = ifstream -> ostringstream ->
+// string as main.cpp used to, 1 = processJsonFile on a memory map,
+// 2 = the same with the report streamed into an output file.
+void BM_JsonProcessFile(benchmark::State& state) {
+    auto proc = jsonProcess();
+    if (!proc) { state.SkipWithError("json_process plugin not built"); return; }
+    static bench::TempDir dir("spf_bench_process_file");
+    const auto bytes = static_cast<size_t>(state.range(0));
+    const auto path = dir.path / ("doc-" + std::to_string(bytes) + ".json");
+    if (!bench::fs::exists(path)) std::ofstream(path, std::ios::binary) << bench::makeDocument(bytes);
+
+    bench::QuietStdout quiet;
+    std::string out;
+    for (auto _ : state) {
+        bool ok;
+        if (state.range(1) == 0) {
+            std::ifstream in(path);
+            std::ostringstream buffer;
+            buffer << in.rdbuf();
+            ok = proc->processJsonFiles(buffer.str(), out, "items/attrs/v", "find");
+        } else if (state.range(1) == 1) {
+            ok = proc->processJsonFile(path.string(), out, "items/attrs/v", "find");
+        } else {
+            std::ofstream report(dir.path / "report.json", std::ios::binary);
+            ok = proc->processJsonFile(path.string(), report, "items/attrs/v", "find");
+        }
+        if (!ok) {
+            state.SkipWithError("find failed");
+            break;
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(bytes));
+}
+
+void fileArgs(benchmark::internal::Benchmark* b) {
+    for (int64_t bytes = 1 << 10; bytes <= (int64_t(1) << 30); bytes *= 32) {
+        if (bytes > bench::maxDocumentBytes()) break;
+        b->Args({bytes, 0});
+        b->Args({bytes, 1});
+        b->Args({bytes, 2});
+    }
+}
+
+// One-shot find on the same document encoded as range(1): 0 = JSON text,
+// 1 = CBOR, 2 = MessagePack, 3 = UBJSON, 4 = BSON (detected, not declared).
+void BM_JsonProcessFormat(benchmark::State& state) {
+    auto proc = jsonProcess();
+    if (!proc) { state.SkipWithError("json_process plugin not built"); return; }
+    static const core::JsonFormat formats[] = {core::JsonFormat::Json, core::JsonFormat::Cbor,
+                                               core::JsonFormat::MsgPack, core::JsonFormat::Ubjson,
+                                               core::JsonFormat::Bson};
+    const auto format = formats[state.range(1)];
+    std::string doc = bench::makeDocument(static_cast<size_t>(state.range(0)));
+    if (format != core::JsonFormat::Json) {
+        std::ostringstream encoded;
+        core::encodeJson(nlohmann::ordered_json::parse(doc), format, encoded);
+        doc = encoded.str();
+    }
+    state.SetLabel(core::formatName(format));
+
+    bench::QuietStdout quiet;
+    std::string out;
+    for (auto _ : state) {
+        if (!proc->processJsonFiles(doc, out, "items/attrs/v", "find")) {
+            state.SkipWithError("find failed");
+            break;
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(doc.size()));
+}
+
+// range(0): document size, range(1): 0 = identical trees, 1 = every 7th item differs
+void BM_JsonCompare(benchmark::State& state) {
+    auto cmp = jsonCompare();
+    if (!cmp) { state.SkipWithError("json_compare plugin not built"); return; }
+    static bench::TempDir dir("spf_bench_compare");
+    const auto bytes = static_cast<size_t>(state.range(0));
+    const auto ours = dir.path / ("ours-" + std::to_string(bytes) + ".json");
+    const auto golden = dir.path / ("golden-" + std::to_string(bytes) + "-" + std::to_string(state.range(1)) + ".json");
+    const auto report = dir.path / "report.html";
+    std::ofstream(ours, std::ios::binary) << bench::makeDocument(bytes);
+    std::ofstream(golden, std::ios::binary) << bench::makeDocument(bytes, state.range(1) ? 7 : 0);
+
+    bench::QuietStdout quiet;
+    for (auto _ : state) {
+        if (!cmp->compareFiles(ours.string(), golden.string(), report.string())) {
+            state.SkipWithError("compareFiles failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(2 * bytes));
+}
+
+// {"k0":0,"k1":1,...} with `keys` members, inserted in a scrambled order.
+std::string makeWideObject(int64_t keys) {
+    std::string doc = "{";
+    for (int64_t i = 0; i < keys; ++i) {
+        if (i) doc += ',';
+        doc += "\"k" + std::to_string((i * 7919) % keys) + "\":" + std::to_string(i);
+    }
+    return doc + "}";
+}
+
+// range(0): keys, range(1): 0 = ordered_json (linear ordered_map), 1 = the
+// plugins' ArenaJson (IndexedOrderedMap). Parse, then look every key up.
+void BM_JsonWideObject(benchmark::State& state) {
+    const int64_t keys = state.range(0);
+    const std::string doc = makeWideObject(keys);
+    std::vector<std::string> names;
+    for (int64_t i = 0; i < keys; ++i) names.push_back("k" + std::to_string(i));
+    state.SetLabel(state.range(1) ? "indexed" : "ordered_map");
+
+    auto run = [&](auto tag) {
+        using Json = decltype(tag);
+        for (auto _ : state) {
+            const auto value = Json::parse(doc);
+            int64_t sum = 0;
+            for (const auto& name : names) sum += value.at(name).template get<int64_t>();
+            benchmark::DoNotOptimize(sum);
+        }
+    };
+    if (state.range(1)) run(core::ArenaJson());
+    else run(nlohmann::ordered_json());
+}
+
+// Two wide objects differing in every 7th value, through the plugin.
+void BM_JsonCompareWide(benchmark::State& state) {
+    auto cmp = jsonCompare();
+    if (!cmp) { state.SkipWithError("json_compare plugin not built"); return; }
+    static bench::TempDir dir("spf_bench_compare_wide");
+    const int64_t keys = state.range(0);
+    const auto ours = dir.path / ("ours-" + std::to_string(keys) + ".json");
+    const auto golden = dir.path / ("golden-" + std::to_string(keys) + ".json");
+    const auto report = dir.path / "report.html";
+    const std::string doc = makeWideObject(keys);
+    std::ofstream(ours, std::ios::binary) << doc;
+    auto other = nlohmann::ordered_json::parse(doc);
+    for (int64_t i = 0; i < keys; i += 7) other["k" + std::to_string(i)] = -1;
+    std::ofstream(golden, std::ios::binary) << other.dump();
+
+    bench::QuietStdout quiet;
+    for (auto _ : state) {
+        if (!cmp->compareFiles(ours.string(), golden.string(), report.string())) {
+            state.SkipWithError("compareFiles failed");
+            break;
+        }
+    }
+}
+
+// Discards what is written, as a fast output device would.
+struct NullBuf : std::streambuf {
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+// range(0): parallelism, range(1): 1 = ordered, 0 = unordered. A 64 MB
+// NDJSON file of generated items (smaller under SPF_BENCH_MAX_BYTES),
+// "find" of each record's id, batches on an rt::ThreadPool.
+void BM_JsonLines(benchmark::State& state) {
+    auto proc = jsonProcess();
+    if (!proc) { state.SkipWithError("json_process plugin not built"); return; }
+    static bench::TempDir dir("spf_bench_jsonl");
+    const auto path = dir.path / "records.jsonl";
+    static const uint64_t bytes = [&] {
+        gen::JsonSpec spec;
+        spec.targetBytes = static_cast<uint64_t>(std::min<int64_t>(64 << 20, bench::maxDocumentBytes()));
+        std::ofstream os(path, std::ios::binary);
+        return gen::writeNdjson(os, spec).bytes;
+    }();
+
+    const auto parallelism = static_cast<size_t>(state.range(0));
+    rt::ThreadPool pool(parallelism);
+    proc->setExecutor([&pool](std::function<void()> task) { pool.post(std::move(task)); });
+    core::JsonLinesOptions options;
+    options.parallelism = parallelism;
+    options.ordered = state.range(1) != 0;
+    state.SetLabel(options.ordered ? "ordered" : "unordered");
+
+    bench::QuietStdout quiet;
+    NullBuf discard;
+    std::ostream out(&discard);
+    for (auto _ : state) {
+        if (!proc->processJsonLines(path.string(), out, "id", "find", options)) {
+            state.SkipWithError("processJsonLines failed");
+            break;
+        }
+    }
+    proc->setExecutor(nullptr);
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(bytes));
+}
+
+void compareArgs(benchmark::internal::Benchmark* b) {
+    for (int64_t bytes = 1 << 10; bytes <= (int64_t(1) << 30); bytes *= 32) {
+        if (bytes > bench::maxDocumentBytes()) break;
+        b->Args({bytes, 0});
+        b->Args({bytes, 1});
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_PluginCreate)->Arg(0)->Arg(1)->Arg(2);
+BENCHMARK(BM_JsonProcessFind)->Apply(bench::documentSizes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JsonDocumentFind)->Apply(bench::documentSizes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JsonQuery)->Apply(queryArgs)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JsonFindBatch)->ArgsProduct({{1 << 20}, {1, 16, 200}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JsonProcessAdd)->Apply(bench::documentSizes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JsonProcessFile)->Apply(fileArgs)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JsonProcessFormat)->ArgsProduct({{1 << 20, 16 << 20}, {0, 1, 2, 3, 4}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JsonCompare)->Apply(compareArgs)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JsonWideObject)->ArgsProduct({{1000, 10000}, {0, 1}})->Args({50000, 1})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JsonCompareWide)->Arg(1000)->Arg(10000)->Arg(50000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JsonLines)->ArgsProduct({{1, 2, 4, 8}, {1, 0}})->UseRealTime()->Unit(benchmark::kMillisecond);
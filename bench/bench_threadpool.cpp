@@ -0,0 +1,85 @@
+// Scaling of tp::ThreadPool (work stealing) vs rt::ThreadPool (one lock over
+// priority lanes) on fine-grained tasks.
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <thread>
+
+#include "runtime/ThreadPool.hpp"
+#include "threadpool/ThreadPool.hpp"
+
+namespace {
+
+constexpr int kTasks = 10000;
+
+inline void tinyWork(int n) {
+    int x = 0;
+    for (int i = 0; i < n; ++i) benchmark::DoNotOptimize(x += i);
+}
+
+void waitFor(const std::atomic<int>& done, int target) {
+    while (done.load(std::memory_order_acquire) < target) std::this_thread::yield();
+}
+
+// Flat: the caller submits kTasks independent tiny tasks.
+template<class Pool>
+void BM_FlatSubmit(benchmark::State& state) {
+    Pool pool(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        std::atomic<int> done{0};
+        for (int i = 0; i < kTasks; ++i) {
+            pool.submit([&done]{ tinyWork(64); done.fetch_add(1, std::memory_order_release); });
+        }
+        waitFor(done, kTasks);
+    }
+    state.SetItemsProcessed(state.iterations() * kTasks);
+}
+
+// Flat, fire-and-forget: rt::ThreadPool::post() skips the future entirely.
+void BM_FlatPost(benchmark::State& state) {
+    rt::ThreadPool pool(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        std::atomic<int> done{0};
+        for (int i = 0; i < kTasks; ++i) {
+            pool.post([&done]{ tinyWork(64); done.fetch_add(1, std::memory_order_release); });
+        }
+        waitFor(done, kTasks);
+    }
+    state.SetItemsProcessed(state.iterations() * kTasks);
+}
+
+// Recursive: every task spawns two children until a depth limit, so most
+// submissions originate on worker threads (fork/join shape).
+template<class Pool>
+void spawnTree(Pool& pool, std::atomic<int>& done, int depth) {
+    tinyWork(64);
+    if (depth > 0) {
+        pool.submit([&pool, &done, depth]{ spawnTree(pool, done, depth - 1); });
+        pool.submit([&pool, &done, depth]{ spawnTree(pool, done, depth - 1); });
+    }
+    done.fetch_add(1, std::memory_order_release);
+}
+
+template<class Pool>
+void BM_RecursiveSpawn(benchmark::State& state) {
+    Pool pool(static_cast<size_t>(state.range(0)));
+    constexpr int kDepth = 12;
+    constexpr int kNodes = (1 << (kDepth + 1)) - 1;
+    for (auto _ : state) {
+        std::atomic<int> done{0};
+        pool.submit([&pool, &done]{ spawnTree(pool, done, kDepth); });
+        waitFor(done, kNodes);
+    }
+    state.SetItemsProcessed(state.iterations() * kNodes);
+    const auto total = pool.metrics().total();
+    state.counters["steals"] = benchmark::Counter(static_cast<double>(total.steals), benchmark::Counter::kAvgIterations);
+    state.counters["parks"] = benchmark::Counter(static_cast<double>(total.parks), benchmark::Counter::kAvgIterations);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_FlatSubmit, rt::ThreadPool)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_FlatSubmit, tp::ThreadPool)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK(BM_FlatPost)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_RecursiveSpawn, rt::ThreadPool)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_RecursiveSpawn, tp::ThreadPool)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
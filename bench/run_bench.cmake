@@ -0,0 +1,26 @@
+# 由 bench_json 目标调用：cmake -DBENCH=... -DOUT_DIR=... -DSOURCE_DIR=... [-DFILTER=...] -P run_bench.cmake
+# 结果文件名取当前提交（工作区有改动时加 -dirty），同时复制一份 latest.json
+execute_process(
+  COMMAND git describe --always --dirty
+  WORKING_DIRECTORY ${SOURCE_DIR}
+  OUTPUT_VARIABLE commit
+  OUTPUT_STRIP_TRAILING_WHITESPACE
+  ERROR_QUIET
+)
+if (NOT commit)
+  set(commit "unknown")
+endif()
+
+file(MAKE_DIRECTORY ${OUT_DIR})
+set(out "${OUT_DIR}/${commit}.json")
+set(args --benchmark_out=${out} --benchmark_out_format=json)
+if (FILTER)
+  list(APPEND args --benchmark_filter=${FILTER})
+endif()
+
+execute_process(COMMAND ${BENCH} ${args} RESULT_VARIABLE rc)
+if (NOT rc EQUAL 0)
+  message(FATAL_ERROR "bench failed (${rc})")
+endif()
+configure_file(${out} ${OUT_DIR}/latest.json COPYONLY)
+message(STATUS "benchmark results: ${out}")
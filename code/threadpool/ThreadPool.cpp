@@ -1,63 +1,80 @@
 #include "../../include/threadpool/ThreadPool.hpp"
-#include <stdexcept>
-#include <utility>
-#include <algorithm>
 #include <chrono>
 
 namespace tp {
 
+namespace {
+
+// Which pool/worker the current thread belongs to (set by workerLoop).
+thread_local const ThreadPool* tlsPool = nullptr;
+thread_local int tlsIndex = -1;
+
+inline std::uint64_t xorshift(std::uint64_t& s) {
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    return s;
+}
+
+constexpr int kSpinRounds = 64;
+
+inline std::uint64_t nanos(std::chrono::steady_clock::duration d) {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+}
+
+} // namespace
+
 ThreadPool::ThreadPool(size_t threads) {
+    start(threads);
+}
+
+ThreadPool::~ThreadPool() {
+    shutdown();
+}
+
+void ThreadPool::start(size_t threads) {
     if (threads == 0) {
         threads = std::thread::hardware_concurrency();
         if (threads == 0) threads = 2;
     }
+    stopping_.store(false, std::memory_order_release);
+    started_ = Clock::now();
+    externalCounters_.reset();
+    externalWait_.reset();
+    externalRun_.reset();
 
-    rng_.seed(static_cast<unsigned int>(std::chrono::high_resolution_clock::now().time_since_epoch().count()));
-    dist_ = std::uniform_int_distribution<size_t>(0, threads - 1);
-
-    deques_.resize(threads);
+    const auto seed = static_cast<std::uint64_t>(
+        std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    workers_.clear();
     workers_.reserve(threads);
     for (size_t i = 0; i < threads; ++i) {
-        workers_.emplace_back(std::bind(&ThreadPool::workerLoop, this, i));
+        auto w = std::make_unique<Worker>();
+        w->rng = (seed + 0x9E3779B97F4A7C15ull * (i + 1)) | 1;
+        workers_.push_back(std::move(w));
+    }
+    // Start threads only once every deque exists: thieves scan all of them.
+    for (size_t i = 0; i < threads; ++i) {
+        workers_[i]->thread = std::thread(&ThreadPool::workerLoop, this, i);
     }
-}
-
-ThreadPool::~ThreadPool() {
-    shutdown();
 }
 
 void ThreadPool::shutdown() {
-    bool expected = false;
-    if (!stopping_.compare_exchange_strong(expected, true)) return;
-    cond_.notify_all();
-    for (std::thread &t : workers_) if (t.joinable()) t.join();
-    workers_.clear();
+    {
+        // Set under injectMtx_: an outside submit either lands in inject_
+        // before this (and is drained) or sees the flag and throws.
+        std::lock_guard<std::mutex> g(injectMtx_);
+        bool expected = false;
+        if (!stopping_.compare_exchange_strong(expected, true)) return;
+    }
+    idle_.notifyAll();
+    for (auto& w : workers_) if (w->thread.joinable()) w->thread.join();
 }
 
 void ThreadPool::resize(size_t threads) {
-    // Simple resize: if increasing, add workers; if decreasing, set stopping and recreate
-    std::unique_lock<std::mutex> lk(mutex_);
-    if (threads == workers_.size()) return;
-    if (threads > workers_.size()) {
-        size_t old = workers_.size();
-        deques_.resize(threads);
-        for (size_t i = old; i < threads; ++i) {
-            workers_.emplace_back(std::bind(&ThreadPool::workerLoop, this, i));
-        }
-    } else {
-        // decreasing: signal all workers to stop and recreate smaller pool
-        lk.unlock();
-        shutdown();
-        // move remaining tasks to new deques
-        deques_.clear();
-        deques_.resize(threads);
-        stopping_ = false;
-        workers_.reserve(threads);
-        for (size_t i = 0; i < threads; ++i) {
-            workers_.emplace_back(std::bind(&ThreadPool::workerLoop, this, i));
-        }
-    }
-    dist_ = std::uniform_int_distribution<size_t>(0, workers_.size() - 1);
+    if (threads == workers_.size() && !stopping_.load()) return;
+    shutdown();
+    workers_.clear();
+    start(threads);
 }
 
 size_t ThreadPool::size() const {
@@ -65,12 +82,9 @@ size_t ThreadPool::size() const {
 }
 
 size_t ThreadPool::queueSize() const {
-    // Best-effort snapshot
-    size_t sum = 0;
-    for (size_t i = 0; i < deques_.size(); ++i) {
-        // no locking for perf; approximate
-        sum += deques_[i].size();
-    }
+    // Snapshot from atomic counters; exact only when the pool is quiescent.
+    size_t sum = injectSize_.load(std::memory_order_relaxed);
+    for (const auto& w : workers_) sum += w->deque.sizeApprox();
     return sum;
 }
 
@@ -78,95 +92,170 @@ uint64_t ThreadPool::completedTaskCount() const {
     return completedTasks_.load();
 }
 
-void ThreadPool::workerLoop(size_t id) {
-    while (!stopping_) {
-        std::function<void()> task;
-        // pop from own deque
-        {
-            std::unique_lock<std::mutex> lk(mutex_);
-            if (!deques_[id].empty()) {
-                task = std::move(deques_[id].front());
-                deques_[id].pop_front();
-            }
+rt::PoolMetrics ThreadPool::metrics() const {
+    rt::PoolMetrics m;
+    for (const auto& w : workers_) {
+        m.workers.push_back(w->counters.snapshot());
+        m.queueWait.merge(w->wait.snapshot());
+        m.runTime.merge(w->run.snapshot());
+    }
+    m.external = externalCounters_.snapshot();
+    m.queueWait.merge(externalWait_.snapshot());
+    m.runTime.merge(externalRun_.snapshot());
+    m.queued = queueSize();
+    m.uptimeNs = nanos(Clock::now() - started_);
+    return m;
+}
+
+int ThreadPool::currentWorker() const {
+    return tlsPool == this ? tlsIndex : -1;
+}
+
+void ThreadPool::enqueue(Task* task) {
+    task->queued = Clock::now();
+    const int self = currentWorker();
+    if (self >= 0) {
+        workers_[static_cast<size_t>(self)]->deque.push(task);
+    } else {
+        std::unique_lock<std::mutex> g(injectMtx_);
+        // acceptsWork() ran before the lock; shutdown() may have started since.
+        if (stopping_.load(std::memory_order_relaxed)) {
+            g.unlock();
+            delete task;
+            throw std::runtime_error("ThreadPool is stopping, cannot submit");
         }
-        if (!task) {
-            // attempt to steal from another worker
-            size_t n = deques_.size();
-            bool found = false;
-            for (size_t attempt = 0; attempt < n; ++attempt) {
-                size_t victim = (id + 1 + (rng_() % n)) % n;
-                if (victim == id) continue;
-                std::unique_lock<std::mutex> lk(mutex_);
-                if (!deques_[victim].empty()) {
-                    task = std::move(deques_[victim].back());
-                    deques_[victim].pop_back();
-                    found = true;
-                    break;
-                }
-            }
-            if (!found) {
-                // wait for work
-                std::unique_lock<std::mutex> lk(mutex_);
-                cond_.wait(lk, [this, id]{
-                    if (stopping_) return true;
-                    for (size_t i=0;i<deques_.size();++i) if (!deques_[i].empty()) return true;
-                    return false;
-                });
-                continue; // retry loop to pick up a task
-            }
+        inject_.push_back(task);
+        injectSize_.fetch_add(1, std::memory_order_release);
+    }
+    totalTasks_.fetch_add(1, std::memory_order_relaxed);
+    idle_.notifyOne();
+}
+
+// Scans the other workers' deques from a random start. `skip` is the
+// caller's own index (or workers_.size() for outside threads).
+ThreadPool::Task* ThreadPool::steal(std::uint64_t& rng, size_t skip) {
+    const size_t n = workers_.size();
+    Task* task = nullptr;
+    size_t start = static_cast<size_t>(xorshift(rng) % n);
+    for (size_t k = 0; k < n; ++k) {
+        size_t victim = (start + k) % n;
+        if (victim == skip) continue;
+        auto& dq = workers_[victim]->deque;
+        // A failed steal may just have lost a race; retry while items remain.
+        while (!dq.emptyApprox()) {
+            if (dq.steal(task)) return task;
         }
+    }
+    return nullptr;
+}
 
-        // execute task and forward exceptions to future (task should set packaged_task)
-        try {
-            task();
-        } catch (...) {
-            // exceptions should already be set in packaged_task -> future, so swallow here
+ThreadPool::Task* ThreadPool::findExternal() {
+    if (injectSize_.load(std::memory_order_acquire) > 0) {
+        std::lock_guard<std::mutex> g(injectMtx_);
+        if (!inject_.empty()) {
+            Task* task = inject_.front();
+            inject_.pop_front();
+            injectSize_.fetch_sub(1, std::memory_order_relaxed);
+            return task;
         }
-        completedTasks_.fetch_add(1);
     }
+    return nullptr;
 }
 
-template<class F, class... Args>
-auto ThreadPool::submit(F&& f, Args&&... args)
-    -> std::future<typename std::result_of<F(Args...)>::type>
-{
-    using R = typename std::result_of<F(Args...)>::type;
-    auto taskPtr = std::make_shared<std::packaged_task<R()>>(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
-    std::future<R> res = taskPtr->get_future();
+ThreadPool::Task* ThreadPool::findTask(size_t id) {
+    Worker& self = *workers_[id];
+    Task* task = nullptr;
+    if (self.deque.pop(task)) return task;
+    if ((task = findExternal())) return task;
+    if (workers_.size() < 2) return nullptr;
+    rt::WorkerCounters::bump(self.counters.stealAttempts);
+    task = steal(self.rng, id);
+    if (task) rt::WorkerCounters::bump(self.counters.steals);
+    return task;
+}
 
-    if (stopping_) throw std::runtime_error("ThreadPool is stopping, cannot submit");
+// `self` is the calling worker, or nullptr for outside threads. `start`
+// is the caller's current time; the returned end time lets a worker reuse
+// one clock read for the next task's start.
+ThreadPool::Clock::time_point ThreadPool::runTask(Task* task, Worker* self, Clock::time_point start) {
+    const std::uint64_t waited = nanos(start - task->queued);
+    // submit() captures exceptions in the packaged_task; post() drops them
+    try {
+        task->fn();
+    } catch (...) {
+    }
+    const auto end = Clock::now();
+    const std::uint64_t ran = nanos(end - start);
+    delete task;
+    if (self) {
+        rt::WorkerCounters::bump(self->counters.tasks);
+        rt::WorkerCounters::bump(self->counters.busyNs, ran);
+        self->wait.recordSerialized(waited);
+        self->run.recordSerialized(ran);
+    } else {
+        rt::WorkerCounters::add(externalCounters_.tasks);
+        rt::WorkerCounters::add(externalCounters_.busyNs, ran);
+        externalWait_.record(waited);
+        externalRun_.record(ran);
+    }
+    completedTasks_.fetch_add(1, std::memory_order_relaxed);
+    return end;
+}
 
-    // push to a random worker's deque
-    size_t idx = dist_(rng_);
-    {
-        std::unique_lock<std::mutex> lk(mutex_);
-        deques_[idx].push_back([taskPtr]{ (*taskPtr)(); });
-        totalTasks_.fetch_add(1);
+bool ThreadPool::tryRunOne() {
+    const int self = currentWorker();
+    Task* task = nullptr;
+    if (self >= 0) {
+        task = findTask(static_cast<size_t>(self));
+    } else if (!(task = findExternal()) && !workers_.empty()) {
+        thread_local std::uint64_t rng = 0x9E3779B97F4A7C15ull ^
+            reinterpret_cast<std::uintptr_t>(&rng);
+        rt::WorkerCounters::add(externalCounters_.stealAttempts);
+        task = steal(rng, workers_.size());
+        if (task) rt::WorkerCounters::add(externalCounters_.steals);
     }
-    cond_.notify_all();
-    return res;
+    if (!task) return false;
+    runTask(task, self >= 0 ? workers_[static_cast<size_t>(self)].get() : nullptr, Clock::now());
+    return true;
 }
 
-template<class F, class... Args>
-auto ThreadPool::try_submit(F&& f, Args&&... args)
-    -> Optional<std::future<typename std::result_of<F(Args...)>::type>>
-{
-    using R = typename std::result_of<F(Args...)>::type;
-    auto taskPtr = std::make_shared<std::packaged_task<R()>>(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
-    std::future<R> res = taskPtr->get_future();
+void ThreadPool::workerLoop(size_t id) {
+    tlsPool = this;
+    tlsIndex = static_cast<int>(id);
+    Worker& self = *workers_[id];
+    Clock::time_point now{};
+    bool fresh = false; // `now` is the end of the task just run
 
-    if (stopping_) return Optional<std::future<R>>();
+    for (;;) {
+        Task* task = findTask(id);
+        if (!task) fresh = false;
+        for (int spin = 0; !task && spin < kSpinRounds; ++spin) {
+            std::this_thread::yield();
+            task = findTask(id);
+        }
+        if (!task) {
+            auto key = idle_.prepareWait();
+            task = findTask(id);
+            if (task) {
+                idle_.cancelWait();
+            } else if (stopping_.load(std::memory_order_acquire)) {
+                // Queues are drained (we just re-checked after prepareWait).
+                idle_.cancelWait();
+                break;
+            } else {
+                rt::WorkerCounters::bump(self.counters.parks);
+                idle_.commitWait(key);
+                rt::WorkerCounters::bump(self.counters.unparks);
+                continue;
+            }
+        }
 
-    // best-effort push to a random worker without blocking
-    size_t idx = dist_(rng_);
-    {
-        std::unique_lock<std::mutex> lk(mutex_);
-        deques_[idx].push_back([taskPtr]{ (*taskPtr)(); });
-        totalTasks_.fetch_add(1);
+        now = runTask(task, &self, fresh ? now : Clock::now());
+        fresh = true;
     }
-    cond_.notify_all();
-    return Optional<std::future<R>>(std::move(res));
+
+    tlsPool = nullptr;
+    tlsIndex = -1;
 }
 
 } // namespace tp
-
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace gen {
+
+// Shape of a generated JSON document. The document is
+//   {"meta":{...},"items":[item, item, ...]}
+// where every item is an object tree `depth` levels deep: objects have
+// `fanout` members (capped at `keyCardinality`), arrays `arrayLen`
+// elements, and leaves are numbers with probability `numericRatio`,
+// strings otherwise. Items are appended until `targetBytes` have been
+// written, or `items` items when targetBytes is 0.
+struct JsonSpec {
+    int depth = 3;
+    int fanout = 4;
+    int arrayLen = 4;
+    int keyCardinality = 64;    // distinct key names ("k0".."k<n-1>")
+    double numericRatio = 0.5;
+    int stringLen = 12;
+    uint64_t targetBytes = 1 << 20;
+    uint64_t items = 0;
+    uint64_t seed = 1;
+};
+
+struct GenStats {
+    uint64_t bytes = 0;   // per output
+    uint64_t items = 0;   // items / records / tasks
+    uint64_t leaves = 0;
+    uint64_t diffs = 0;   // leaves that differ between a pair
+    uint64_t edges = 0;   // workflow dependencies
+};
+
+// Writes one document. Memory use does not depend on the size.
+GenStats writeJson(std::ostream& os, const JsonSpec& spec);
+
+// Writes two documents with the same structure whose leaves differ with
+// probability `diffRate` (0 = identical files). `a` equals what
+// writeJson() produces for the same spec.
+GenStats writeJsonPair(std::ostream& a, std::ostream& b, const JsonSpec& spec, double diffRate);
+
+// Writes items as NDJSON, one compact object per line, with the same
+// size rules as writeJson().
+GenStats writeNdjson(std::ostream& os, const JsonSpec& spec);
+
+enum class DagShape { Wide, Deep, Random };
+
+// Parses "wide" / "deep" / "random"; returns false for anything else.
+bool parseDagShape(const std::string& s, DagShape& out);
+
+// Shape of a generated workflow.json of legacy Shell tasks (params.cmd).
+// Wide: one root, tasks-2 parallel tasks, one sink. Deep: a chain.
+// Random: task i depends on up to `maxParents` distinct tasks among the
+// `window` before it.
+struct WorkflowGenSpec {
+    DagShape shape = DagShape::Wide;
+    uint64_t tasks = 16;
+    int maxParents = 3;
+    int window = 64;
+    std::string cmd = "true";
+    uint64_t seed = 1;
+};
+
+GenStats writeWorkflow(std::ostream& os, const WorkflowGenSpec& spec);
+
+} // namespace gen
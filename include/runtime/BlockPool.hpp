@@ -0,0 +1,126 @@
+#pragma once
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace rt {
+
+// Recycling allocator for small, short-lived, fixed-size blocks (future
+// shared states, continuation nodes). Freed blocks go to a per-thread cache
+// and overflow to a global list per size class, so steady-state
+// allocate/deallocate never reaches malloc.
+namespace detail {
+
+class BlockPool {
+public:
+    static constexpr std::size_t kClasses = 4; // 64, 128, 256, 512 bytes
+    static constexpr std::size_t kMaxBlock = std::size_t(64) << (kClasses - 1);
+
+    static int classOf(std::size_t bytes) {
+        std::size_t size = 64;
+        for (int c = 0; c < static_cast<int>(kClasses); ++c, size <<= 1) {
+            if (bytes <= size) return c;
+        }
+        return -1;
+    }
+
+    static void* allocate(std::size_t bytes) {
+        const int c = classOf(bytes);
+        if (c < 0) return ::operator new(bytes);
+        Cache& cache = localCache();
+        auto& list = cache.free[c];
+        if (list.empty()) global().refill(c, list);
+        if (list.empty()) return ::operator new(blockSize(c));
+        void* p = list.back();
+        list.pop_back();
+        return p;
+    }
+
+    static void deallocate(void* p, std::size_t bytes) noexcept {
+        const int c = classOf(bytes);
+        if (c < 0) { ::operator delete(p); return; }
+        Cache& cache = localCache();
+        auto& list = cache.free[c];
+        if (list.size() >= kCacheMax) global().spill(c, list, kCacheMax / 2);
+        list.push_back(p); // capacity reserved up front: cannot throw
+    }
+
+private:
+    static constexpr std::size_t kCacheMax = 256;
+
+    static std::size_t blockSize(int c) { return std::size_t(64) << c; }
+
+    struct Global {
+        std::mutex m;
+        std::vector<void*> free[kClasses];
+
+        void refill(int c, std::vector<void*>& out) {
+            std::lock_guard<std::mutex> g(m);
+            auto& src = free[c];
+            std::size_t n = src.size() < kCacheMax / 2 ? src.size() : kCacheMax / 2;
+            out.insert(out.end(), src.end() - static_cast<std::ptrdiff_t>(n), src.end());
+            src.resize(src.size() - n);
+        }
+        void spill(int c, std::vector<void*>& from, std::size_t n) noexcept {
+            std::lock_guard<std::mutex> g(m);
+            auto& dst = free[c];
+            try {
+                dst.insert(dst.end(), from.end() - static_cast<std::ptrdiff_t>(n), from.end());
+            } catch (...) {
+                for (std::size_t i = from.size() - n; i < from.size(); ++i) ::operator delete(from[i]);
+            }
+            from.resize(from.size() - n);
+        }
+        ~Global() {
+            for (auto& list : free) for (void* p : list) ::operator delete(p);
+        }
+    };
+
+    struct Cache {
+        std::vector<void*> free[kClasses];
+        Cache() { for (auto& list : free) list.reserve(kCacheMax + 1); }
+        ~Cache() {
+            Global& g = global();
+            for (int c = 0; c < static_cast<int>(kClasses); ++c) {
+                if (!free[c].empty()) g.spill(c, free[c], free[c].size());
+            }
+        }
+    };
+
+    static Global& global() {
+        static Global* g = new Global(); // never destroyed: thread caches may outlive statics
+        return *g;
+    }
+    static Cache& localCache() {
+        static thread_local Cache cache;
+        return cache;
+    }
+};
+
+} // namespace detail
+
+// std::allocator-compatible front end over detail::BlockPool, usable with
+// std::allocate_shared and std::promise(std::allocator_arg, ...).
+template<class T>
+struct PoolAllocator {
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+    template<class U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(detail::BlockPool::allocate(n * sizeof(T)));
+    }
+    void deallocate(T* p, std::size_t n) noexcept {
+        detail::BlockPool::deallocate(p, n * sizeof(T));
+    }
+
+    template<class U>
+    bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+    template<class U>
+    bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+};
+
+} // namespace rt
@@ -1,28 +1,256 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
-#include <vector>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace rt {
 
-struct Event {
-    std::string type; // e.g. task_started, task_finished
+// Every topic on the bus. The enum value doubles as the topic index, so
+// subscription lookup is an array access instead of a string compare.
+enum class EventKind : std::uint8_t {
+    WorkflowStarted = 0,
+    TaskQueued,
+    TaskStarted,
+    TaskFinished,
+    WorkflowFinished,
+    OutputChunk,
+    MetricSample,
+    Count
+};
+
+constexpr std::size_t kEventKindCount = static_cast<std::size_t>(EventKind::Count);
+
+inline const char* eventKindName(EventKind k) {
+    switch (k) {
+        case EventKind::WorkflowStarted:  return "WorkflowStarted";
+        case EventKind::TaskQueued:       return "TaskQueued";
+        case EventKind::TaskStarted:      return "TaskStarted";
+        case EventKind::TaskFinished:     return "TaskFinished";
+        case EventKind::WorkflowFinished: return "WorkflowFinished";
+        case EventKind::OutputChunk:      return "OutputChunk";
+        case EventKind::MetricSample:     return "MetricSample";
+        default:                          return "Unknown";
+    }
+}
+
+using EventClock = std::chrono::steady_clock;
+using EventTime = EventClock::time_point;
+
+// ===== Event payloads (one struct per topic) =====
+struct WorkflowStarted {
+    static constexpr EventKind kind = EventKind::WorkflowStarted;
+    std::size_t taskCount = 0;
+    EventTime ts;
+};
+
+struct TaskQueued {
+    static constexpr EventKind kind = EventKind::TaskQueued;
+    std::string id;
+    EventTime ts;
+};
+
+struct TaskStarted {
+    static constexpr EventKind kind = EventKind::TaskStarted;
+    std::string id;
+    EventTime ts;
+    int worker = -1; // pool worker index, -1 when not on a pool thread
+};
+
+struct TaskFinished {
+    static constexpr EventKind kind = EventKind::TaskFinished;
     std::string id;
+    EventTime ts;
+    int worker = -1;
     bool success = true;
     std::string message;
 };
 
+struct WorkflowFinished {
+    static constexpr EventKind kind = EventKind::WorkflowFinished;
+    EventTime ts;
+    bool success = true;
+};
+
+// High-frequency topics: producers should go through emit() so that the
+// payload is never built when nobody listens.
+// Text a task produced; the executor sends a successful task's message.
+struct OutputChunk {
+    static constexpr EventKind kind = EventKind::OutputChunk;
+    std::string id;
+    EventTime ts;
+    std::string data;
+};
+
+// Named numeric sample; the executor sends "task_ms" (run time) per task.
+struct MetricSample {
+    static constexpr EventKind kind = EventKind::MetricSample;
+    std::string name;
+    EventTime ts;
+    double value = 0.0;
+};
+
+// Topic-indexed publish/subscribe bus.
+// - subscribe<E>() registers a handler for exactly one payload type.
+// - publish()/emit() on a topic without subscribers is a single relaxed
+//   atomic load; emit() additionally skips constructing the payload.
+// - Handlers run synchronously on the publishing thread and may be
+//   added/removed concurrently with publishing (copy-on-write lists).
+// - unsubscribe() returns only once no other thread is still inside the
+//   removed handler, so its captures may be destroyed right after.
 class EventBus {
 public:
-    using Handler = std::function<void(const Event&)>;
+    using SubscriptionId = std::uint64_t;
+
+    EventBus() = default;
+    EventBus(const EventBus&) = delete;
+    EventBus& operator=(const EventBus&) = delete;
 
-    void subscribe(Handler h) { handlers_.push_back(std::move(h)); }
-    void publish(const Event& e) {
-        for (auto& h : handlers_) h(e);
+    template<class E, class F>
+    SubscriptionId subscribe(F&& handler);
+
+    // Remove a subscription from whatever topic holds it and wait for calls
+    // already running on other threads to return. Returns false if unknown.
+    bool unsubscribe(SubscriptionId id);
+
+    template<class E>
+    bool hasSubscribers() const noexcept {
+        return topic(E::kind).count.load(std::memory_order_relaxed) != 0;
     }
+
+    template<class E>
+    void publish(const E& e) const {
+        const Topic& t = topic(E::kind);
+        if (t.count.load(std::memory_order_relaxed) == 0) return;
+        auto slots = std::atomic_load_explicit(&t.slots, std::memory_order_acquire);
+        if (!slots) return;
+        for (const auto& s : *slots) call(*s.handler, &e);
+    }
+
+    // Construct and publish E{args...} only when the topic has subscribers.
+    template<class E, class... Args>
+    void emit(Args&&... args) const {
+        if (!hasSubscribers<E>()) return;
+        publish(E{std::forward<Args>(args)...});
+    }
+
 private:
-    std::vector<Handler> handlers_;
+    // Owned by the slot lists, so a publisher that still holds an old list
+    // keeps it alive even after unsubscribe() returned and the bus is gone.
+    struct Handler {
+        std::function<void(const void*)> fn;
+        std::atomic<int> running{0};
+        std::atomic<bool> removed{false};
+        std::mutex drainMtx; // unsubscribe() waiting for running calls
+        std::condition_variable drainCv;
+    };
+    struct Slot {
+        SubscriptionId id;
+        std::shared_ptr<Handler> handler;
+    };
+    using SlotList = std::vector<Slot>;
+
+    struct Topic {
+        std::atomic<std::size_t> count{0};
+        std::shared_ptr<const SlotList> slots;
+    };
+
+    const Topic& topic(EventKind k) const { return topics_[static_cast<std::size_t>(k)]; }
+    Topic& topic(EventKind k) { return topics_[static_cast<std::size_t>(k)]; }
+
+    // Handlers the calling thread is currently inside, innermost first.
+    struct Frame {
+        const Handler* handler;
+        const Frame* outer;
+    };
+    static const Frame*& topFrame() noexcept {
+        static thread_local const Frame* top = nullptr;
+        return top;
+    }
+
+    // Runs one handler unless it was removed; the seq_cst pair
+    // running++/removed-load here and removed-store/running-load in
+    // unsubscribe() guarantees that one side sees the other.
+    static void call(Handler& h, const void* e) {
+        if (h.removed.load()) return;
+        h.running.fetch_add(1);
+        struct Leave {
+            Handler& h;
+            Frame frame;
+            ~Leave() {
+                topFrame() = frame.outer;
+                h.running.fetch_sub(1);
+                if (h.removed.load()) {
+                    std::lock_guard<std::mutex> g(h.drainMtx);
+                    h.drainCv.notify_all();
+                }
+            }
+        } leave{h, Frame{&h, topFrame()}};
+        if (h.removed.load()) return;
+        topFrame() = &leave.frame;
+        h.fn(e);
+    }
+
+    std::array<Topic, kEventKindCount> topics_;
+    std::mutex writeMtx_; // serializes subscribe/unsubscribe
+    SubscriptionId nextId_ = 1;
 };
 
-} // namespace rt
+template<class E, class F>
+EventBus::SubscriptionId EventBus::subscribe(F&& handler) {
+    std::function<void(const E&)> typed(std::forward<F>(handler));
+    std::lock_guard<std::mutex> g(writeMtx_);
+    Topic& t = topic(E::kind);
+    auto cur = std::atomic_load_explicit(&t.slots, std::memory_order_acquire);
+    auto next = std::make_shared<SlotList>(cur ? *cur : SlotList{});
+    const SubscriptionId id = nextId_++;
+    auto h = std::make_shared<Handler>();
+    h->fn = [typed](const void* p) { typed(*static_cast<const E*>(p)); };
+    next->push_back(Slot{id, std::move(h)});
+    std::atomic_store_explicit(&t.slots, std::shared_ptr<const SlotList>(std::move(next)),
+                               std::memory_order_release);
+    t.count.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+inline bool EventBus::unsubscribe(SubscriptionId id) {
+    std::shared_ptr<Handler> removed;
+    {
+        std::lock_guard<std::mutex> g(writeMtx_);
+        for (auto& t : topics_) {
+            auto cur = std::atomic_load_explicit(&t.slots, std::memory_order_acquire);
+            if (!cur) continue;
+            for (size_t i = 0; i < cur->size() && !removed; ++i) {
+                if ((*cur)[i].id != id) continue;
+                removed = (*cur)[i].handler;
+                auto next = std::make_shared<SlotList>(*cur);
+                next->erase(next->begin() + static_cast<std::ptrdiff_t>(i));
+                std::atomic_store_explicit(&t.slots, std::shared_ptr<const SlotList>(std::move(next)),
+                                           std::memory_order_release);
+                t.count.fetch_sub(1, std::memory_order_relaxed);
+            }
+            if (removed) break;
+        }
+    }
+    if (!removed) return false;
 
+    // Publishers that loaded the old list may still be inside the handler.
+    // Calls further up this thread's own stack cannot be waited for.
+    removed->removed.store(true);
+    int self = 0;
+    for (const Frame* f = topFrame(); f; f = f->outer)
+        if (f->handler == removed.get()) ++self;
+    std::unique_lock<std::mutex> lk(removed->drainMtx);
+    removed->drainCv.wait(lk, [&] { return removed->running.load() <= self; });
+    return true;
+}
+
+} // namespace rt
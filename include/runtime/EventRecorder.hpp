@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "runtime/EventBus.hpp"
+#include "runtime/MappedFile.hpp"
+
+namespace rt {
+
+// ===== Binary event log =====
+// Segment file layout:
+//   header : "SPFEVT01" (8 bytes) + base timestamp, u64 little-endian ns
+//   record : varint bodyLen | u8 kind | zigzag varint ts delta (ns, vs the
+//            previous record of the segment) | kind-specific fields
+// Fields use varints for integers, varint-length-prefixed bytes for strings
+// and 8 raw bytes for doubles. A zero length marks the end of the data
+// (an unfinished segment is zero-filled past the last record).
+namespace evlog {
+constexpr char kMagic[8] = {'S', 'P', 'F', 'E', 'V', 'T', '0', '1'};
+constexpr std::size_t kHeaderSize = 16;
+
+void encodeFields(const WorkflowStarted& e, std::string& out);
+void encodeFields(const TaskQueued& e, std::string& out);
+void encodeFields(const TaskStarted& e, std::string& out);
+void encodeFields(const TaskFinished& e, std::string& out);
+void encodeFields(const WorkflowFinished& e, std::string& out);
+void encodeFields(const OutputChunk& e, std::string& out);
+void encodeFields(const MetricSample& e, std::string& out);
+} // namespace evlog
+
+// EventBus sink that appends events to memory-mapped segment files
+// (<basePath>.000.evt, <basePath>.001.evt, ...). Publishing threads encode
+// into a thread-local buffer and hold the writer lock only for the memcpy.
+class EventRecorder {
+public:
+    struct Options {
+        std::size_t segmentBytes = 64u << 20; // rolled over when full
+    };
+
+    explicit EventRecorder(std::string basePath);
+    EventRecorder(std::string basePath, Options opt);
+    ~EventRecorder();
+
+    EventRecorder(const EventRecorder&) = delete;
+    EventRecorder& operator=(const EventRecorder&) = delete;
+
+    // Create the first segment. Returns false if the file cannot be mapped.
+    bool open();
+
+    // Subscribe to every topic of `bus`; detach() (or the destructor) undoes it.
+    void attach(EventBus& bus);
+    void detach();
+
+    template<class E>
+    void record(const E& e) {
+        thread_local std::string fields;
+        fields.clear();
+        evlog::encodeFields(e, fields);
+        append(E::kind, e.ts, fields);
+    }
+
+    bool flush();
+    void close(); // detaches, trims the active segment to its used size
+
+    std::uint64_t recordCount() const { return records_.load(std::memory_order_relaxed); }
+    std::uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+    std::vector<std::string> segments() const;
+
+private:
+    void append(EventKind kind, EventTime ts, const std::string& fields);
+    bool openSegmentLocked(std::int64_t baseNs);
+    std::string segmentPath(std::size_t n) const;
+
+    std::string basePath_;
+    Options opt_;
+
+    mutable std::mutex m_;
+    MappedFile seg_;
+    std::size_t used_ = 0;
+    std::int64_t lastNs_ = 0;
+    std::vector<std::string> segments_;
+
+    EventBus* bus_ = nullptr;
+    std::vector<EventBus::SubscriptionId> subs_;
+    std::atomic<std::uint64_t> records_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+};
+
+// Any decoded event.
+using AnyEvent = std::variant<WorkflowStarted, TaskQueued, TaskStarted, TaskFinished,
+                              WorkflowFinished, OutputChunk, MetricSample>;
+
+// Sequential decoder over one or more recorded segments.
+class EventReader {
+public:
+    // Map the given segment files in order. Returns false on a missing file
+    // or a bad header; see error().
+    bool open(const std::vector<std::string>& segmentPaths);
+
+    // Decode every record in order. Returns false on a corrupt record.
+    bool forEach(const std::function<void(const AnyEvent&)>& fn);
+
+    // Re-publish every recorded event into `bus`. Returns the event count.
+    std::size_t replay(EventBus& bus);
+
+    const std::string& error() const { return error_; }
+
+private:
+    std::vector<MappedFile> maps_;
+    std::string error_;
+};
+
+// Converters for offline analysis.
+// JSON Lines: one object per event with "kind" and "ts_ns".
+bool writeJsonLines(EventReader& reader, std::ostream& os);
+// Chrome trace_event format (chrome://tracing, Perfetto); one track per worker.
+bool writeChromeTrace(EventReader& reader, std::ostream& os);
+
+} // namespace rt
@@ -0,0 +1,369 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "runtime/BlockPool.hpp"
+#include "runtime/Task.hpp"
+#include "runtime/ThreadPool.hpp"
+
+namespace rt {
+
+// Pool-aware futures with non-blocking composition.
+//
+//   auto f = rt::async(pool, []{ return load(); })
+//                .then([](Data d) { return parse(d); });
+//   auto all = rt::when_all(std::move(futures));
+//
+// Continuations are attached to the shared state and posted to the pool
+// the future came from when it completes; no thread waits for them. A
+// future has a single consumer: then()/get() consume it. Exceptions skip
+// continuations and propagate to the end of the chain.
+
+template<class T> class Future;
+template<class T> class Promise;
+
+namespace detail {
+
+// Where continuations run: a type-erased pool, or inline on the thread
+// that completes the antecedent when there is none.
+struct Scheduler {
+    void* pool = nullptr;
+    bool (*post)(void*, Task&) = nullptr;
+
+    template<class Pool>
+    static Scheduler of(Pool& p) {
+        Scheduler s;
+        s.pool = &p;
+        s.post = [](void* q, Task& t) -> bool {
+            try {
+                if constexpr (std::is_same<Pool, ThreadPool>::value) {
+                    static_cast<Pool*>(q)->post(std::move(t)); // no-op on refusal
+                } else {
+                    // pools built on std::function need a copyable callable
+                    auto holder = std::make_shared<Task>(std::move(t));
+                    try {
+                        static_cast<Pool*>(q)->post([holder]{ (*holder)(); });
+                    } catch (...) {
+                        t = std::move(*holder);
+                        throw;
+                    }
+                }
+                return true;
+            } catch (...) {
+                return false;
+            }
+        };
+        return s;
+    }
+
+    void dispatch(Task&& t) const {
+        if (post && post(pool, t)) return;
+        t(); // no pool, or it is shutting down: run here
+    }
+};
+
+struct Unit {};
+
+template<class T>
+using Stored = typename std::conditional<std::is_void<T>::value, Unit, T>::type;
+
+template<class T>
+struct FutureState {
+    std::mutex m;
+    std::condition_variable cv;
+    bool ready = false;
+    std::optional<Stored<T>> value;
+    std::exception_ptr error;
+    Task continuation;
+    Scheduler sched;
+
+    void complete(std::optional<Stored<T>> v, std::exception_ptr e) {
+        Task cont;
+        {
+            std::lock_guard<std::mutex> g(m);
+            if (ready) throw std::logic_error("rt::Promise already satisfied");
+            value = std::move(v);
+            error = std::move(e);
+            ready = true;
+            cont = std::move(continuation);
+        }
+        cv.notify_all();
+        if (cont) sched.dispatch(std::move(cont));
+    }
+
+    // Runs `cont` once the value is in: immediately if it already is.
+    void attach(Task&& cont) {
+        {
+            std::lock_guard<std::mutex> g(m);
+            if (!ready) { continuation = std::move(cont); return; }
+        }
+        sched.dispatch(std::move(cont));
+    }
+};
+
+template<class T>
+std::shared_ptr<FutureState<T>> makeState(const Scheduler& sched) {
+    auto st = std::allocate_shared<FutureState<T>>(PoolAllocator<FutureState<T>>());
+    st->sched = sched;
+    return st;
+}
+
+// Invokes fn with the value of a completed state (nothing for void) and
+// fulfils `out` with the result or the exception.
+template<class R, class T, class F>
+void fulfil(FutureState<R>& out, FutureState<T>& in, F& fn) {
+    if (in.error) { out.complete(std::nullopt, in.error); return; }
+    try {
+        if constexpr (std::is_void<R>::value) {
+            if constexpr (std::is_void<T>::value) fn(); else fn(std::move(*in.value));
+            out.complete(Unit{}, nullptr);
+        } else {
+            if constexpr (std::is_void<T>::value) out.complete(fn(), nullptr);
+            else out.complete(fn(std::move(*in.value)), nullptr);
+        }
+    } catch (...) {
+        out.complete(std::nullopt, std::current_exception());
+    }
+}
+
+// Lets the free combinators below reach a future's state.
+struct FutureAccess {
+    template<class T>
+    static std::shared_ptr<FutureState<T>>& state(Future<T>& f) { return f.state_; }
+    template<class T>
+    static Future<T> make(std::shared_ptr<FutureState<T>> st) { return Future<T>(std::move(st)); }
+};
+
+template<class T, class F, bool = std::is_void<T>::value>
+struct ThenResult { using type = typename std::invoke_result<F, T>::type; };
+template<class T, class F>
+struct ThenResult<T, F, true> { using type = typename std::invoke_result<F>::type; };
+
+} // namespace detail
+
+template<class T>
+class Future {
+public:
+    Future() = default;
+
+    bool valid() const { return static_cast<bool>(state_); }
+
+    bool ready() const {
+        std::lock_guard<std::mutex> g(state_->m);
+        return state_->ready;
+    }
+
+    void wait() const {
+        std::unique_lock<std::mutex> lk(state_->m);
+        state_->cv.wait(lk, [this]{ return state_->ready; });
+    }
+
+    // Blocks; prefer then() on pool threads.
+    T get() {
+        wait();
+        auto st = std::move(state_);
+        if (st->error) std::rethrow_exception(st->error);
+        if constexpr (!std::is_void<T>::value) return std::move(*st->value);
+    }
+
+    // Schedules fn(value) (fn() for Future<void>) after this future
+    // completes and returns a future for its result. Consumes *this.
+    template<class F>
+    auto then(F&& fn) -> Future<typename detail::ThenResult<T, typename std::decay<F>::type>::type> {
+        using R = typename detail::ThenResult<T, typename std::decay<F>::type>::type;
+        if (!state_) throw std::logic_error("rt::Future::then on an empty future");
+        auto in = std::move(state_);
+        auto out = detail::makeState<R>(in->sched);
+        auto* raw = in.get();
+        raw->attach(Task([in = std::move(in), out, fn = std::forward<F>(fn)]() mutable {
+            detail::fulfil(*out, *in, fn);
+        }));
+        return Future<R>(std::move(out));
+    }
+
+private:
+    template<class> friend class Future;
+    template<class> friend class Promise;
+    friend struct detail::FutureAccess;
+
+    explicit Future(std::shared_ptr<detail::FutureState<T>> st) : state_(std::move(st)) {}
+
+    std::shared_ptr<detail::FutureState<T>> state_;
+};
+
+template<class T>
+class Promise {
+public:
+    Promise() : state_(detail::makeState<T>(detail::Scheduler())) {}
+    Promise(Promise&&) noexcept = default;
+    Promise& operator=(Promise&&) = delete;
+
+    // Dropping an unsatisfied promise fails the future with broken_promise
+    // (and releases any continuation waiting on it).
+    ~Promise() {
+        if (!state_) return;
+        {
+            std::lock_guard<std::mutex> g(state_->m);
+            if (state_->ready) return;
+        }
+        state_->complete(std::nullopt, std::make_exception_ptr(
+            std::future_error(std::future_errc::broken_promise)));
+    }
+
+    // Continuations of the future run on `pool` rather than inline in the
+    // thread that calls set_value().
+    template<class Pool>
+    explicit Promise(Pool& pool) : state_(detail::makeState<T>(detail::Scheduler::of(pool))) {}
+
+    Future<T> get_future() {
+        if (retrieved_) throw std::logic_error("rt::Promise future already retrieved");
+        retrieved_ = true;
+        return Future<T>(state_);
+    }
+
+    // The setters hold their own reference: a waiter woken by them may
+    // destroy both the future and this promise before complete() returns.
+    template<class U = T, class = typename std::enable_if<!std::is_void<U>::value>::type>
+    void set_value(U value) { auto st = state_; st->complete(std::move(value), nullptr); }
+
+    template<class U = T, class = typename std::enable_if<std::is_void<U>::value>::type>
+    void set_value() { auto st = state_; st->complete(detail::Unit{}, nullptr); }
+
+    void set_exception(std::exception_ptr e) { auto st = state_; st->complete(std::nullopt, std::move(e)); }
+
+private:
+    std::shared_ptr<detail::FutureState<T>> state_;
+    bool retrieved_ = false;
+};
+
+// Runs fn(args...) on `pool`; continuations of the result go to the same pool.
+template<class Pool, class F, class... Args>
+auto async(Pool& pool, F&& fn, Args&&... args) {
+    using R = typename std::invoke_result<typename std::decay<F>::type,
+                                          typename std::decay<Args>::type...>::type;
+    auto st = detail::makeState<R>(detail::Scheduler::of(pool));
+    Task task([st, fn = std::forward<F>(fn),
+               args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+        try {
+            if constexpr (std::is_void<R>::value) {
+                std::apply(fn, std::move(args));
+                st->complete(detail::Unit{}, nullptr);
+            } else {
+                st->complete(std::apply(fn, std::move(args)), nullptr);
+            }
+        } catch (...) {
+            st->complete(std::nullopt, std::current_exception());
+        }
+    });
+    st->sched.dispatch(std::move(task));
+    return detail::FutureAccess::make(std::move(st));
+}
+
+// Completes when every input has; yields the values in input order, or the
+// first exception (by input order) once all inputs are done.
+template<class T>
+Future<std::vector<T>> when_all(std::vector<Future<T>> inputs) {
+    struct Join {
+        std::atomic<size_t> left;
+        std::vector<std::optional<T>> values;
+        std::vector<std::exception_ptr> errors;
+        std::shared_ptr<detail::FutureState<std::vector<T>>> out;
+    };
+    detail::Scheduler sched = inputs.empty() ? detail::Scheduler() : detail::FutureAccess::state(inputs.front())->sched;
+    auto join = std::make_shared<Join>();
+    join->out = detail::makeState<std::vector<T>>(sched);
+    auto result = detail::FutureAccess::make(join->out);
+    if (inputs.empty()) { join->out->complete(std::vector<T>(), nullptr); return result; }
+    join->left.store(inputs.size());
+    join->values.resize(inputs.size());
+    join->errors.resize(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        auto in = std::move(detail::FutureAccess::state(inputs[i]));
+        auto* raw = in.get();
+        raw->attach(Task([join, in = std::move(in), i]() mutable {
+            if (in->error) join->errors[i] = in->error;
+            else join->values[i] = std::move(*in->value);
+            if (join->left.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+            for (auto& e : join->errors) {
+                if (e) { join->out->complete(std::nullopt, e); return; }
+            }
+            std::vector<T> all;
+            all.reserve(join->values.size());
+            for (auto& v : join->values) all.push_back(std::move(*v));
+            join->out->complete(std::move(all), nullptr);
+        }));
+    }
+    return result;
+}
+
+inline Future<void> when_all(std::vector<Future<void>> inputs) {
+    struct Join {
+        std::atomic<size_t> left;
+        std::vector<std::exception_ptr> errors;
+        std::shared_ptr<detail::FutureState<void>> out;
+    };
+    detail::Scheduler sched = inputs.empty() ? detail::Scheduler() : detail::FutureAccess::state(inputs.front())->sched;
+    auto join = std::make_shared<Join>();
+    join->out = detail::makeState<void>(sched);
+    auto result = detail::FutureAccess::make(join->out);
+    if (inputs.empty()) { join->out->complete(detail::Unit{}, nullptr); return result; }
+    join->left.store(inputs.size());
+    join->errors.resize(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        auto in = std::move(detail::FutureAccess::state(inputs[i]));
+        auto* raw = in.get();
+        raw->attach(Task([join, in = std::move(in), i]() mutable {
+            join->errors[i] = in->error;
+            if (join->left.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+            for (auto& e : join->errors) {
+                if (e) { join->out->complete(std::nullopt, e); return; }
+            }
+            join->out->complete(detail::Unit{}, nullptr);
+        }));
+    }
+    return result;
+}
+
+// Result of when_any over non-void futures: which input won, and its value.
+template<class T>
+struct AnyResult {
+    size_t index;
+    T value;
+};
+
+// Completes with the first input to finish (value or exception). For
+// Future<void> inputs the result is just the winning index. The other
+// inputs still run to completion; their results are dropped.
+template<class T>
+auto when_any(std::vector<Future<T>> inputs) {
+    using R = typename std::conditional<std::is_void<T>::value, size_t, AnyResult<detail::Stored<T>>>::type;
+    if (inputs.empty()) throw std::invalid_argument("rt::when_any needs at least one future");
+    struct Race {
+        std::atomic<bool> done{false};
+        std::shared_ptr<detail::FutureState<R>> out;
+    };
+    auto race = std::make_shared<Race>();
+    race->out = detail::makeState<R>(detail::FutureAccess::state(inputs.front())->sched);
+    auto result = detail::FutureAccess::make(race->out);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        auto in = std::move(detail::FutureAccess::state(inputs[i]));
+        auto* raw = in.get();
+        raw->attach(Task([race, in = std::move(in), i]() mutable {
+            if (race->done.exchange(true, std::memory_order_acq_rel)) return;
+            if (in->error) { race->out->complete(std::nullopt, in->error); return; }
+            if constexpr (std::is_void<T>::value) race->out->complete(i, nullptr);
+            else race->out->complete(R{i, std::move(*in->value)}, nullptr);
+        }));
+    }
+    return result;
+}
+
+} // namespace rt
@@ -0,0 +1,127 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace rt {
+
+// Log-linear (HDR-style) bucketing: values below 8 get a bucket each;
+// above that every power of two is split into 8 linear sub-buckets, so a
+// bucket's bounds are within 12.5% of any value in it, over the full
+// uint64_t range.
+struct HistogramLayout {
+    static constexpr unsigned kSubBits = 3;
+    static constexpr size_t kSub = size_t(1) << kSubBits;
+    static constexpr size_t kBuckets = kSub + (64 - kSubBits) * kSub; // 496
+
+    static size_t bucketOf(uint64_t value) {
+        if (value < kSub) return static_cast<size_t>(value);
+#if defined(__GNUC__) || defined(__clang__)
+        const unsigned e = 63u - static_cast<unsigned>(__builtin_clzll(value));
+#else
+        unsigned e = 0;
+        for (uint64_t v = value; v >>= 1;) ++e;
+#endif
+        const unsigned shift = e - kSubBits;
+        return kSub + shift * kSub + static_cast<size_t>((value >> shift) & (kSub - 1));
+    }
+    static uint64_t lowerBound(size_t b) {
+        if (b < kSub) return b;
+        const unsigned shift = static_cast<unsigned>((b - kSub) / kSub);
+        return (kSub + (b - kSub) % kSub) << shift;
+    }
+    static uint64_t upperBound(size_t b) {
+        if (b < kSub) return b;
+        const unsigned shift = static_cast<unsigned>((b - kSub) / kSub);
+        return lowerBound(b) + ((uint64_t(1) << shift) - 1);
+    }
+};
+
+// Point-in-time copy of a Histogram.
+struct HistogramSnapshot {
+    static constexpr size_t kBuckets = HistogramLayout::kBuckets;
+
+    std::array<uint64_t, kBuckets> buckets{}; // see HistogramLayout for the bounds
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    void merge(const HistogramSnapshot& o) {
+        for (size_t b = 0; b < kBuckets; ++b) buckets[b] += o.buckets[b];
+        count += o.count;
+        sum += o.sum;
+        if (o.max > max) max = o.max;
+    }
+
+    double mean() const { return count ? static_cast<double>(sum) / static_cast<double>(count) : 0.0; }
+
+    // Upper bound of the bucket holding the q-quantile (q in [0, 1]).
+    uint64_t percentile(double q) const {
+        if (count == 0) return 0;
+        const double target = q * static_cast<double>(count);
+        uint64_t seen = 0;
+        for (size_t b = 0; b < kBuckets; ++b) {
+            seen += buckets[b];
+            if (static_cast<double>(seen) >= target && buckets[b]) {
+                const uint64_t upper = HistogramLayout::upperBound(b);
+                return upper < max ? upper : max;
+            }
+        }
+        return max;
+    }
+};
+
+// Lock-free HDR-style histogram: record() is a handful of relaxed atomic
+// adds, cheap enough for per-task use on the hot path.
+class Histogram {
+public:
+    static constexpr size_t kBuckets = HistogramSnapshot::kBuckets;
+
+    void record(uint64_t value) {
+        buckets_[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        uint64_t prev = max_.load(std::memory_order_relaxed);
+        while (value > prev && !max_.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {}
+    }
+
+    // Same as record() for callers that already serialise writers (e.g.
+    // under a queue lock): plain loads and stores instead of atomic RMWs.
+    // Concurrent snapshot() readers are still safe.
+    void recordSerialized(uint64_t value) {
+        auto bump = [](std::atomic<uint64_t>& a, uint64_t d) {
+            a.store(a.load(std::memory_order_relaxed) + d, std::memory_order_relaxed);
+        };
+        bump(buckets_[bucketOf(value)], 1);
+        bump(count_, 1);
+        bump(sum_, value);
+        if (value > max_.load(std::memory_order_relaxed)) max_.store(value, std::memory_order_relaxed);
+    }
+
+    HistogramSnapshot snapshot() const {
+        HistogramSnapshot s;
+        for (size_t b = 0; b < kBuckets; ++b) s.buckets[b] = buckets_[b].load(std::memory_order_relaxed);
+        s.count = count_.load(std::memory_order_relaxed);
+        s.sum = sum_.load(std::memory_order_relaxed);
+        s.max = max_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    void reset() {
+        for (auto& b : buckets_) b.store(0, std::memory_order_relaxed);
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    static size_t bucketOf(uint64_t value) { return HistogramLayout::bucketOf(value); }
+
+private:
+    std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+} // namespace rt
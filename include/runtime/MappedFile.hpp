@@ -0,0 +1,192 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(_WIN32)
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace rt {
+
+// Thin RAII wrapper over a memory-mapped file (mmap / MapViewOfFile).
+// Header-only so plugins can use it without linking the runtime library.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& o) noexcept { moveFrom(o); }
+    MappedFile& operator=(MappedFile&& o) noexcept {
+        if (this != &o) { close(); moveFrom(o); }
+        return *this;
+    }
+
+    enum class Access { Normal, Sequential };
+
+    // Map an existing file read-only. An empty file maps to size()==0.
+    // Access::Sequential advises the OS of a single front-to-back pass
+    // (MADV_SEQUENTIAL / FILE_FLAG_SEQUENTIAL_SCAN): deeper read-ahead,
+    // pages behind the reader dropped first.
+    bool openRead(const std::string& path, Access access = Access::Normal);
+
+    // Create (or truncate) a file of `size` bytes and map it read/write.
+    bool create(const std::string& path, std::size_t size);
+
+    // Unmap and close. For writable maps, `keepBytes` (if not npos) truncates
+    // the file to the bytes actually used.
+    void close(std::size_t keepBytes = npos);
+
+    // Flush dirty pages of a writable map to disk.
+    bool sync();
+
+    bool isOpen() const { return opened_; }
+    const char* data() const { return static_cast<const char*>(data_); }
+    char* data() { return static_cast<char*>(data_); }
+    std::size_t size() const { return size_; }
+    bool writable() const { return writable_; }
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+private:
+    void moveFrom(MappedFile& o) {
+        data_ = o.data_; size_ = o.size_; writable_ = o.writable_; opened_ = o.opened_;
+#if defined(_WIN32)
+        file_ = o.file_; mapping_ = o.mapping_;
+        o.file_ = INVALID_HANDLE_VALUE; o.mapping_ = nullptr;
+#else
+        fd_ = o.fd_; o.fd_ = -1;
+#endif
+        o.data_ = nullptr; o.size_ = 0; o.writable_ = false; o.opened_ = false;
+    }
+
+    void* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool writable_ = false;
+    bool opened_ = false;
+#if defined(_WIN32)
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
+
+#if defined(_WIN32)
+
+inline bool MappedFile::openRead(const std::string& path, Access access) {
+    close();
+    file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                        access == Access::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL,
+                        nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER sz;
+    if (!GetFileSizeEx(file_, &sz)) { close(); return false; }
+    size_ = static_cast<std::size_t>(sz.QuadPart);
+    opened_ = true;
+    if (size_ == 0) return true;
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_) { close(); return false; }
+    data_ = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+    if (!data_) { close(); return false; }
+    return true;
+}
+
+inline bool MappedFile::create(const std::string& path, std::size_t size) {
+    close();
+    file_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER sz; sz.QuadPart = static_cast<LONGLONG>(size);
+    if (!SetFilePointerEx(file_, sz, nullptr, FILE_BEGIN) || !SetEndOfFile(file_)) {
+        close(); return false;
+    }
+    size_ = size; writable_ = true; opened_ = true;
+    if (size_ == 0) return true;
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    if (!mapping_) { close(); return false; }
+    data_ = MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0, 0);
+    if (!data_) { close(); return false; }
+    return true;
+}
+
+inline void MappedFile::close(std::size_t keepBytes) {
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_ != INVALID_HANDLE_VALUE) {
+        if (writable_ && keepBytes != npos && keepBytes < size_) {
+            LARGE_INTEGER sz; sz.QuadPart = static_cast<LONGLONG>(keepBytes);
+            if (SetFilePointerEx(file_, sz, nullptr, FILE_BEGIN)) SetEndOfFile(file_);
+        }
+        CloseHandle(file_);
+    }
+    data_ = nullptr; mapping_ = nullptr; file_ = INVALID_HANDLE_VALUE;
+    size_ = 0; writable_ = false; opened_ = false;
+}
+
+inline bool MappedFile::sync() {
+    if (!data_ || !writable_) return false;
+    return FlushViewOfFile(data_, 0) != 0;
+}
+
+#else
+
+inline bool MappedFile::openRead(const std::string& path, Access access) {
+    close();
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) return false;
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) { close(); return false; }
+    size_ = static_cast<std::size_t>(st.st_size);
+    opened_ = true;
+    if (size_ == 0) return true;
+    void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (p == MAP_FAILED) { close(); return false; }
+    data_ = p;
+    if (access == Access::Sequential) ::madvise(p, size_, MADV_SEQUENTIAL);
+    return true;
+}
+
+inline bool MappedFile::create(const std::string& path, std::size_t size) {
+    close();
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) return false;
+    if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) { close(); return false; }
+    size_ = size; writable_ = true; opened_ = true;
+    if (size_ == 0) return true;
+    void* p = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) { close(); return false; }
+    data_ = p;
+    return true;
+}
+
+inline void MappedFile::close(std::size_t keepBytes) {
+    if (data_) ::munmap(data_, size_);
+    if (fd_ >= 0) {
+        if (writable_ && keepBytes != npos && keepBytes < size_) {
+            (void)::ftruncate(fd_, static_cast<off_t>(keepBytes));
+        }
+        ::close(fd_);
+    }
+    data_ = nullptr; fd_ = -1;
+    size_ = 0; writable_ = false; opened_ = false;
+}
+
+inline bool MappedFile::sync() {
+    if (!data_ || !writable_) return false;
+    return ::msync(data_, size_, MS_ASYNC) == 0;
+}
+
+#endif
+
+} // namespace rt
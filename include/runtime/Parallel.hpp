@@ -0,0 +1,234 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rt {
+
+// Cooperative cancellation flag shared by copies of the token. Work that
+// has already started runs to the end of its chunk; pending chunks are
+// skipped.
+class CancellationToken {
+public:
+    CancellationToken() : state_(std::make_shared<std::atomic<bool>>(false)) {}
+
+    // A token that can never be cancelled (no allocation).
+    static const CancellationToken& none() {
+        static const CancellationToken t{nullptr};
+        return t;
+    }
+
+    void cancel() const noexcept {
+        if (state_) state_->store(true, std::memory_order_release);
+    }
+    bool cancelled() const noexcept {
+        return state_ && state_->load(std::memory_order_acquire);
+    }
+
+private:
+    explicit CancellationToken(std::nullptr_t) {}
+    std::shared_ptr<std::atomic<bool>> state_;
+};
+
+namespace detail {
+
+// Count of outstanding units that a waiter can park on. retire() takes the
+// mutex only when it may be the last, and helpUntil() takes it once before
+// returning, so the owner can be destroyed as soon as helpUntil() returns.
+class PendingCount {
+public:
+    explicit PendingCount(size_t initial = 0) : n_(initial) {}
+
+    void add() { n_.fetch_add(1, std::memory_order_relaxed); }
+
+    void retire() {
+        size_t cur = n_.load(std::memory_order_relaxed);
+        while (cur > 1) {
+            if (n_.compare_exchange_weak(cur, cur - 1, std::memory_order_acq_rel)) return;
+        }
+        std::lock_guard<std::mutex> g(m_);
+        if (n_.fetch_sub(1, std::memory_order_acq_rel) == 1) cv_.notify_all();
+    }
+
+    bool done() const { return n_.load(std::memory_order_acquire) == 0; }
+
+private:
+    template<class Pool>
+    friend void helpUntil(Pool& pool, PendingCount& count);
+
+    std::atomic<size_t> n_;
+    std::mutex m_;
+    std::condition_variable cv_;
+};
+
+// Fork/join bookkeeping for one bulk call; lives on the caller's stack,
+// which blocks (helping) until every chunk has been retired.
+struct ChunkJob {
+    PendingCount pending{1};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex errorMtx;
+    const CancellationToken* token = nullptr;
+    void (*run)(void*, size_t) = nullptr;
+    void* body = nullptr;
+
+    bool stopped() const {
+        return failed.load(std::memory_order_relaxed) || token->cancelled();
+    }
+    void fail(std::exception_ptr e) {
+        std::lock_guard<std::mutex> g(errorMtx);
+        if (!error) error = std::move(e);
+        failed.store(true, std::memory_order_relaxed);
+    }
+};
+
+// Splits [lo, hi) in halves, hands the upper half to the pool and keeps
+// the lower half, so idle workers pick up large ranges first.
+template<class Pool>
+void splitChunks(Pool& pool, ChunkJob* job, size_t lo, size_t hi) {
+    while (hi - lo > 1 && !job->stopped()) {
+        const size_t mid = lo + (hi - lo) / 2;
+        job->pending.add();
+        try {
+            pool.post([&pool, job, mid, hi]{ splitChunks(pool, job, mid, hi); });
+        } catch (...) {
+            splitChunks(pool, job, mid, hi); // pool refused work: run it here
+        }
+        hi = mid;
+    }
+    for (size_t c = lo; c < hi && !job->stopped(); ++c) {
+        try {
+            job->run(job->body, c);
+        } catch (...) {
+            job->fail(std::current_exception());
+        }
+    }
+    job->pending.retire(); // last touch of *job
+}
+
+// Runs queued pool work on the calling thread until `count` drops to zero.
+// When the pool has nothing to hand out it parks on the count, which the
+// last retire() signals. The park is capped, growing to 1ms, because work
+// queued meanwhile may be work that only this thread is free to run.
+template<class Pool>
+void helpUntil(Pool& pool, PendingCount& count) {
+    int idle = 0;
+    auto slice = std::chrono::microseconds(50);
+    while (!count.done()) {
+        if (pool.tryRunOne()) {
+            idle = 0;
+            slice = std::chrono::microseconds(50);
+            continue;
+        }
+        if (++idle < 64) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lk(count.m_);
+        count.cv_.wait_for(lk, slice, [&count]{ return count.done(); });
+        slice = std::min<std::chrono::microseconds>(slice * 2, std::chrono::milliseconds(1));
+    }
+    std::lock_guard<std::mutex> g(count.m_); // the last retire() may still hold it
+}
+
+// Runs body(chunk) for chunk in [0, chunks) on the pool and the calling
+// thread. Rethrows the first exception; returns false when cancelled.
+template<class Pool, class Body>
+bool forEachChunk(Pool& pool, size_t chunks, Body& body, const CancellationToken& token) {
+    if (chunks == 0) return !token.cancelled();
+    ChunkJob job;
+    job.token = &token;
+    job.body = &body;
+    job.run = [](void* b, size_t c) { (*static_cast<Body*>(b))(c); };
+    splitChunks(pool, &job, 0, chunks);
+    helpUntil(pool, job.pending);
+    if (job.error) std::rethrow_exception(job.error);
+    return !token.cancelled();
+}
+
+// About eight chunks per worker: enough slack for stealing to even out
+// uneven chunks without drowning in task overhead.
+template<class Pool>
+size_t autoGrain(const Pool& pool, size_t n) {
+    const size_t target = std::max<size_t>(1, pool.size()) * 8;
+    return std::max<size_t>(1, (n + target - 1) / target);
+}
+
+} // namespace detail
+
+// Calls body(i) for every i in [first, last), in chunks of `grain` indices
+// (0 = automatic). Returns false if `token` was cancelled before all
+// chunks ran; rethrows the first exception thrown by body.
+template<class Pool, class Body>
+bool parallel_for(Pool& pool, size_t first, size_t last, Body&& body, size_t grain = 0,
+                  const CancellationToken& token = CancellationToken::none()) {
+    if (last <= first) return !token.cancelled();
+    const size_t n = last - first;
+    if (grain == 0) grain = detail::autoGrain(pool, n);
+    auto chunk = [&](size_t c) {
+        const size_t lo = first + c * grain;
+        const size_t hi = std::min(last, lo + grain);
+        for (size_t i = lo; i < hi; ++i) body(i);
+    };
+    return detail::forEachChunk(pool, (n + grain - 1) / grain, chunk, token);
+}
+
+// Folds map(i) over [first, last) with `combine`, starting each chunk from
+// `identity`. Chunk results are combined left to right, so the result is
+// deterministic for a given grain even with non-associative floating point.
+// On cancellation the result covers only the chunks that ran.
+template<class Pool, class T, class Map, class Combine>
+T parallel_reduce(Pool& pool, size_t first, size_t last, T identity, Map&& map, Combine&& combine,
+                  size_t grain = 0, const CancellationToken& token = CancellationToken::none()) {
+    if (last <= first) return identity;
+    const size_t n = last - first;
+    if (grain == 0) grain = detail::autoGrain(pool, n);
+    const size_t chunks = (n + grain - 1) / grain;
+    std::vector<T> partial(chunks, identity);
+    auto chunk = [&](size_t c) {
+        const size_t lo = first + c * grain;
+        const size_t hi = std::min(last, lo + grain);
+        T acc = identity;
+        for (size_t i = lo; i < hi; ++i) acc = combine(std::move(acc), map(i));
+        partial[c] = std::move(acc);
+    };
+    detail::forEachChunk(pool, chunks, chunk, token);
+    T result = std::move(identity);
+    for (auto& p : partial) result = combine(std::move(result), std::move(p));
+    return result;
+}
+
+// Parallel merge sort: sorts runs concurrently, then merges neighbouring
+// runs pairwise in rounds. Not stable; falls back to std::sort for small
+// inputs.
+template<class Pool, class RandomIt, class Compare = std::less<>>
+void parallel_sort(Pool& pool, RandomIt first, RandomIt last, Compare comp = Compare()) {
+    constexpr size_t kMinRun = 4096;
+    const size_t n = static_cast<size_t>(std::distance(first, last));
+    const size_t runs = std::min<size_t>(std::max<size_t>(1, pool.size()) * 4, n / kMinRun);
+    if (runs < 2) { std::sort(first, last, comp); return; }
+
+    auto at = [&](size_t r) { return first + static_cast<std::ptrdiff_t>(n * std::min(r, runs) / runs); };
+    auto sortRun = [&](size_t r) { std::sort(at(r), at(r + 1), comp); };
+    detail::forEachChunk(pool, runs, sortRun, CancellationToken::none());
+
+    for (size_t width = 1; width < runs; width *= 2) {
+        auto mergePair = [&](size_t m) {
+            const size_t lo = 2 * m * width;
+            std::inplace_merge(at(lo), at(lo + width), at(lo + 2 * width), comp);
+        };
+        detail::forEachChunk(pool, (runs + 2 * width - 1) / (2 * width), mergePair,
+                             CancellationToken::none());
+    }
+}
+
+} // namespace rt
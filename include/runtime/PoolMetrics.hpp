@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "runtime/Histogram.hpp"
+
+namespace rt {
+
+// Counters of one pool worker (or of outside threads helping via
+// tryRunOne). Times are in nanoseconds.
+struct WorkerMetrics {
+    uint64_t tasks = 0;
+    uint64_t stealAttempts = 0; // scans of other workers' queues
+    uint64_t steals = 0;        // scans that found a task
+    uint64_t parks = 0;         // times the worker went to sleep
+    uint64_t unparks = 0;       // times it was woken again
+    uint64_t busyNs = 0;        // time spent running tasks
+
+    void merge(const WorkerMetrics& o) {
+        tasks += o.tasks;
+        stealAttempts += o.stealAttempts;
+        steals += o.steals;
+        parks += o.parks;
+        unparks += o.unparks;
+        busyNs += o.busyNs;
+    }
+};
+
+// Live counters behind WorkerMetrics. bump() is a relaxed load+store, so
+// each instance must have a single writer (its worker); add() is the
+// atomic variant for shared instances.
+struct alignas(64) WorkerCounters {
+    std::atomic<uint64_t> tasks{0};
+    std::atomic<uint64_t> stealAttempts{0};
+    std::atomic<uint64_t> steals{0};
+    std::atomic<uint64_t> parks{0};
+    std::atomic<uint64_t> unparks{0};
+    std::atomic<uint64_t> busyNs{0};
+
+    static void bump(std::atomic<uint64_t>& c, uint64_t d = 1) {
+        c.store(c.load(std::memory_order_relaxed) + d, std::memory_order_relaxed);
+    }
+    static void add(std::atomic<uint64_t>& c, uint64_t d = 1) {
+        c.fetch_add(d, std::memory_order_relaxed);
+    }
+
+    void reset() {
+        for (auto* c : {&tasks, &stealAttempts, &steals, &parks, &unparks, &busyNs}) c->store(0, std::memory_order_relaxed);
+    }
+
+    WorkerMetrics snapshot() const {
+        WorkerMetrics m;
+        m.tasks = tasks.load(std::memory_order_relaxed);
+        m.stealAttempts = stealAttempts.load(std::memory_order_relaxed);
+        m.steals = steals.load(std::memory_order_relaxed);
+        m.parks = parks.load(std::memory_order_relaxed);
+        m.unparks = unparks.load(std::memory_order_relaxed);
+        m.busyNs = busyNs.load(std::memory_order_relaxed);
+        return m;
+    }
+};
+
+// Snapshot of a pool, taken without stopping it: counters are read one by
+// one, so totals can be off by the tasks in flight.
+struct PoolMetrics {
+    std::vector<WorkerMetrics> workers;
+    WorkerMetrics external;      // work done by non-worker threads (tryRunOne)
+    HistogramSnapshot queueWait; // submit -> start, ns
+    HistogramSnapshot runTime;   // start -> end, ns
+    uint64_t queued = 0;         // approximate
+    uint64_t uptimeNs = 0;       // since the workers started
+
+    WorkerMetrics total() const;
+    // Share of worker time spent running tasks, in [0, 1].
+    double utilization() const;
+
+    std::string toJson() const;
+    // Prometheus text exposition format; every metric is prefixed with
+    // `prefix` and labelled with `labels` (e.g. `pool="io"`), if given.
+    std::string toPrometheus(const std::string& prefix = "spf_pool", const std::string& labels = {}) const;
+};
+
+} // namespace rt
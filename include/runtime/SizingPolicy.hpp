@@ -0,0 +1,41 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <thread>
+
+namespace rt {
+
+// How a pool grows and shrinks around its core size. Shared by
+// rt::ThreadPool and the legacy cached-mode pool in threadpool/threadpool.h.
+//  - idle: spin (yield) `spinRounds` times, then park;
+//  - grow: only to compensate for workers inside a BlockingRegion (or,
+//    for the legacy pool, when a task arrives and nobody is idle);
+//  - shrink: a thread above the core size that stays parked for
+//    `idleShrink` exits. No polling, and nothing is logged.
+struct SizingPolicy {
+    int spinRounds = 64;
+    std::chrono::milliseconds idleShrink{5000};
+    size_t maxThreads = 0; // 0 = 4 x core size
+
+    size_t maxFor(size_t core) const { return maxThreads ? maxThreads : core * 4; }
+};
+
+// Spin-then-park helper: call spin() while there is nothing to do; once it
+// returns false the caller should park.
+class IdleBackoff {
+public:
+    explicit IdleBackoff(const SizingPolicy& p) : rounds_(p.spinRounds) {}
+    bool spin() {
+        if (n_ >= rounds_) return false;
+        ++n_;
+        std::this_thread::yield();
+        return true;
+    }
+    void reset() { n_ = 0; }
+
+private:
+    int rounds_;
+    int n_ = 0;
+};
+
+} // namespace rt
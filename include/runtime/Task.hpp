@@ -0,0 +1,105 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace rt {
+
+// Move-only `void()` callable with small-buffer optimization.
+// Callables up to kInlineSize bytes (and nothrow-movable) are stored inline,
+// so queuing a typical lambda does not touch the heap; larger ones fall back
+// to a single heap allocation. Unlike std::function it accepts move-only
+// captures (promises, unique_ptrs).
+class Task {
+public:
+    static constexpr std::size_t kInlineSize = 48;
+    static constexpr std::size_t kInlineAlign = alignof(std::max_align_t);
+
+    template<class F>
+    static constexpr bool fitsInline() {
+        return sizeof(F) <= kInlineSize && alignof(F) <= kInlineAlign &&
+               std::is_nothrow_move_constructible<F>::value;
+    }
+
+    Task() noexcept = default;
+
+    template<class F,
+             class D = typename std::decay<F>::type,
+             class = typename std::enable_if<!std::is_same<D, Task>::value>::type>
+    Task(F&& f) { // NOLINT: implicit by design, like std::function
+        init<D>(std::forward<F>(f));
+    }
+
+    Task(Task&& o) noexcept { moveFrom(o); }
+    Task& operator=(Task&& o) noexcept {
+        if (this != &o) { reset(); moveFrom(o); }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { reset(); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    void operator()() { ops_->invoke(buf_); }
+
+    void reset() noexcept {
+        if (ops_) { ops_->destroy(buf_); ops_ = nullptr; }
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void*);
+        void (*move)(void* dst, void* src) noexcept; // move-construct dst, destroy src
+        void (*destroy)(void*) noexcept;
+    };
+
+    template<class D>
+    struct InlineOps {
+        static void invoke(void* p) { (*static_cast<D*>(p))(); }
+        static void move(void* dst, void* src) noexcept {
+            ::new (dst) D(std::move(*static_cast<D*>(src)));
+            static_cast<D*>(src)->~D();
+        }
+        static void destroy(void* p) noexcept { static_cast<D*>(p)->~D(); }
+        static constexpr Ops ops{&invoke, &move, &destroy};
+    };
+
+    template<class D>
+    struct HeapOps {
+        static D*& ptr(void* p) { return *static_cast<D**>(p); }
+        static void invoke(void* p) { (*ptr(p))(); }
+        static void move(void* dst, void* src) noexcept {
+            ::new (dst) D*(ptr(src));
+            ptr(src) = nullptr;
+        }
+        static void destroy(void* p) noexcept { delete ptr(p); }
+        static constexpr Ops ops{&invoke, &move, &destroy};
+    };
+
+    template<class D, class F>
+    void init(F&& f) {
+        if constexpr (fitsInline<D>()) {
+            ::new (static_cast<void*>(buf_)) D(std::forward<F>(f));
+            ops_ = &InlineOps<D>::ops;
+        } else {
+            ::new (static_cast<void*>(buf_)) D*(new D(std::forward<F>(f)));
+            ops_ = &HeapOps<D>::ops;
+        }
+    }
+
+    void moveFrom(Task& o) noexcept {
+        if (o.ops_) {
+            o.ops_->move(buf_, o.buf_);
+            ops_ = o.ops_;
+            o.ops_ = nullptr;
+        }
+    }
+
+    alignas(kInlineAlign) unsigned char buf_[kInlineSize];
+    const Ops* ops_ = nullptr;
+};
+
+} // namespace rt
@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include "runtime/Parallel.hpp"
+
+namespace rt {
+
+// A set of tasks that is waited on and cancelled as a unit. Works with any
+// pool that has post() and tryRunOne() (rt::ThreadPool, tp::ThreadPool).
+//
+//   rt::TaskGroup<rt::ThreadPool> g(pool);
+//   g.run([&]{ ... });
+//   g.run([&]{ ... });
+//   g.wait(); // helps run queued work, rethrows the first exception
+//
+// The first task to throw cancels the group: tasks that have not started
+// yet are skipped. wait() runs pool work on the calling thread while it
+// waits, so tasks may wait on nested groups without starving the pool.
+template<class Pool>
+class TaskGroup {
+public:
+    explicit TaskGroup(Pool& pool, CancellationToken token = CancellationToken())
+        : pool_(pool), token_(std::move(token)) {}
+
+    // Structured: a group never outlives its tasks. Errors not collected by
+    // wait() are dropped here.
+    ~TaskGroup() {
+        detail::helpUntil(pool_, pending_);
+    }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    template<class F>
+    void run(F&& f) {
+        if (token_.cancelled()) return;
+        pending_.add();
+        try {
+            pool_.post([this, fn = std::forward<F>(f)]() mutable { execute(fn); });
+        } catch (...) {
+            pending_.retire();
+            throw;
+        }
+    }
+
+    // Blocks until every task has finished or been skipped, running pool
+    // work meanwhile. Rethrows (once) the first exception a task threw.
+    void wait() {
+        detail::helpUntil(pool_, pending_);
+        std::exception_ptr e;
+        {
+            std::lock_guard<std::mutex> g(errorMtx_);
+            e = std::exchange(error_, nullptr);
+        }
+        if (e) std::rethrow_exception(e);
+    }
+
+    void cancel() { token_.cancel(); }
+    bool cancelled() const { return token_.cancelled(); }
+
+    // Shared with the tasks so long-running ones can poll for cancellation.
+    const CancellationToken& token() const { return token_; }
+
+private:
+    template<class F>
+    void execute(F& fn) {
+        if (!token_.cancelled()) {
+            try {
+                fn();
+            } catch (...) {
+                std::lock_guard<std::mutex> g(errorMtx_);
+                if (!error_) error_ = std::current_exception();
+                token_.cancel();
+            }
+        }
+        pending_.retire(); // last touch of *this
+    }
+
+    Pool& pool_;
+    CancellationToken token_;
+    detail::PendingCount pending_;
+    std::mutex errorMtx_;
+    std::exception_ptr error_;
+};
+
+} // namespace rt
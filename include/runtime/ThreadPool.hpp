@@ -1,81 +1,658 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
 #include <vector>
 #include <thread>
 #include <future>
-#include <queue>
+#include <memory>
 #include <mutex>
+#include <new>
 #include <condition_variable>
-#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <atomic>
+#include <stdexcept>
+#include "runtime/Task.hpp"
+#include "runtime/BlockPool.hpp"
+#include "runtime/Histogram.hpp"
+#include "runtime/PoolMetrics.hpp"
+#include "runtime/SizingPolicy.hpp"
+#include "runtime/Topology.hpp"
 
 namespace rt {
 
-// Minimal, self-contained thread pool for workflow executor
+// Growable FIFO ring. Slots are reused in place, so a warmed-up queue
+// never allocates on push/pop.
+template<class T, class Alloc = std::allocator<T>>
+class RingQueue {
+public:
+    explicit RingQueue(const Alloc& alloc = Alloc()) : slots_(alloc) {}
+
+    bool empty() const { return count_ == 0; }
+    size_t size() const { return count_; }
+    T& front() { return slots_[head_]; }
+
+    void push(T&& v) {
+        if (count_ == slots_.size()) grow();
+        slots_[(head_ + count_) & (slots_.size() - 1)] = std::move(v);
+        ++count_;
+    }
+    T pop() {
+        T v = std::move(slots_[head_]);
+        head_ = (head_ + 1) & (slots_.size() - 1);
+        --count_;
+        return v;
+    }
+
+private:
+    void grow() {
+        std::vector<T, Alloc> next(slots_.empty() ? 64 : slots_.size() * 2, slots_.get_allocator());
+        for (size_t i = 0; i < count_; ++i) {
+            next[i] = std::move(slots_[(head_ + i) & (slots_.size() - 1)]);
+        }
+        slots_.swap(next);
+        head_ = 0;
+    }
+
+    std::vector<T, Alloc> slots_; // power-of-two capacity
+    size_t head_ = 0;
+    size_t count_ = 0;
+};
+
+enum class Priority : uint8_t { High = 0, Normal, Low };
+constexpr size_t kPriorityCount = 3;
+
+// Per-task scheduling hints. Within a lane tasks run earliest-deadline
+// first; tasks without a deadline run FIFO after those that have one.
+struct TaskOptions {
+    using Clock = std::chrono::steady_clock;
+
+    Priority priority = Priority::Normal;
+    Clock::time_point deadline = Clock::time_point::max();
+
+    TaskOptions() = default;
+    TaskOptions(Priority p) : priority(p) {} // NOLINT: implicit so post(Priority::High, f) reads naturally
+    TaskOptions(Priority p, Clock::time_point d) : priority(p), deadline(d) {}
+};
+
+enum class Affinity : uint8_t {
+    None, // no pinning (beyond restricting to PoolOptions::cpus, if given)
+    Core, // each worker pinned to one CPU
+    Node, // each worker pinned to the CPUs of its NUMA node
+};
+
+struct PoolOptions {
+    size_t threads = std::thread::hardware_concurrency();
+    // Anti-starvation: a queued task is treated as one lane higher for every
+    // `aging` it has waited (0 disables aging).
+    std::chrono::microseconds aging{10000};
+    Affinity affinity = Affinity::None;
+    // CPUs the workers may use; empty = every CPU in the topology.
+    std::vector<int> cpus;
+    // One queue per NUMA node: workers (and outside callers) use their own
+    // node's queue and only take work from other nodes, nearest first, when
+    // it runs dry. In libnuma builds each queue, including the storage of
+    // the tasks it holds, is allocated on its node.
+    bool numaAware = false;
+    // Idle backoff, compensation ceiling and shrink delay (see SizingPolicy).
+    SizingPolicy sizing;
+};
+
+// Minimal, self-contained thread pool for workflow executor.
+// post() queues a fire-and-forget Task (no future, no allocation for small
+// captures); submit() adds a promise whose shared state comes from
+// PoolAllocator, so neither path goes through malloc once warmed up.
+// Work is queued in three priority lanes (see TaskOptions); each lane keeps
+// a queue-wait histogram. Workers can be pinned and grouped per NUMA node
+// (see PoolOptions). A worker that declares a BlockingRegion gets a
+// temporary compensation thread so the pool keeps `size()` runnable workers.
 class ThreadPool {
 public:
     explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+    explicit ThreadPool(const PoolOptions& options);
     ~ThreadPool();
 
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template<class F>
+    void post(F&& f);
+    template<class F>
+    void post(const TaskOptions& opts, F&& f);
+    // Leave `task` untouched if the pool refuses it (stopping).
+    void post(Task&& task) { enqueue(TaskOptions(), std::move(task)); }
+    void post(const TaskOptions& opts, Task&& task) { enqueue(opts, std::move(task)); }
+
     template<class F, class... Args>
     auto submit(F&& f, Args&&... args) -> std::future<typename std::result_of<F(Args...)>::type>;
+    template<class F, class... Args>
+    auto submit(const TaskOptions& opts, F&& f, Args&&... args)
+        -> std::future<typename std::result_of<F(Args...)>::type>;
 
     void shutdown();
 
+    // Runs one queued task on the calling thread, if any. Lets threads that
+    // wait on pool work help drain it instead of blocking.
+    bool tryRunOne();
+
+    // Core worker count; compensation threads come and go on top of it.
+    size_t size() const { return coreThreads_; }
+    size_t liveThreads() const { return live_.load(); }
+
+    // Time tasks of lane `p` spent queued, in nanoseconds.
+    HistogramSnapshot queueWait(Priority p) const {
+        HistogramSnapshot all;
+        for (const Shard* sh : shards_) all.merge(sh->lanes[static_cast<size_t>(p)].wait.snapshot());
+        return all;
+    }
+
+    // Per-worker counters and queue-wait/run-time histograms. Compensation
+    // threads and off-pool tryRunOne() callers are reported as `external`;
+    // a "steal" is a task taken from another NUMA shard.
+    PoolMetrics metrics() const;
+
+    // Number of queue shards (NUMA nodes in use, or 1).
+    size_t shardCount() const { return shards_.size(); }
+    // CPUs worker `i` is pinned to (empty if unpinned).
+    const std::vector<int>& workerCpus(size_t i) const { return placement_[i].cpus; }
+
+    // Index of the pool worker running the caller, or -1 off-pool.
+    // Compensation threads get indices from size() upwards.
+    static int currentWorker() { return workerIndex(); }
+
+    // Pool whose worker is running the caller, or nullptr.
+    static ThreadPool* current() { return currentPool(); }
+
+    // Called by BlockingRegion.
+    void enterBlocking();
+    void leaveBlocking();
+
 private:
-    void workerLoop();
+    using Clock = std::chrono::steady_clock;
 
-    std::vector<std::thread> workers_;
-    std::queue<std::function<void()>> tasks_;
-    std::mutex m_;
-    std::condition_variable cv_;
+    struct Entry {
+        Clock::time_point deadline;
+        uint64_t seq;
+        Clock::time_point queued;
+        Task task;
+    };
+    // Tasks with a deadline sit in a min-heap on (deadline, seq) and go
+    // first; the rest are FIFO in a ring. Both keep their capacity, so a
+    // warmed-up lane does not allocate, and take it from the shard's node.
+    using EntryAlloc = NodeAllocator<Entry>;
+    struct Lane {
+        explicit Lane(int memNode) : edf(EntryAlloc(memNode)), fifo(EntryAlloc(memNode)) {}
+
+        std::vector<Entry, EntryAlloc> edf;
+        RingQueue<Entry, EntryAlloc> fifo;
+        Histogram wait;
+
+        bool empty() const { return edf.empty() && fifo.empty(); }
+        Entry& head() { return edf.empty() ? fifo.front() : edf.front(); }
+    };
+    static bool later(const Entry& a, const Entry& b) {
+        return a.deadline != b.deadline ? a.deadline > b.deadline : a.seq > b.seq;
+    }
+
+    // One lock-protected set of lanes; one per NUMA node when numaAware.
+    struct Shard {
+        static_assert(kPriorityCount == 3, "one Lane initialiser per priority");
+        explicit Shard(int memNode)
+            : lanes{{Lane(memNode), Lane(memNode), Lane(memNode)}}, memNode(memNode) {}
+
+        std::mutex m;
+        std::array<Lane, kPriorityCount> lanes;
+        std::atomic<size_t> queued{0}; // written under m, peeked without it
+        uint64_t nextSeq = 0;
+        int node = 0;           // index into CpuTopology::system().nodes
+        int memNode = -1;       // node the shard and its lanes are allocated on
+        std::vector<int> order; // shards to take from, own first, then by distance
+    };
+
+    struct Placement {
+        std::vector<int> cpus;
+        size_t shard = 0;
+    };
+
+    template<class F, class... Args>
+    static Task makeSubmitTask(std::promise<typename std::result_of<F(Args...)>::type>& promise,
+                               F&& f, Args&&... args);
+    void plan(const PoolOptions& options, size_t threads);
+    size_t callerShard() const;
+    void enqueue(const TaskOptions& opts, Task&& task);
+    bool popLocked(Shard& sh, Task& out, Clock::time_point now);
+    bool popNearest(size_t shard, Task& out, Clock::time_point now, WorkerCounters* counters = nullptr);
+    struct WorkerSlot {
+        std::thread thread;
+        std::atomic<bool> exited{false};
+    };
+
+    bool spawnWorker();
+    bool retireIfSurplus();
+    Clock::time_point runOne(Task& task, int index, Clock::time_point start);
+    void workerLoop(int index, WorkerSlot* slot);
+    static int& workerIndex() { static thread_local int idx = -1; return idx; }
+    static ThreadPool*& currentPool() { static thread_local ThreadPool* pool = nullptr; return pool; }
+
+    std::mutex spawnMtx_;
+    std::vector<std::unique_ptr<WorkerSlot>> workers_; // guarded by spawnMtx_
+    std::vector<Placement> placement_;                 // one per core worker
+    size_t coreThreads_ = 0;
+    SizingPolicy sizing_;
+    std::atomic<size_t> live_{0};    // worker threads currently running
+    std::atomic<size_t> blocked_{0}; // of those, inside a BlockingRegion
+    int nextIndex_ = 0;              // guarded by spawnMtx_
+    std::vector<Shard*> shards_;
+    std::vector<int> shardOfNode_; // topology node index -> shard, or -1
+    std::chrono::microseconds aging_;
+
+    // Parking: producers only touch parkMtx_ when somebody sleeps.
+    std::atomic<size_t> totalQueued_{0};
+
+    // Metrics: one single-writer set per core worker, one shared set for
+    // everybody else.
+    std::unique_ptr<WorkerCounters[]> counters_;
+    std::unique_ptr<Histogram[]> runTime_;
+    WorkerCounters extraCounters_;
+    Histogram extraRunTime_;
+    Clock::time_point started_ = Clock::now();
+    std::atomic<int> sleepers_{0};
+    std::mutex parkMtx_;
+    std::condition_variable parkCv_;
     std::atomic<bool> stopping_{false};
 };
 
-inline ThreadPool::ThreadPool(size_t threads) {
+inline ThreadPool::ThreadPool(size_t threads)
+    : ThreadPool([threads]{ PoolOptions o; o.threads = threads; return o; }()) {}
+
+inline ThreadPool::ThreadPool(const PoolOptions& options)
+    : sizing_(options.sizing), aging_(options.aging) {
+    size_t threads = options.threads;
     if (threads == 0) threads = 2;
-    workers_.reserve(threads);
+    coreThreads_ = threads;
+    counters_.reset(new WorkerCounters[threads]);
+    runTime_.reset(new Histogram[threads]);
+    plan(options, threads);
+    for (size_t i = 0; i < threads; ++i) spawnWorker();
+}
+
+// Starts one more worker unless the pool is stopping or at its ceiling.
+// Exited workers are joined here, off the hot path.
+inline bool ThreadPool::spawnWorker() {
+    std::lock_guard<std::mutex> g(spawnMtx_);
+    if (stopping_) return false;
+    for (auto it = workers_.begin(); it != workers_.end();) {
+        if ((*it)->exited.load()) { (*it)->thread.join(); it = workers_.erase(it); }
+        else ++it;
+    }
+    if (live_.load() >= std::max(coreThreads_, sizing_.maxFor(coreThreads_))) return false;
+    live_.fetch_add(1);
+    auto slot = std::make_unique<WorkerSlot>();
+    WorkerSlot* raw = slot.get();
+    const int index = nextIndex_++;
+    try {
+        raw->thread = std::thread([this, index, raw]{ workerLoop(index, raw); });
+    } catch (...) {
+        live_.fetch_sub(1);
+        return false;
+    }
+    workers_.push_back(std::move(slot));
+    return true;
+}
+
+inline void ThreadPool::enterBlocking() {
+    const size_t blocked = blocked_.fetch_add(1) + 1;
+    // keep coreThreads_ runnable workers while this one waits
+    if (live_.load() - blocked < coreThreads_) spawnWorker();
+}
+
+inline void ThreadPool::leaveBlocking() {
+    blocked_.fetch_sub(1); // surplus threads retire once idle for sizing_.idleShrink
+}
+
+// Spreads workers round-robin over the NUMA nodes that have allowed CPUs,
+// and over the CPUs within each node; creates the queue shards.
+inline void ThreadPool::plan(const PoolOptions& options, size_t threads) {
+    const CpuTopology& topo = CpuTopology::system();
+    std::vector<std::vector<int>> allowed(topo.nodes.size());
+    std::vector<int> usedNodes;
+    for (size_t n = 0; n < topo.nodes.size(); ++n) {
+        for (int c : topo.nodes[n].cpus) {
+            if (options.cpus.empty() ||
+                std::find(options.cpus.begin(), options.cpus.end(), c) != options.cpus.end()) {
+                allowed[n].push_back(c);
+            }
+        }
+        if (!allowed[n].empty()) usedNodes.push_back(static_cast<int>(n));
+    }
+    if (usedNodes.empty()) { // requested CPUs unknown to the topology: pin as given
+        usedNodes.push_back(0);
+        allowed.assign(1, options.cpus);
+    }
+
+    shardOfNode_.assign(std::max<size_t>(1, topo.nodes.size()), -1);
+    const bool sharded = options.numaAware && usedNodes.size() > 1;
+    for (size_t k = 0; k < (sharded ? usedNodes.size() : 1); ++k) {
+        const int node = sharded ? usedNodes[k] : 0;
+        const int memNode = sharded ? node : -1;
+        void* mem = allocateOnNode(sizeof(Shard), memNode);
+        Shard* sh = ::new (mem) Shard(memNode);
+        sh->node = node;
+        shards_.push_back(sh);
+        if (sharded) shardOfNode_[static_cast<size_t>(node)] = static_cast<int>(k);
+    }
+    for (size_t k = 0; k < shards_.size(); ++k) {
+        if (!sharded) { shards_[k]->order = {0}; continue; }
+        for (int n : topo.nodesByDistance(shards_[k]->node)) {
+            if (shardOfNode_[static_cast<size_t>(n)] >= 0) shards_[k]->order.push_back(shardOfNode_[static_cast<size_t>(n)]);
+        }
+    }
+
+    placement_.resize(threads);
     for (size_t i = 0; i < threads; ++i) {
-        workers_.emplace_back([this]{ workerLoop(); });
+        const int node = usedNodes[i % usedNodes.size()];
+        const auto& cpus = allowed[static_cast<size_t>(node)];
+        Placement& p = placement_[i];
+        p.shard = sharded ? static_cast<size_t>(shardOfNode_[static_cast<size_t>(node)]) : 0;
+        if (options.affinity == Affinity::Core && !cpus.empty()) {
+            p.cpus = {cpus[(i / usedNodes.size()) % cpus.size()]};
+        } else if (options.affinity == Affinity::Node) {
+            p.cpus = cpus;
+        } else if (!options.cpus.empty()) {
+            p.cpus = options.cpus;
+        }
     }
 }
 
-inline ThreadPool::~ThreadPool() { shutdown(); }
+inline ThreadPool::~ThreadPool() {
+    shutdown();
+    for (Shard* sh : shards_) {
+        const int memNode = sh->memNode;
+        sh->~Shard();
+        freeOnNode(sh, sizeof(Shard), memNode);
+    }
+}
 
 inline void ThreadPool::shutdown() {
-    bool expected = false;
-    if (!stopping_.compare_exchange_strong(expected, true)) return;
-    cv_.notify_all();
-    for (auto& t : workers_) if (t.joinable()) t.join();
+    {
+        std::lock_guard<std::mutex> g(spawnMtx_); // no spawns after this
+        // Under every shard lock, so an outside enqueue either lands before
+        // the flag (and is drained) or sees it and throws.
+        std::vector<std::unique_lock<std::mutex>> shardLocks;
+        shardLocks.reserve(shards_.size());
+        for (Shard* sh : shards_) shardLocks.emplace_back(sh->m);
+        bool expected = false;
+        if (!stopping_.compare_exchange_strong(expected, true)) return;
+    }
+    {
+        std::lock_guard<std::mutex> g(parkMtx_);
+        parkCv_.notify_all();
+    }
+    std::vector<std::unique_ptr<WorkerSlot>> slots;
+    {
+        std::lock_guard<std::mutex> g(spawnMtx_);
+        slots.swap(workers_);
+    }
+    for (auto& slot : slots) if (slot->thread.joinable()) slot->thread.join();
 }
 
-inline void ThreadPool::workerLoop() {
-    for(;;) {
-        std::function<void()> task;
-        {
-            std::unique_lock<std::mutex> lk(m_);
-            cv_.wait(lk, [this]{ return stopping_ || !tasks_.empty(); });
-            if (stopping_ && tasks_.empty()) return;
-            task = std::move(tasks_.front());
-            tasks_.pop();
+inline size_t ThreadPool::callerShard() const {
+    if (shards_.size() == 1) return 0;
+    // The worker index is only meaningful for this pool's own workers.
+    const int self = currentPool() == this ? currentWorker() : -1;
+    if (self >= 0) return placement_[static_cast<size_t>(self) % placement_.size()].shard;
+    const int node = CpuTopology::system().nodeOf(currentCpu());
+    const int shard = node >= 0 ? shardOfNode_[static_cast<size_t>(node)] : -1;
+    return shard >= 0 ? static_cast<size_t>(shard) : 0;
+}
+
+inline void ThreadPool::enqueue(const TaskOptions& opts, Task&& task) {
+    // Own workers may still add work while draining; nobody else may.
+    if (stopping_ && currentPool() != this)
+        throw std::runtime_error("ThreadPool is stopping, cannot submit");
+    Shard& sh = *shards_[callerShard()];
+    {
+        std::lock_guard<std::mutex> g(sh.m);
+        // Again under the lock: shutdown() may have set the flag since, and
+        // its workers may already have drained and exited.
+        if (stopping_ && currentPool() != this)
+            throw std::runtime_error("ThreadPool is stopping, cannot submit");
+        auto& lane = sh.lanes[static_cast<size_t>(opts.priority)];
+        Entry e{opts.deadline, sh.nextSeq++, Clock::now(), std::move(task)};
+        if (opts.deadline == Clock::time_point::max()) {
+            lane.fifo.push(std::move(e));
+        } else {
+            lane.edf.push_back(std::move(e));
+            std::push_heap(lane.edf.begin(), lane.edf.end(), &ThreadPool::later);
+        }
+        sh.queued.fetch_add(1, std::memory_order_relaxed);
+        // Before the task can be popped (and the counters decremented).
+        totalQueued_.fetch_add(1);
+    }
+    if (sleepers_.load() > 0) {
+        std::lock_guard<std::mutex> g(parkMtx_);
+        parkCv_.notify_one();
+    }
+}
+
+// Takes the head of the most urgent lane, where a lane's urgency is its
+// priority raised by one step per `aging_` its head has been waiting.
+inline bool ThreadPool::popLocked(Shard& sh, Task& out, Clock::time_point now) {
+    if (sh.queued.load(std::memory_order_relaxed) == 0) return false;
+    size_t best = kPriorityCount;
+    long long bestRank = 0;
+    for (size_t i = 0; i < kPriorityCount; ++i) {
+        if (sh.lanes[i].empty()) continue;
+        long long rank = static_cast<long long>(i);
+        if (aging_.count() > 0) {
+            rank -= std::chrono::duration_cast<std::chrono::microseconds>(now - sh.lanes[i].head().queued).count()
+                    / aging_.count();
         }
+        if (best == kPriorityCount || rank < bestRank) { best = i; bestRank = rank; }
+    }
+    auto& lane = sh.lanes[best];
+    Clock::time_point queued;
+    if (!lane.edf.empty()) {
+        std::pop_heap(lane.edf.begin(), lane.edf.end(), &ThreadPool::later);
+        queued = lane.edf.back().queued;
+        out = std::move(lane.edf.back().task);
+        lane.edf.pop_back();
+    } else {
+        Entry e = lane.fifo.pop();
+        queued = e.queued;
+        out = std::move(e.task);
+    }
+    lane.wait.recordSerialized(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - queued).count()));
+    sh.queued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+// Own shard first, then the others nearest first; empty shards are
+// skipped without taking their lock.
+inline bool ThreadPool::popNearest(size_t shard, Task& out, Clock::time_point now, WorkerCounters* counters) {
+    for (int k : shards_[shard]->order) {
+        Shard& sh = *shards_[static_cast<size_t>(k)];
+        if (sh.queued.load(std::memory_order_relaxed) == 0) continue;
+        const bool remote = static_cast<size_t>(k) != shard;
+        if (remote && counters) WorkerCounters::bump(counters->stealAttempts);
+        std::lock_guard<std::mutex> g(sh.m);
+        if (popLocked(sh, out, now)) {
+            totalQueued_.fetch_sub(1, std::memory_order_relaxed);
+            if (remote && counters) WorkerCounters::bump(counters->steals);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns the end time, which the worker loop reuses as the next pop's
+// "now": with metrics always on, one clock read per task instead of three.
+inline ThreadPool::Clock::time_point ThreadPool::runOne(Task& task, int index, Clock::time_point start) {
+    // post()ed tasks have nobody to report to; submit() routes its
+    // exceptions through the promise before they get here.
+    try {
         task();
+    } catch (...) {
     }
+    const auto end = Clock::now();
+    const auto ran = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    if (index >= 0 && static_cast<size_t>(index) < coreThreads_) {
+        WorkerCounters& c = counters_[static_cast<size_t>(index)];
+        WorkerCounters::bump(c.tasks);
+        WorkerCounters::bump(c.busyNs, ran);
+        runTime_[static_cast<size_t>(index)].recordSerialized(ran);
+    } else {
+        WorkerCounters::add(extraCounters_.tasks);
+        WorkerCounters::add(extraCounters_.busyNs, ran);
+        extraRunTime_.record(ran);
+    }
+    return end;
+}
+
+inline bool ThreadPool::tryRunOne() {
+    Task task;
+    const auto now = Clock::now();
+    if (!popNearest(callerShard(), task, now)) return false;
+    runOne(task, currentPool() == this ? workerIndex() : -1, now);
+    return true;
+}
+
+inline PoolMetrics ThreadPool::metrics() const {
+    PoolMetrics m;
+    for (size_t i = 0; i < coreThreads_; ++i) {
+        m.workers.push_back(counters_[i].snapshot());
+        m.runTime.merge(runTime_[i].snapshot());
+    }
+    m.external = extraCounters_.snapshot();
+    m.runTime.merge(extraRunTime_.snapshot());
+    for (size_t p = 0; p < kPriorityCount; ++p) m.queueWait.merge(queueWait(static_cast<Priority>(p)));
+    m.queued = totalQueued_.load(std::memory_order_relaxed);
+    m.uptimeNs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started_).count());
+    return m;
+}
+
+inline void ThreadPool::workerLoop(int index, WorkerSlot* slot) {
+    workerIndex() = index;
+    currentPool() = this;
+    const Placement& where = placement_[static_cast<size_t>(index) % placement_.size()];
+    if (!where.cpus.empty()) pinCurrentThread(where.cpus); // best effort
+    // compensation threads share extraCounters_, whose writers are not serialised
+    WorkerCounters* mine = static_cast<size_t>(index) < coreThreads_ ? &counters_[static_cast<size_t>(index)] : nullptr;
+    IdleBackoff backoff(sizing_);
+    Clock::time_point now{};
+    bool fresh = false; // `now` was just read (end of the previous task)
+    for(;;) {
+        Task task;
+        if (!fresh) now = Clock::now();
+        fresh = false;
+        if (popNearest(where.shard, task, now, mine)) {
+            now = runOne(task, index, now);
+            fresh = true;
+            backoff.reset();
+            continue;
+        }
+        if (backoff.spin()) continue;
+        backoff.reset();
+
+        std::unique_lock<std::mutex> lk(parkMtx_);
+        sleepers_.fetch_add(1);
+        WorkerCounters& parkStats = mine ? *mine : extraCounters_;
+        WorkerCounters::add(parkStats.parks);
+        const bool woken = parkCv_.wait_for(lk, sizing_.idleShrink,
+            [this]{ return stopping_ || totalQueued_.load() != 0; });
+        WorkerCounters::add(parkStats.unparks);
+        sleepers_.fetch_sub(1);
+        if (stopping_ && totalQueued_.load() == 0) {
+            live_.fetch_sub(1);
+            break; // drained
+        }
+        // core workers own their counters_ and placement_ slots and never retire
+        if (!woken && static_cast<size_t>(index) >= coreThreads_ && retireIfSurplus()) break;
+    }
+    currentPool() = nullptr;
+    workerIndex() = -1;
+    slot->exited.store(true);
+}
+
+// A compensation worker that stayed parked for a whole idleShrink period
+// leaves if the pool has more unblocked threads than its core size.
+inline bool ThreadPool::retireIfSurplus() {
+    size_t live = live_.load();
+    while (live > coreThreads_ + blocked_.load()) {
+        if (live_.compare_exchange_weak(live, live - 1)) return true;
+    }
+    return false;
+}
+
+template<class F>
+void ThreadPool::post(F&& f) {
+    enqueue(TaskOptions(), Task(std::forward<F>(f)));
+}
+
+template<class F>
+void ThreadPool::post(const TaskOptions& opts, F&& f) {
+    enqueue(opts, Task(std::forward<F>(f)));
+}
+
+template<class F, class... Args>
+Task ThreadPool::makeSubmitTask(std::promise<typename std::result_of<F(Args...)>::type>& promise,
+                                F&& f, Args&&... args) {
+    using R = typename std::result_of<F(Args...)>::type;
+    return Task([p = std::move(promise), fn = std::forward<F>(f),
+                 args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+        try {
+            if constexpr (std::is_void<R>::value) {
+                std::apply(fn, std::move(args));
+                p.set_value();
+            } else {
+                p.set_value(std::apply(fn, std::move(args)));
+            }
+        } catch (...) {
+            p.set_exception(std::current_exception());
+        }
+    });
 }
 
 template<class F, class... Args>
 auto ThreadPool::submit(F&& f, Args&&... args)
     -> std::future<typename std::result_of<F(Args...)>::type>
+{
+    return submit(TaskOptions(), std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+template<class F, class... Args>
+auto ThreadPool::submit(const TaskOptions& opts, F&& f, Args&&... args)
+    -> std::future<typename std::result_of<F(Args...)>::type>
 {
     using R = typename std::result_of<F(Args...)>::type;
-    auto task = std::make_shared<std::packaged_task<R()>>(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
-    std::future<R> res = task->get_future();
-    {
-        std::lock_guard<std::mutex> g(m_);
-        tasks_.emplace([task]{ (*task)(); });
-    }
-    cv_.notify_one();
+    std::promise<R> promise(std::allocator_arg, PoolAllocator<char>());
+    std::future<R> res = promise.get_future();
+    enqueue(opts, makeSubmitTask(promise, std::forward<F>(f), std::forward<Args>(args)...));
     return res;
 }
 
-} // namespace rt
+// Marks the calling pool worker as blocked (waiting on a subprocess, a
+// socket, a lock held elsewhere...). While the region is open the pool may
+// start a compensation thread so its other queued work keeps running.
+// No-op off-pool.
+class BlockingRegion {
+public:
+    BlockingRegion() : pool_(ThreadPool::current()) {
+        if (pool_) pool_->enterBlocking();
+    }
+    ~BlockingRegion() {
+        if (pool_) pool_->leaveBlocking();
+    }
+    BlockingRegion(const BlockingRegion&) = delete;
+    BlockingRegion& operator=(const BlockingRegion&) = delete;
 
+private:
+    ThreadPool* pool_;
+};
+
+} // namespace rt
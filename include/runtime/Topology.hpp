@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace rt {
+
+// CPU/NUMA layout of the host as seen by this process. Read once from
+// sysfs on Linux (libnuma is only needed for node-local allocation);
+// elsewhere, or when sysfs is unavailable, everything is one node holding
+// all hardware threads.
+struct CpuTopology {
+    struct Node {
+        int id = 0;
+        std::vector<int> cpus;
+        std::vector<int> distance; // to every node, by index into `nodes`
+    };
+    std::vector<Node> nodes;
+
+    size_t cpuCount() const;
+    // Index into `nodes` of the node owning `cpu`, or -1.
+    int nodeOf(int cpu) const;
+    // Node indices ordered by distance from `node` (itself first).
+    std::vector<int> nodesByDistance(int node) const;
+
+    static const CpuTopology& system();
+};
+
+// Parses a sysfs-style CPU list such as "0-3,8,10-11".
+std::vector<int> parseCpuList(const std::string& text);
+
+// Restricts the calling thread to `cpus`. Returns false where unsupported
+// or when the OS refuses (e.g. CPUs outside the process's cgroup).
+bool pinCurrentThread(const std::vector<int>& cpus);
+
+// CPU the calling thread is running on, or -1 if unknown.
+int currentCpu();
+
+// Allocates `bytes` on NUMA node `node` (an index into
+// CpuTopology::system().nodes) in libnuma builds; otherwise plain
+// operator new, relying on first-touch placement by the node's workers.
+// node < 0 asks for plain operator new. Release with freeOnNode using the
+// same size and node, which picks the matching deallocator.
+void* allocateOnNode(size_t bytes, int node);
+void freeOnNode(void* p, size_t bytes, int node);
+
+// std::allocator-compatible front end over allocateOnNode, so containers
+// can keep their storage on a given node (-1: plain operator new).
+template<class T>
+struct NodeAllocator {
+    using value_type = T;
+
+    NodeAllocator() noexcept = default;
+    explicit NodeAllocator(int n) noexcept : node(n) {}
+    template<class U>
+    NodeAllocator(const NodeAllocator<U>& other) noexcept : node(other.node) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(allocateOnNode(n * sizeof(T), node)); }
+    void deallocate(T* p, size_t n) { freeOnNode(p, n * sizeof(T), node); }
+
+    template<class U>
+    bool operator==(const NodeAllocator<U>& other) const noexcept { return node == other.node; }
+    template<class U>
+    bool operator!=(const NodeAllocator<U>& other) const noexcept { return node != other.node; }
+
+    int node = -1;
+};
+
+} // namespace rt
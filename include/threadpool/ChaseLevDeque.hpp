@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace tp {
+
+// Lock-free single-owner work-stealing deque (Chase & Lev, 2005), with the
+// memory orderings from Le, Pop, Cohen & Zappa Nardelli, "Correct and
+// Efficient Work-Stealing for Weak Memory Models" (PPoPP'13).
+//
+// - push()/pop() may only be called by the owning thread; pop() is LIFO.
+// - steal() may be called by any thread and takes the oldest item (FIFO).
+// T must be trivially copyable (typically a pointer).
+template<class T>
+class ChaseLevDeque {
+    static_assert(std::is_trivially_copyable<T>::value, "ChaseLevDeque stores trivially copyable items");
+
+public:
+    explicit ChaseLevDeque(std::size_t capacity = 256) {
+        std::size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        auto a = std::make_unique<Array>(cap);
+        array_.store(a.get(), std::memory_order_relaxed);
+        arrays_.push_back(std::move(a));
+    }
+
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+    // Owner only.
+    void push(T item) {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        Array* a = array_.load(std::memory_order_relaxed);
+        if (b - t > static_cast<std::int64_t>(a->capacity) - 1) a = grow(a, t, b);
+        a->put(b, item);
+        // A release store rather than the paper's release fence + relaxed
+        // store: same cost on x86 and ARM, and visible to ThreadSanitizer,
+        // which does not model standalone fences.
+        bottom_.store(b + 1, std::memory_order_release);
+    }
+
+    // Owner only. Returns false when empty (or when a thief won the last item).
+    bool pop(T& out) {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Array* a = array_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        out = a->get(b);
+        if (t == b) {
+            // Last item: race against thieves for it.
+            bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // Any thread. Returns false when empty or when losing a race (caller may retry).
+    bool steal(T& out) {
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) return false;
+        Array* a = array_.load(std::memory_order_acquire);
+        T item = a->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return false;
+        }
+        out = item;
+        return true;
+    }
+
+    // Approximate; exact only when no concurrent operations are in flight.
+    std::size_t sizeApprox() const {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? static_cast<std::size_t>(b - t) : 0;
+    }
+
+    bool emptyApprox() const { return sizeApprox() == 0; }
+
+private:
+    struct Array {
+        explicit Array(std::size_t cap)
+            : capacity(cap), mask(cap - 1), slots(new std::atomic<T>[cap]) {}
+        T get(std::int64_t i) const {
+            return slots[static_cast<std::size_t>(i) & mask].load(std::memory_order_relaxed);
+        }
+        void put(std::int64_t i, T v) {
+            slots[static_cast<std::size_t>(i) & mask].store(v, std::memory_order_relaxed);
+        }
+        std::size_t capacity;
+        std::size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    Array* grow(Array* old, std::int64_t t, std::int64_t b) {
+        auto bigger = std::make_unique<Array>(old->capacity * 2);
+        for (std::int64_t i = t; i < b; ++i) bigger->put(i, old->get(i));
+        Array* raw = bigger.get();
+        // Thieves may still read the old array; keep it alive until destruction.
+        arrays_.push_back(std::move(bigger));
+        array_.store(raw, std::memory_order_release);
+        return raw;
+    }
+
+    alignas(64) std::atomic<std::int64_t> top_{0};
+    alignas(64) std::atomic<std::int64_t> bottom_{0};
+    alignas(64) std::atomic<Array*> array_{nullptr};
+    std::vector<std::unique_ptr<Array>> arrays_; // owner-only
+};
+
+} // namespace tp
@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace tp {
+
+// Eventcount: lets idle threads park on "something may have changed" without
+// a lock on the producer fast path. Usage on the waiting side:
+//
+//   auto key = ec.prepareWait();
+//   if (workAvailable()) { ec.cancelWait(); ...; }
+//   else ec.commitWait(key);
+//
+// Producers publish work first, then call notifyOne()/notifyAll(), which cost
+// a fence and a load when nobody is waiting.
+class EventCount {
+public:
+    using Key = std::uint32_t;
+
+    Key prepareWait() {
+        std::uint64_t prev = state_.fetch_add(kWaiterInc, std::memory_order_seq_cst);
+        return static_cast<Key>(prev >> kEpochShift);
+    }
+
+    void cancelWait() {
+        state_.fetch_sub(kWaiterInc, std::memory_order_seq_cst);
+    }
+
+    void commitWait(Key key) {
+        {
+            std::unique_lock<std::mutex> lk(m_);
+            cv_.wait(lk, [&]{
+                return static_cast<Key>(state_.load(std::memory_order_acquire) >> kEpochShift) != key;
+            });
+        }
+        state_.fetch_sub(kWaiterInc, std::memory_order_seq_cst);
+    }
+
+    void notifyOne() { notify(false); }
+    void notifyAll() { notify(true); }
+
+    std::uint32_t waiters() const {
+        return static_cast<std::uint32_t>(state_.load(std::memory_order_relaxed) & kWaiterMask);
+    }
+
+private:
+    void notify(bool all) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if ((state_.load(std::memory_order_relaxed) & kWaiterMask) == 0) return;
+        state_.fetch_add(kEpochInc, std::memory_order_seq_cst);
+        // Empty critical section orders the epoch bump against a waiter that
+        // has checked its predicate but not yet blocked.
+        { std::lock_guard<std::mutex> g(m_); }
+        if (all) cv_.notify_all();
+        else cv_.notify_one();
+    }
+
+    static constexpr int kEpochShift = 32;
+    static constexpr std::uint64_t kWaiterInc = 1;
+    static constexpr std::uint64_t kWaiterMask = (std::uint64_t(1) << kEpochShift) - 1;
+    static constexpr std::uint64_t kEpochInc = std::uint64_t(1) << kEpochShift;
+
+    std::atomic<std::uint64_t> state_{0}; // [epoch:32 | waiters:32]
+    std::mutex m_;
+    std::condition_variable cv_;
+};
+
+} // namespace tp
@@ -0,0 +1,166 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "threadpool/ChaseLevDeque.hpp"
+#include "threadpool/EventCount.hpp"
+#include "runtime/Histogram.hpp"
+#include "runtime/PoolMetrics.hpp"
+
+namespace tp {
+
+template<class T>
+using Optional = std::optional<T>;
+
+// Work-stealing thread pool.
+// - Each worker owns a lock-free Chase-Lev deque: it pops its own work LIFO
+//   (cache-warm), idle workers steal FIFO from the other end.
+// - submit() from a worker of this pool pushes onto that worker's deque;
+//   submissions from outside go through a shared injection queue.
+// - Idle workers park on an EventCount, so producers never take a lock
+//   just to wake somebody.
+// - Every worker keeps its own counters and queue-wait/run-time
+//   histograms (single writer, no shared cache lines); metrics() merges them.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads = 0); // 0 = hardware_concurrency
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template<class F, class... Args>
+    auto submit(F&& f, Args&&... args) -> std::future<typename std::result_of<F(Args...)>::type>;
+
+    // Like submit() but returns an empty Optional instead of throwing when the
+    // pool is shutting down.
+    template<class F, class... Args>
+    auto try_submit(F&& f, Args&&... args) -> Optional<std::future<typename std::result_of<F(Args...)>::type>>;
+
+    // Fire-and-forget: no future, exceptions are swallowed. Throws like
+    // submit() when the pool is stopping.
+    template<class F>
+    void post(F&& f);
+
+    // Runs one queued task on the calling thread, if any: a worker of this
+    // pool takes from its own deque first, any other thread from the
+    // injection queue or by stealing. Lets waiters help instead of blocking.
+    bool tryRunOne();
+
+    // Runs queued tasks, then joins the workers. Idempotent.
+    void shutdown();
+
+    // Drains the pool and restarts it with `threads` workers. Must not race
+    // with submit().
+    void resize(size_t threads);
+
+    size_t size() const;
+    // Approximate while workers run (atomic reads of each queue's bounds).
+    size_t queueSize() const;
+    uint64_t completedTaskCount() const;
+
+    // Counters and histograms since the last start()/resize(). Render with
+    // PoolMetrics::toJson()/toPrometheus() (in spf_runtime).
+    rt::PoolMetrics metrics() const;
+
+    // Index of the calling worker in this pool, or -1 when called from outside.
+    int currentWorker() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Task {
+        template<class F>
+        explicit Task(F&& f) : fn(std::forward<F>(f)) {}
+        std::function<void()> fn;
+        Clock::time_point queued; // stamped by enqueue()
+    };
+
+    struct Worker {
+        ChaseLevDeque<Task*> deque;
+        std::thread thread;
+        std::uint64_t rng = 0;
+        rt::WorkerCounters counters; // written by this worker only
+        rt::Histogram wait, run;
+    };
+
+    // Outside callers are refused once shutdown starts; workers may still
+    // spawn subtasks, which are drained before the workers exit.
+    bool acceptsWork() const {
+        return !stopping_.load(std::memory_order_acquire) || currentWorker() >= 0;
+    }
+    void start(size_t threads);
+    void enqueue(Task* task);
+    Task* findTask(size_t id);
+    Task* findExternal();
+    Task* steal(std::uint64_t& rng, size_t skip);
+    Clock::time_point runTask(Task* task, Worker* self, Clock::time_point start);
+    void workerLoop(size_t id);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    std::mutex injectMtx_;
+    std::deque<Task*> inject_;
+    std::atomic<size_t> injectSize_{0};
+
+    EventCount idle_;
+    std::atomic<bool> stopping_{false};
+    std::atomic<uint64_t> completedTasks_{0};
+    std::atomic<uint64_t> totalTasks_{0};
+
+    // Tasks run by non-worker threads through tryRunOne().
+    rt::WorkerCounters externalCounters_;
+    rt::Histogram externalWait_, externalRun_;
+    Clock::time_point started_;
+};
+
+template<class F, class... Args>
+auto ThreadPool::submit(F&& f, Args&&... args)
+    -> std::future<typename std::result_of<F(Args...)>::type>
+{
+    using R = typename std::result_of<F(Args...)>::type;
+    if (!acceptsWork())
+        throw std::runtime_error("ThreadPool is stopping, cannot submit");
+    auto taskPtr = std::make_shared<std::packaged_task<R()>>(
+        std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+    std::future<R> res = taskPtr->get_future();
+    enqueue(new Task([taskPtr]{ (*taskPtr)(); }));
+    return res;
+}
+
+template<class F>
+void ThreadPool::post(F&& f) {
+    if (!acceptsWork())
+        throw std::runtime_error("ThreadPool is stopping, cannot submit");
+    enqueue(new Task(std::forward<F>(f)));
+}
+
+template<class F, class... Args>
+auto ThreadPool::try_submit(F&& f, Args&&... args)
+    -> Optional<std::future<typename std::result_of<F(Args...)>::type>>
+{
+    using R = typename std::result_of<F(Args...)>::type;
+    if (!acceptsWork()) return Optional<std::future<R>>();
+    auto taskPtr = std::make_shared<std::packaged_task<R()>>(
+        std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+    std::future<R> res = taskPtr->get_future();
+    try {
+        enqueue(new Task([taskPtr]{ (*taskPtr)(); }));
+    } catch (const std::runtime_error&) {
+        return Optional<std::future<R>>(); // shutdown() won the race
+    }
+    return Optional<std::future<R>>(std::move(res));
+}
+
+} // namespace tp
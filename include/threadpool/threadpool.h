@@ -1,9 +1,8 @@
 #ifndef THREADPOOL_H
 #define THREADPOOL_H
 
-#include <iostream>
+#include <algorithm>
 #include <vector>
-#include <queue>
 #include <memory>
 #include <atomic>
 #include <mutex>
@@ -12,10 +11,16 @@
 #include <unordered_map>
 #include <thread>
 #include <future>
+#include <optional>
+#include <stdexcept>
+#include <string>
 
-const int TASK_MAX_THRESHHOLD = 2; // INT32_MAX;
+#include "runtime/MpmcQueue.hpp"
+#include "runtime/SizingPolicy.hpp"
+
+const int TASK_MAX_THRESHHOLD = 1024; // ȡ 2 ݣ
 const int THREAD_MAX_THRESHHOLD = 1024;
-const int THREAD_MAX_IDLE_TIME = 60; // λ
+const int THREAD_MAX_IDLE_TIME = 60; // λ룬cached ģʽĬϵ idleShrink
 
 
 // ֵ̳֧߳ģʽ
@@ -25,6 +30,20 @@ enum class PoolMode
 	MODE_CACHED, // ߳ɶ̬
 };
 
+// ̳߳δʱύʧܵĴ
+class TaskRejected : public std::runtime_error
+{
+public:
+	using std::runtime_error::runtime_error;
+};
+
+// ύʧʱĴʽ
+enum class RejectPolicy
+{
+	FAIL_FUTURE, // һ TaskRejected 쳣 futureget() ʱ׳
+	THROW,       // submitTask ֱ׳ TaskRejected
+};
+
 // ߳
 class Thread
 {
@@ -68,14 +87,18 @@ public:
 	// ̳߳ع
 	ThreadPool()
 		: initThreadSize_(0)
-		, taskSize_(0)
-		, idleThreadSize_(0)
+		, threadSizeThreshHold_(THREAD_MAX_THRESHHOLD)
 		, curThreadSize_(0)
+		, idleThreadSize_(0)
+		, taskSize_(0)
 		, taskQueMaxThreshHold_(TASK_MAX_THRESHHOLD)
-		, threadSizeThreshHold_(THREAD_MAX_THRESHHOLD)
 		, poolMode_(PoolMode::MODE_FIXED)
+		, rejectPolicy_(RejectPolicy::FAIL_FUTURE)
+		, submitTimeout_(std::chrono::seconds(1))
 		, isPoolRunning_(false)
-	{}
+	{
+		sizing_.idleShrink = std::chrono::seconds(THREAD_MAX_IDLE_TIME);
+	}
 
 	// ̳߳
 	~ThreadPool()
@@ -96,7 +119,7 @@ public:
 		poolMode_ = mode;
 	}
 
-	// taskֵ
+	// taskֵζе
 	void setTaskQueMaxThreshHold(int threshhold)
 	{
 		if (checkRunningState())
@@ -115,61 +138,73 @@ public:
 		}
 	}
 
+	// ÿ/ԣ߳ó spinRounds ˯ߣcached ģʽ߳
+	//  maxFor(ʼ߳)  setThreadSizeThreshHold ĽСߣ
+	// г idleShrink Ķ߳˳
+	void setSizingPolicy(const rt::SizingPolicy& policy)
+	{
+		if (checkRunningState())
+			return;
+		sizing_ = policy;
+	}
+
+	// ύʧʱĴʽ
+	void setRejectPolicy(RejectPolicy policy)
+	{
+		rejectPolicy_ = policy;
+	}
+
+	//  submitTask ڶʱ
+	void setSubmitTimeout(std::chrono::milliseconds timeout)
+	{
+		submitTimeout_ = timeout;
+	}
+
 	// ̳߳ύ
 	// ʹÿɱģ̣submitTaskԽĲ
 	// pool.submitTask(sum1, 10, 20);   csdn  ؿ  ֵ+۵ԭ
 	// ֵfuture<>
+	// ʱ submitTimeout_Ȼ rejectPolicy_ ᷵ؼٽ
 	template<typename Func, typename... Args>
 	auto submitTask(Func&& func, Args&&... args) -> std::future<decltype(func(args...))>
 	{
-		// 񣬷
+		return submitTaskFor(submitTimeout_, std::forward<Func>(func), std::forward<Args>(args)...);
+	}
+
+	// ͬ submitTaskʱ timeout
+	template<typename Rep, typename Period, typename Func, typename... Args>
+	auto submitTaskFor(std::chrono::duration<Rep, Period> timeout, Func&& func, Args&&... args)
+		-> std::future<decltype(func(args...))>
+	{
 		using RType = decltype(func(args...));
-		auto task = std::make_shared<std::packaged_task<RType()>>(
-			std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+		auto task = makeTask(std::forward<Func>(func), std::forward<Args>(args)...);
 		std::future<RType> result = task->get_future();
-
-		// ȡ
-		std::unique_lock<std::mutex> lock(taskQueMtx_);
-		// ûύ1sжύʧܣ
-		if (!notFull_.wait_for(lock, std::chrono::seconds(1),
-			[&]()->bool { return taskQue_.size() < (size_t)taskQueMaxThreshHold_; }))
+		const auto deadline = std::chrono::steady_clock::now()
+			+ std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+		if (pushTask([task]() {(*task)(); }, deadline))
 		{
-			// ʾnotFull_ȴ1s֣Ȼû
-			std::cerr << "task queue is full, submit task fail." << std::endl;
-			auto task = std::make_shared<std::packaged_task<RType()>>(
-				[]()->RType { return RType(); });
-			(*task)();
-			return task->get_future();
+			return result;
 		}
 
-		// п࣬
-		// taskQue_.emplace(sp);  
-		// using Task = std::function<void()>;
-		taskQue_.emplace([task]() {(*task)();});
-		taskSize_++;
-
-		// Ϊ·п϶ˣnotEmpty_Ͻ֪ͨϿִ߳
-		notEmpty_.notify_all();
-
-		// cachedģʽ ȽϽ С ҪͿ̵߳жǷҪµ̳߳
-		if (poolMode_ == PoolMode::MODE_CACHED
-			&& taskSize_ > idleThreadSize_
-			&& curThreadSize_ < threadSizeThreshHold_)
+		if (rejectPolicy_ == RejectPolicy::THROW)
 		{
-			std::cout << ">>> create new thread..." << std::endl;
-
-			// µ̶߳
-			auto ptr = std::make_unique<Thread>(std::bind(&ThreadPool::threadFunc, this, std::placeholders::_1));
-			int threadId = ptr->getId();
-			threads_.emplace(threadId, std::move(ptr));
-			// ߳
-			threads_[threadId]->start();
-			// ޸̸߳صı
-			curThreadSize_++;
-			idleThreadSize_++;
+			throw TaskRejected(rejectReason());
 		}
+		std::promise<RType> failed;
+		failed.set_exception(std::make_exception_ptr(TaskRejected(rejectReason())));
+		return failed.get_future();
+	}
 
-		// Result
+	// ύ̳߳δʱ std::nullopt
+	template<typename Func, typename... Args>
+	auto trySubmitTask(Func&& func, Args&&... args) -> std::optional<std::future<decltype(func(args...))>>
+	{
+		auto task = makeTask(std::forward<Func>(func), std::forward<Args>(args)...);
+		auto result = task->get_future();
+		if (!pushTask([task]() {(*task)(); }, std::chrono::steady_clock::time_point::min()))
+		{
+			return std::nullopt;
+		}
 		return result;
 	}
 
@@ -179,6 +214,9 @@ public:
 		// ̳߳ص״̬
 		isPoolRunning_ = true;
 
+		// нУʱ̶
+		taskQue_ = std::make_unique<rt::MpmcQueue<Task>>(static_cast<size_t>(std::max(1, taskQueMaxThreshHold_)));
+
 		// ¼ʼ̸߳
 		initThreadSize_ = initThreadSize;
 		curThreadSize_ = initThreadSize;
@@ -193,10 +231,10 @@ public:
 			// threads_.emplace_back(std::move(ptr));
 		}
 
-		// ߳  std::vector<Thread*> threads_;
-		for (int i = 0; i < initThreadSize_; i++)
+		// ̣߳߳idȫֵһ0ʼmap
+		for (auto& entry : threads_)
 		{
-			threads_[i]->start(); // Ҫȥִһ̺߳
+			entry.second->start(); // Ҫȥִһ̺߳
 			idleThreadSize_++;    // ¼ʼ̵߳
 		}
 	}
@@ -205,91 +243,150 @@ public:
 	ThreadPool& operator=(const ThreadPool&) = delete;
 
 private:
+	using Task = std::function<void()>;
+
+	template<typename Func, typename... Args>
+	static auto makeTask(Func&& func, Args&&... args)
+	{
+		// 񣬷
+		using RType = decltype(func(args...));
+		return std::make_shared<std::packaged_task<RType()>>(
+			std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+	}
+
+	std::string rejectReason() const
+	{
+		return taskQue_ ? "task queue is full, submit task fail." : "thread pool is not started";
+	}
+
+	// Уʱ notFull_ ϵȵ deadlineʱ false
+	bool pushTask(Task&& task, std::chrono::steady_clock::time_point deadline)
+	{
+		if (!taskQue_)
+			return false;
+		while (!taskQue_->tryPush(std::move(task)))
+		{
+			if (std::chrono::steady_clock::now() >= deadline)
+				return false;
+			std::unique_lock<std::mutex> lock(taskQueMtx_);
+			fullWaiters_++;
+			notFull_.wait_until(lock, deadline,
+				[&]()->bool { return taskSize_ < (int)taskQue_->capacity(); });
+			fullWaiters_--;
+		}
+		taskSize_++;
+
+		// Ϊ·п϶ˣֻ߳˯ʱҪ
+		if (emptyWaiters_ > 0)
+		{
+			std::lock_guard<std::mutex> lock(taskQueMtx_);
+			notEmpty_.notify_one();
+		}
+
+		// cachedģʽ ȽϽ С
+		// ֻûп߳ʱݣп߳̾ͽÿύ߳
+		if (poolMode_ == PoolMode::MODE_CACHED
+			&& idleThreadSize_ == 0
+			&& curThreadSize_ < threadCeiling())
+		{
+			std::lock_guard<std::mutex> lock(taskQueMtx_);
+			if (idleThreadSize_ == 0 && curThreadSize_ < threadCeiling())
+			{
+				// µ̶߳
+				auto ptr = std::make_unique<Thread>(std::bind(&ThreadPool::threadFunc, this, std::placeholders::_1));
+				int threadId = ptr->getId();
+				threads_.emplace(threadId, std::move(ptr));
+				// ߳
+				threads_[threadId]->start();
+				// ޸̸߳صı
+				curThreadSize_++;
+				idleThreadSize_++;
+			}
+		}
+		return true;
+	}
+
+	// cached ģʽ߳
+	int threadCeiling() const
+	{
+		const auto core = static_cast<size_t>(std::max(0, initThreadSize_));
+		const auto ceiling = std::max(core, sizing_.maxFor(core));
+		return static_cast<int>(std::min(ceiling, static_cast<size_t>(threadSizeThreshHold_)));
+	}
+
 	// ̺߳
 	void threadFunc(int threadid)
 	{
-		auto lastTime = std::chrono::high_resolution_clock().now();
+		auto lastTime = std::chrono::steady_clock::now();
+		rt::IdleBackoff backoff(sizing_);
 
 		// ִɣ̳߳زſԻ߳Դ
 		for (;;)
 		{
 			Task task;
+			// ȡ񲻼пʱó֣Ȼղ˯
+			if (!taskQue_->tryPop(task))
 			{
-				// Ȼȡ
-				std::unique_lock<std::mutex> lock(taskQueMtx_);
+				if (backoff.spin())
+					continue;
+				backoff.reset();
 
-				std::cout << "tid:" << std::this_thread::get_id()
-					<< "Իȡ..." << std::endl;
+				std::unique_lock<std::mutex> lock(taskQueMtx_);
 
-				// cachedģʽ£пѾ˺̣ܶ߳ǿʱ䳬60sӦðѶ߳
+				// cachedģʽ£пѾ˺̣ܶ߳ǿʱ䳬 idleShrinkӦðѶ߳
 				// յinitThreadSize_߳Ҫлգ
-				// ǰʱ - һִ߳еʱ > 60s
-
-				// ÿһзһ   ô֣ʱأִз
-				//  + ˫ж
-				while (taskQue_.size() == 0)
+				// ÿѯֱӵȵ lastTime + idleShrinkڼŻᱻ
+				emptyWaiters_++;
+				auto ready = [&]()->bool { return taskSize_ > 0 || !isPoolRunning_; };
+				bool woken = true;
+				if (poolMode_ == PoolMode::MODE_CACHED)
 				{
-					// ̳߳Ҫ߳Դ
-					if (!isPoolRunning_)
-					{
-						threads_.erase(threadid); // std::this_thread::getid()
-						std::cout << "threadid:" << std::this_thread::get_id() << " exit!"
-							<< std::endl;
-						exitCond_.notify_all();
-						return; // ̺߳߳̽
-					}
-
-					if (poolMode_ == PoolMode::MODE_CACHED)
-					{
-						// ʱ
-						if (std::cv_status::timeout ==
-							notEmpty_.wait_for(lock, std::chrono::seconds(1)))
-						{
-							auto now = std::chrono::high_resolution_clock().now();
-							auto dur = std::chrono::duration_cast<std::chrono::seconds>(now - lastTime);
-							if (dur.count() >= THREAD_MAX_IDLE_TIME
-								&& curThreadSize_ > initThreadSize_)
-							{
-								// ʼյǰ߳
-								// ¼߳رֵ޸
-								// ̶߳߳бɾ   ûа취 threadFunc=thread
-								// threadid => thread => ɾ
-								threads_.erase(threadid); // std::this_thread::getid()
-								curThreadSize_--;
-								idleThreadSize_--;
-
-								std::cout << "threadid:" << std::this_thread::get_id() << " exit!"
-									<< std::endl;
-								return;
-							}
-						}
-					}
-					else
-					{
-						// ȴnotEmpty
-						notEmpty_.wait(lock);
-					}
+					woken = notEmpty_.wait_until(lock, lastTime + sizing_.idleShrink, ready);
 				}
+				else
+				{
+					notEmpty_.wait(lock, ready);
+				}
+				emptyWaiters_--;
 
-				idleThreadSize_--;
-
-				std::cout << "tid:" << std::this_thread::get_id()
-					<< "ȡɹ..." << std::endl;
+				if (taskSize_ > 0)
+					continue; // 񣬻ȥȡ
 
-				// ȡһ
-				task = taskQue_.front();
-				taskQue_.pop();
-				taskSize_--;
+				// ̳߳Ҫ߳Դ
+				if (!isPoolRunning_)
+				{
+					threads_.erase(threadid); // std::this_thread::getid()
+					exitCond_.notify_all();
+					return; // ̺߳߳̽
+				}
 
-				// Ȼʣ񣬼ִ֪ͨ߳
-				if (taskQue_.size() > 0)
+				if (!woken)
 				{
-					notEmpty_.notify_all();
+					if (curThreadSize_ > initThreadSize_)
+					{
+						// ʼյǰ߳
+						// ̶߳߳бɾ   ûа취 threadFunc=thread
+						// threadid => thread => ɾ
+						threads_.erase(threadid); // std::this_thread::getid()
+						curThreadSize_--;
+						idleThreadSize_--;
+						return;
+					}
+					lastTime = std::chrono::steady_clock::now(); // ̲߳գ¼ʱ
 				}
+				continue;
+			}
+
+			backoff.reset();
+			idleThreadSize_--;
+			taskSize_--;
 
-				// ȡһ񣬽֪֪ͨͨԼύ
-				notFull_.notify_all();
-			} // Ӧðͷŵ
+			// ȡһ֪ͨԼύ
+			if (fullWaiters_ > 0)
+			{
+				std::lock_guard<std::mutex> lock(taskQueMtx_);
+				notFull_.notify_one();
+			}
 
 			// ǰ̸ִ߳
 			if (task != nullptr)
@@ -298,7 +395,7 @@ private:
 			}
 
 			idleThreadSize_++;
-			lastTime = std::chrono::high_resolution_clock().now(); // ִ߳ʱ
+			lastTime = std::chrono::steady_clock::now(); // ִ߳ʱ
 		}
 	}
 
@@ -317,17 +414,21 @@ private:
 	std::atomic_int idleThreadSize_; // ¼̵߳
 
 	// Task = 
-	using Task = std::function<void()>;
-	std::queue<Task> taskQue_; // 
+	std::unique_ptr<rt::MpmcQueue<Task>> taskQue_; // Ун磬start() ʱ
 	std::atomic_int taskSize_; // 
 	int taskQueMaxThreshHold_;  // ֵ
 
-	std::mutex taskQueMtx_; // ֤е̰߳ȫ
+	std::mutex taskQueMtx_; // ֻ˯/Ѻ߳б
+	std::atomic_int emptyWaiters_{0}; //  notEmpty_ ˯ߵ߳
+	std::atomic_int fullWaiters_{0};  //  notFull_ ϵȴύ
 	std::condition_variable notFull_; // ʾв
 	std::condition_variable notEmpty_; // ʾв
 	std::condition_variable exitCond_; // ȵ߳Դȫ
 
 	PoolMode poolMode_; // ǰ̳߳صĹģʽ
+	rt::SizingPolicy sizing_; // cached ģʽĿʱ
+	RejectPolicy rejectPolicy_; // ύʧʱĴʽ
+	std::chrono::milliseconds submitTimeout_; // submitTask ʱʱ
 	std::atomic_bool isPoolRunning_; // ʾǰ̳߳ص״̬
 };
 
@@ -17,6 +17,9 @@ struct Task {
     TaskStatus status;
 };
 
+// Format a progress bar "[####----]  42%" for percent [0..100].
+std::string formatProgressBar(int percent, int width = 40);
+
 // Print a horizontal progress bar for percent [0..100]. Does not add a newline.
 void printProgressBar(int percent, int width = 40);
 
@@ -0,0 +1,105 @@
+#ifndef DASHBOARD_HPP
+#define DASHBOARD_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "runtime/EventBus.hpp"
+
+namespace ui {
+
+// Live multi-task view driven by executor events.
+// Event handlers only append a small record under a short lock; the renderer
+// swaps the whole batch out in O(1) and folds it into its own view, so
+// workers never wait for a frame to be built. A dedicated render thread
+// redraws at most `maxFps` times per second, building each frame in memory
+// and emitting it with a single write.
+class Dashboard {
+public:
+    struct Options {
+        int maxFps = 10;
+        int barWidth = 40;
+        std::size_t maxRunningRows = 8; // running tasks listed individually
+        bool ansi = true;               // redraw in place with ANSI cursor moves
+    };
+
+    explicit Dashboard(rt::EventBus& bus);
+    Dashboard(rt::EventBus& bus, Options opt);
+    Dashboard(rt::EventBus& bus, Options opt, std::ostream& out);
+    ~Dashboard();
+
+    Dashboard(const Dashboard&) = delete;
+    Dashboard& operator=(const Dashboard&) = delete;
+
+    // Start/stop the render thread. stop() draws a final frame.
+    void start();
+    void stop();
+
+    // Build the current frame text (no cursor control). Thread-safe.
+    std::string renderFrame() const;
+
+private:
+    using Clock = rt::EventClock;
+
+    struct Running {
+        Clock::time_point since;
+        int worker = -1;
+    };
+
+    // One event as recorded by a handler.
+    struct Update {
+        rt::EventKind kind;
+        Clock::time_point ts;
+        std::string id;
+        int worker = -1;
+        bool success = true;
+        std::size_t total = 0;
+    };
+
+    struct State {
+        std::size_t total = 0;
+        std::size_t queued = 0;
+        std::size_t done = 0;
+        std::size_t failed = 0;
+        bool started = false;
+        bool finished = false;
+        Clock::time_point startTs;
+        Clock::time_point lastTs;
+        std::map<std::string, Running> running;
+    };
+
+    void record(Update u);
+    // Folds the recorded updates into view_; caller holds viewMtx_.
+    void refresh() const;
+    void renderLoop();
+    static std::string format(const State& s, const Options& opt, Clock::time_point now);
+
+    rt::EventBus& bus_;
+    Options opt_;
+    std::ostream& out_;
+    std::vector<rt::EventBus::SubscriptionId> subs_;
+
+    mutable std::mutex pendingMtx_; // held by handlers for one push_back
+    mutable std::vector<Update> pending_;
+    mutable std::mutex viewMtx_;    // render side only
+    mutable std::vector<Update> drained_;
+    mutable State view_;
+    std::atomic<bool> dirty_{false};
+
+    std::mutex renderMtx_;
+    std::condition_variable renderCv_;
+    bool stopping_ = false;
+    std::thread renderThread_;
+    std::size_t lastLines_ = 0;
+};
+
+} // namespace ui
+
+#endif // DASHBOARD_HPP
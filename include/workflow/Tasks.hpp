@@ -4,6 +4,7 @@
 #include "workflow/ITask.hpp"
 #include "workflow/ITaskContext.hpp"
 #include "runtime/Services.hpp"
+#include "runtime/ThreadPool.hpp"
 #include <cstdlib>
 
 namespace wf {
@@ -54,7 +55,11 @@ public:
 
         // POSIX：bash -lc 执行；Windows 可切换到 "cmd /C"
         std::string shellCmd = "bash -lc " + quote(cmd);
-        int rc = std::system(shellCmd.c_str());
+        int rc;
+        {
+            rt::BlockingRegion blocking; // pool may add a worker while we wait on the child
+            rc = std::system(shellCmd.c_str());
+        }
         if (rc != 0) return {false, "shell exit != 0"};
 
         // 4) 输出校验与写回上下文
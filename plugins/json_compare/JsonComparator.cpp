@@ -1,5 +1,8 @@
 // plugins/json_compare/JsonCompare.cpp
 #include "core/IComparator.hpp"
+#include "core/JsonArena.hpp"
+#include "core/JsonCodec.hpp"
+#include "runtime/MappedFile.hpp"
 #include "core/PluginManager.hpp"    // 现阶段沿用你的框架，仍用 registerPlugin 入口
 #include <nlohmann/json.hpp>
 
@@ -10,7 +13,7 @@
 #include <sstream>
 #include <memory>
 
-using json = nlohmann::ordered_json;  // ★ 保持对象键的插入顺序
+using json = core::ArenaJson;  // ★ 保持对象键的插入顺序
 
 namespace {
 
@@ -204,15 +207,26 @@ public:
     bool compareFiles(const std::string& oursPath,
                       const std::string& goldenPath,
                       const std::string& outPath) override {
+        // both trees and the report temporaries live in one arena per call
+        JsonArena arena;
+        JsonArena::Scope scope(&arena);
         json L, R;
         try{
-            std::ifstream fl(oursPath), fr(goldenPath);
-            if(!fl || !fr){
+            // 直接从只读映射解析，不经过 istream
+            rt::MappedFile fl, fr;
+            if(!fl.openRead(oursPath, rt::MappedFile::Access::Sequential) ||
+               !fr.openRead(goldenPath, rt::MappedFile::Access::Sequential)){
                 std::cerr << "[JsonComparator] 打开文件失败: "
                           << oursPath << " / " << goldenPath << "\n";
                 return false;
             }
-            fl >> L; fr >> R;
+            // 输入可以是 JSON 文本或 CBOR/MessagePack/UBJSON/BSON
+            std::string error;
+            if(!decodeJson(fl.data(), fl.data() + fl.size(), inputFormat_, L, error) ||
+               !decodeJson(fr.data(), fr.data() + fr.size(), inputFormat_, R, error)){
+                std::cerr << "[JsonComparator] 解析失败: " << error << "\n";
+                return false;
+            }
         }catch(const std::exception& e){
             std::cerr << "[JsonComparator] 解析失败: " << e.what() << "\n";
             return false;
@@ -233,6 +247,11 @@ public:
 
 		return true;
     }
+
+    void setInputFormat(JsonFormat format) override { inputFormat_ = format; }
+
+private:
+    JsonFormat inputFormat_ = JsonFormat::Auto;
 };
 
 } // namespace core
@@ -1,9 +1,72 @@
 #pragma once
 #include "core/IObject.hpp"
+#include "core/JsonFormat.hpp"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <ostream>
 #include <string>
+#include <vector>
 
 namespace core {
 
+// A parsed JSON document. Handles are immutable, so one document can be
+// queried any number of times (and from several threads) without being
+// parsed again; mutating operations return a new handle that shares the
+// untouched parts of the tree with this one.
+class IJsonDocument {
+public:
+    virtual ~IJsonDocument() = default;
+
+    // Same report as IJsonProcess::processJsonFiles on the original content,
+    // in the output format the document was parsed under.
+    virtual bool process(std::string& outContent,
+                         const std::string& keywords,
+                         const std::string& processMethod) const = 0;
+
+    // Same report serialized straight into `out` as it is produced, without
+    // building it in memory first; indent < 0 gives the compact form. On
+    // failure `out` may hold a partial report.
+    virtual bool process(std::ostream& out,
+                         const std::string& keywords,
+                         const std::string& processMethod,
+                         int indent = 4) const = 0;
+
+    // "find": values along `path` (`a/b/c`, arrays are expanded).
+    virtual bool find(const std::string& path, std::string& outContent) const = 0;
+
+    // "findBatch": every path in one traversal (paths sharing a prefix
+    // share its work); results are reported per path, in request order.
+    // processMethod "findBatch" takes the paths `;`-separated.
+    virtual bool findBatch(const std::vector<std::string>& paths, std::string& outContent) const = 0;
+
+    // "query": JSONPath subset (wildcards, `..`, indices, slices, filters
+    // such as `$.hosts[?(@.cpu > 80)]`); compiled queries are cached.
+    virtual bool query(const std::string& expr, std::string& outContent) const = 0;
+
+    // "add": moves the `target` branch under `prefix` (`prefix|target`).
+    // Returns the updated document, or nullptr on error; *this is unchanged.
+    virtual std::shared_ptr<const IJsonDocument> add(const std::string& keywords,
+                                                     std::string& outContent) const = 0;
+
+    // The document itself; indent < 0 gives the compact form.
+    virtual std::string dump(int indent = -1) const = 0;
+};
+
+// Hands a task to the host's thread pool (e.g. rt::ThreadPool::post).
+using TaskExecutor = std::function<void(std::function<void()>)>;
+
+struct JsonLinesOptions {
+    // true: reports in input order, batches that finish early wait in a
+    // reorder buffer; false: each batch as soon as it is done.
+    bool ordered = true;
+    // Batches in flight, the calling thread's included; 0 = one per
+    // hardware thread.
+    size_t parallelism = 0;
+    // Records are handed out in batches of about this many bytes.
+    size_t batchBytes = size_t(1) << 20;
+};
+
 class IJsonProcess : public IObject {
 public:
     DEFINE_IID(IJsonProcess);
@@ -15,6 +78,57 @@ public:
                                   std::string& outContent,
                                   const std::string& keywords,
                                   const std::string& processMethod) = 0;
+
+    // IJsonDocument::findBatch over raw content, streamed without a DOM.
+    virtual bool findBatch(const std::string& srcContent,
+                           const std::vector<std::string>& paths,
+                           std::string& outContent) = 0;
+
+    // Parses `srcContent` once for repeated queries; nullptr on parse error.
+    virtual std::shared_ptr<const IJsonDocument> parseDocument(const std::string& srcContent) = 0;
+
+    // File variants: parse straight from a read-only memory map of `srcPath`
+    // instead of a string holding its contents.
+    virtual bool processJsonFile(const std::string& srcPath,
+                                 std::string& outContent,
+                                 const std::string& keywords,
+                                 const std::string& processMethod) = 0;
+    virtual std::shared_ptr<const IJsonDocument> parseDocumentFile(const std::string& srcPath) = 0;
+
+    // processJsonFile writing the report to `out` as it is produced; "find"
+    // emits each match while the file is still being parsed, so neither the
+    // document nor the report is held in memory. indent < 0 is compact.
+    virtual bool processJsonFile(const std::string& srcPath,
+                                 std::ostream& out,
+                                 const std::string& keywords,
+                                 const std::string& processMethod,
+                                 int indent = 4) = 0;
+
+    // Encoding of the content passed to later calls (Auto detects it per
+    // input: JSON text, CBOR, MessagePack, UBJSON or BSON) and of the reports
+    // they produce, including those of documents parsed from then on. The
+    // defaults are Auto and Json; with a binary output the report is the
+    // same value, encoded, and `indent` is ignored.
+    virtual void setFormats(JsonFormat input, JsonFormat output) = 0;
+
+    // Pool that processJsonLines batches run on besides the calling thread;
+    // without one (the default) the calling thread does them all.
+    virtual void setExecutor(TaskExecutor executor) = 0;
+
+    // JSON Lines / NDJSON: every non-blank line of `srcPath` is a document,
+    // processed as by processJsonFiles. The file is memory-mapped and split
+    // at newlines into batches that are processed in parallel. `out` gets
+    // one compact line per record: its report without processMethod and
+    // keywords, led by the record's byte offset in the file
+    // (`{"offset":0,"results":[...]}`), or `{"offset":..,"error":".."}`
+    // for a record that fails. Records and reports are JSON text whatever
+    // setFormats says. False if the file cannot be read, the method is
+    // unknown or any record failed.
+    virtual bool processJsonLines(const std::string& srcPath,
+                                  std::ostream& out,
+                                  const std::string& keywords,
+                                  const std::string& processMethod,
+                                  const JsonLinesOptions& options = {}) = 0;
 };
 
 } // namespace core
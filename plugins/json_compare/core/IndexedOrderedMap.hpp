@@ -0,0 +1,215 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace core {
+
+// Drop-in ObjectType for basic_json with the layout and semantics of
+// nlohmann::ordered_map (a vector of pairs in insertion order, duplicate
+// keys rejected, order-sensitive equality), plus a hash index over the
+// positions once an object grows past kIndexThreshold keys. Small objects
+// keep the linear scan and pay nothing; large ones get O(1) find / at /
+// contains / emplace instead of O(n), which also makes parsing them linear.
+//
+// The index is built when the object first crosses the threshold and kept
+// up to date by every mutating member below, so const lookups never write
+// and shared documents stay safe to read from several threads. The
+// std::vector mutators that would bypass it are hidden.
+template <class Key, class T, class IgnoredLess = std::less<Key>,
+          class Allocator = std::allocator<std::pair<const Key, T>>>
+class IndexedOrderedMap : public std::vector<std::pair<const Key, T>, Allocator> {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using Container = std::vector<std::pair<const Key, T>, Allocator>;
+    using iterator = typename Container::iterator;
+    using const_iterator = typename Container::const_iterator;
+    using size_type = typename Container::size_type;
+    using value_type = typename Container::value_type;
+    using key_compare = std::equal_to<>;
+
+    static constexpr size_type kIndexThreshold = 16;
+
+    IndexedOrderedMap() noexcept(noexcept(Container())) : Container{} {}
+    explicit IndexedOrderedMap(const Allocator& alloc) : Container{alloc} {}
+    template <class It>
+    IndexedOrderedMap(It first, It last, const Allocator& alloc = Allocator())
+        : Container{first, last, alloc} { reindex(); }
+    IndexedOrderedMap(std::initializer_list<value_type> init, const Allocator& alloc = Allocator())
+        : Container{init, alloc} { reindex(); }
+
+    template <class K>
+    std::pair<iterator, bool> emplace(K&& key, T&& t) {
+        const size_type pos = position(key);
+        if (pos != this->size()) return {this->begin() + pos, false};
+        Container::emplace_back(std::forward<K>(key), std::move(t));
+        indexBack();
+        return {std::prev(this->end()), true};
+    }
+
+    template <class K>
+    T& operator[](K&& key) { return emplace(std::forward<K>(key), T{}).first->second; }
+    template <class K>
+    const T& operator[](K&& key) const { return at(std::forward<K>(key)); }
+
+    template <class K>
+    T& at(const K& key) {
+        const size_type pos = position(key);
+        if (pos == this->size()) throw std::out_of_range("key not found");
+        return Container::operator[](pos).second;
+    }
+    template <class K>
+    const T& at(const K& key) const {
+        const size_type pos = position(key);
+        if (pos == this->size()) throw std::out_of_range("key not found");
+        return Container::operator[](pos).second;
+    }
+
+    template <class K>
+    size_type count(const K& key) const { return position(key) != this->size() ? 1 : 0; }
+
+    template <class K>
+    iterator find(const K& key) { return this->begin() + position(key); }
+    template <class K>
+    const_iterator find(const K& key) const { return this->begin() + position(key); }
+
+    template <class K, class = decltype(std::string_view(std::declval<const K&>()))>
+    size_type erase(const K& key) {
+        const size_type pos = position(key);
+        if (pos == this->size()) return 0;
+        erase(this->begin() + pos);
+        return 1;
+    }
+
+    iterator erase(iterator pos) { return erase(pos, std::next(pos)); }
+
+    iterator erase(iterator first, iterator last) {
+        if (first == last) return first;
+        const auto removed = std::distance(first, last);
+        const auto offset = std::distance(this->begin(), first);
+        // Keys are const, so the tail is re-constructed in place (as ordered_map does).
+        for (auto it = first; std::next(it, removed) != this->end(); ++it) {
+            it->~value_type();
+            new (&*it) value_type{std::move(*std::next(it, removed))};
+        }
+        Container::resize(this->size() - static_cast<size_type>(removed));
+        reindex();
+        return this->begin() + offset;
+    }
+
+    std::pair<iterator, bool> insert(value_type&& value) {
+        return emplace(value.first, std::move(value.second));
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value) {
+        const size_type pos = position(value.first);
+        if (pos != this->size()) return {this->begin() + pos, false};
+        Container::push_back(value);
+        indexBack();
+        return {std::prev(this->end()), true};
+    }
+
+    template <class InputIt, class = typename std::enable_if<std::is_convertible<
+                                 typename std::iterator_traits<InputIt>::iterator_category,
+                                 std::input_iterator_tag>::value>::type>
+    void insert(InputIt first, InputIt last) {
+        for (auto it = first; it != last; ++it) insert(*it);
+    }
+
+    void clear() noexcept {
+        Container::clear();
+        slots_.clear();
+    }
+
+    void swap(IndexedOrderedMap& other) noexcept {
+        Container::swap(other);
+        slots_.swap(other.slots_);
+    }
+    friend void swap(IndexedOrderedMap& a, IndexedOrderedMap& b) noexcept { a.swap(b); }
+
+    bool indexed() const { return !slots_.empty(); }
+
+    // Would leave the index stale.
+    void push_back(const value_type&) = delete;
+    void pop_back() = delete;
+    void resize(size_type) = delete;
+    template <class... Args>
+    void emplace_back(Args&&...) = delete;
+    template <class... Args>
+    void assign(Args&&...) = delete;
+
+private:
+    // Slot value: position + 1, 0 = empty. Linear probing, load <= 1/2.
+    using Slots = std::vector<std::uint32_t,
+                              typename std::allocator_traits<Allocator>::template rebind_alloc<std::uint32_t>>;
+
+    template <class K>
+    static size_t hashOf(const K& key) { return std::hash<std::string_view>{}(std::string_view(key)); }
+
+    // Position of `key`, size() when absent.
+    template <class K>
+    size_type position(const K& key) const {
+        const size_type n = this->size();
+        if (slots_.empty()) {
+            for (size_type i = 0; i < n; ++i)
+                if (Container::operator[](i).first == key) return i;
+            return n;
+        }
+        const size_t mask = slots_.size() - 1;
+        for (size_t s = hashOf(key) & mask;; s = (s + 1) & mask) {
+            const std::uint32_t slot = slots_[s];
+            if (slot == 0) return n;
+            if (Container::operator[](slot - 1).first == key) return slot - 1;
+        }
+    }
+
+    // Records the element just appended; builds the index on crossing the threshold.
+    void indexBack() {
+        const size_type n = this->size();
+        if (slots_.empty()) {
+            if (n > kIndexThreshold) reindex();
+            return;
+        }
+        if (2 * n > slots_.size()) {
+            reindex();
+            return;
+        }
+        place(n - 1);
+    }
+
+    void reindex() {
+        slots_.clear();
+        const size_type n = this->size();
+        if (n <= kIndexThreshold) return;
+        size_t capacity = 64;
+        while (capacity < 4 * n) capacity *= 2; // room to grow to 2n before the next rebuild
+        slots_.assign(capacity, 0);
+        for (size_type i = 0; i < n; ++i) place(i);
+    }
+
+    // Duplicate keys (possible from the range constructor) keep the first, as a scan would.
+    void place(size_type pos) {
+        const auto& key = Container::operator[](pos).first;
+        const size_t mask = slots_.size() - 1;
+        for (size_t s = hashOf(key) & mask;; s = (s + 1) & mask) {
+            if (slots_[s] == 0) {
+                slots_[s] = static_cast<std::uint32_t>(pos + 1);
+                return;
+            }
+            if (Container::operator[](slots_[s] - 1).first == key) return;
+        }
+    }
+
+    Slots slots_;
+};
+
+} // namespace core
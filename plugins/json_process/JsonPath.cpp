@@ -0,0 +1,498 @@
+#include "JsonPath.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace core::jsonpath {
+
+namespace {
+
+enum CmpOp : size_t { Eq, Ne, Lt, Le, Gt, Ge };
+
+// Missing operands compare equal only to each other; ordering needs two
+// numbers or two strings.
+bool compare(const json* a, const json* b, size_t op) {
+    if (!a || !b) {
+        const bool same = !a && !b;
+        return op == Eq ? same : op == Ne ? !same : false;
+    }
+    if (op == Eq) return *a == *b;
+    if (op == Ne) return *a != *b;
+    const bool ordered = (a->is_number() && b->is_number()) || (a->is_string() && b->is_string());
+    if (!ordered) return false;
+    switch (op) {
+    case Lt: return *a < *b;
+    case Le: return *a <= *b;
+    case Gt: return *a > *b;
+    default: return *a >= *b;
+    }
+}
+
+bool truthy(const json* v) {
+    return v && !v->is_null() && !(v->is_boolean() && !v->get<bool>());
+}
+
+// Python-style slice bounds for an array of `size` elements.
+void sliceBounds(const Query::Step& st, long long size, long long& from, long long& to) {
+    auto clamp = [&](long long i, long long lo, long long hi) {
+        if (i < 0) i += size;
+        return i < lo ? lo : i > hi ? hi : i;
+    };
+    if (st.step > 0) {
+        from = st.hasStart ? clamp(st.start, 0, size) : 0;
+        to = st.hasEnd ? clamp(st.end, 0, size) : size;
+    } else {
+        from = st.hasStart ? clamp(st.start, -1, size - 1) : size - 1;
+        to = st.hasEnd ? clamp(st.end, -1, size - 1) : -1;
+    }
+}
+
+const json* element(const json& arr, long long i) {
+    const long long size = static_cast<long long>(arr.size());
+    if (i < 0) i += size;
+    if (i < 0 || i >= size) return nullptr;
+    return &arr[static_cast<size_t>(i)];
+}
+
+} // namespace
+
+// Recursive-descent parser emitting Query::Step / Query::PredOp programs.
+class Compiler {
+public:
+    Compiler(const std::string& text, Query& q) : s_(text), q_(q) {}
+
+    bool compile(std::string& error) {
+        ws();
+        bool ok = path(q_.steps_, false);
+        ws();
+        if (ok && pos_ != s_.size()) ok = fail("unexpected character");
+        if (!ok) error = "at position " + std::to_string(pos_) + ": " + error_;
+        return ok;
+    }
+
+private:
+    bool fail(const char* msg) {
+        if (error_.empty()) error_ = msg;
+        return false;
+    }
+    bool at(const char* tok) const { return s_.compare(pos_, std::char_traits<char>::length(tok), tok) == 0; }
+    bool eat(const char* tok) {
+        if (!at(tok)) return false;
+        pos_ += std::char_traits<char>::length(tok);
+        return true;
+    }
+    void ws() {
+        while (pos_ < s_.size() && std::isspace(static_cast<unsigned char>(s_[pos_]))) ++pos_;
+    }
+
+    static bool nameChar(char c) {
+        return !std::isspace(static_cast<unsigned char>(c)) && std::string(".[]()=!<>&|,'\"").find(c) == std::string::npos;
+    }
+
+    bool name(std::string& out) {
+        const size_t begin = pos_;
+        while (pos_ < s_.size() && nameChar(s_[pos_])) ++pos_;
+        if (pos_ == begin) return fail("expected a member name");
+        out = s_.substr(begin, pos_ - begin);
+        return true;
+    }
+
+    bool quoted(std::string& out) {
+        const char q = s_[pos_++];
+        out.clear();
+        while (pos_ < s_.size() && s_[pos_] != q) {
+            if (s_[pos_] == '\\' && pos_ + 1 < s_.size()) ++pos_;
+            out.push_back(s_[pos_++]);
+        }
+        if (pos_ >= s_.size()) return fail("unterminated string");
+        ++pos_;
+        return true;
+    }
+
+    bool integer(long long& out) {
+        const char* begin = s_.c_str() + pos_;
+        char* end = nullptr;
+        out = std::strtoll(begin, &end, 10);
+        if (end == begin) return fail("expected an integer");
+        pos_ += static_cast<size_t>(end - begin);
+        return true;
+    }
+
+    // Member/wildcard selector after `.` or `..`.
+    bool dotted(Query::Step& st) {
+        if (eat("*")) {
+            st.kind = Query::Step::Wildcard;
+            return true;
+        }
+        st.kind = Query::Step::Names;
+        st.names.emplace_back();
+        return name(st.names.back());
+    }
+
+    bool bracket(Query::Step& st) {
+        ws();
+        if (eat("*")) {
+            st.kind = Query::Step::Wildcard;
+        } else if (eat("?")) {
+            ws();
+            if (!eat("(")) return fail("expected '(' after '?'");
+            st.kind = Query::Step::Filter;
+            // Built locally: nested filters append to q_.filters_ meanwhile.
+            std::vector<Query::PredOp> prog;
+            if (!orExpr(prog)) return false;
+            if (stackDepth(prog) > Query::kFilterStack) return fail("filter too complex");
+            st.filter = q_.filters_.size();
+            q_.filters_.push_back(std::move(prog));
+            ws();
+            if (!eat(")")) return fail("expected ')'");
+        } else if (at("'") || at("\"")) {
+            st.kind = Query::Step::Names;
+            do {
+                ws();
+                if (!at("'") && !at("\"")) return fail("expected a quoted name");
+                st.names.emplace_back();
+                if (!quoted(st.names.back())) return false;
+                ws();
+            } while (eat(","));
+        } else {
+            long long first = 0;
+            const bool hasFirst = !at(":");
+            if (hasFirst && !integer(first)) return false;
+            ws();
+            if (eat(":")) {
+                st.kind = Query::Step::Slice;
+                st.hasStart = hasFirst;
+                st.start = first;
+                ws();
+                if (!at(":") && !at("]")) {
+                    if (!integer(st.end)) return false;
+                    st.hasEnd = true;
+                }
+                ws();
+                if (eat(":")) {
+                    ws();
+                    if (!at("]") && !integer(st.step)) return false;
+                }
+            } else {
+                st.kind = Query::Step::Indices;
+                st.indices.push_back(first);
+                while (eat(",")) {
+                    ws();
+                    long long i = 0;
+                    if (!integer(i)) return false;
+                    st.indices.push_back(i);
+                    ws();
+                }
+            }
+        }
+        ws();
+        return eat("]") || fail("expected ']'");
+    }
+
+    // Segments of a path; `relative` paths (after `@` in filters) stop at
+    // the first character that cannot continue them.
+    bool path(std::vector<Query::Step>& steps, bool relative) {
+        if (!relative && !eat("$") && pos_ < s_.size() && nameChar(s_[pos_])) {
+            steps.emplace_back();
+            if (!dotted(steps.back())) return false;
+        }
+        while (pos_ < s_.size()) {
+            Query::Step st;
+            if (eat("..")) {
+                st.descend = true;
+                if (eat("[")) {
+                    if (!bracket(st)) return false;
+                } else if (!dotted(st)) {
+                    return false;
+                }
+            } else if (eat(".")) {
+                if (!dotted(st)) return false;
+            } else if (eat("[")) {
+                if (!bracket(st)) return false;
+            } else {
+                break;
+            }
+            if (relative) {
+                const bool single = !st.descend &&
+                    ((st.kind == Query::Step::Names && st.names.size() == 1) ||
+                     (st.kind == Query::Step::Indices && st.indices.size() == 1));
+                if (!single) return fail("filter paths support only .name, ['name'] and [n]");
+            }
+            steps.push_back(std::move(st));
+        }
+        return true;
+    }
+
+    static size_t stackDepth(const std::vector<Query::PredOp>& prog) {
+        size_t depth = 0, peak = 0;
+        for (const auto& op : prog) {
+            if (op.kind == Query::PredOp::Load || op.kind == Query::PredOp::Const) peak = std::max(peak, ++depth);
+            else if (op.kind == Query::PredOp::Cmp || op.kind == Query::PredOp::And || op.kind == Query::PredOp::Or) --depth;
+        }
+        return peak;
+    }
+
+    bool orExpr(std::vector<Query::PredOp>& prog) {
+        if (!andExpr(prog)) return false;
+        for (ws(); eat("||"); ws()) {
+            if (!andExpr(prog)) return false;
+            prog.push_back({Query::PredOp::Or});
+        }
+        return true;
+    }
+
+    bool andExpr(std::vector<Query::PredOp>& prog) {
+        if (!unary(prog)) return false;
+        for (ws(); eat("&&"); ws()) {
+            if (!unary(prog)) return false;
+            prog.push_back({Query::PredOp::And});
+        }
+        return true;
+    }
+
+    bool unary(std::vector<Query::PredOp>& prog) {
+        ws();
+        if (!at("!=") && eat("!")) {
+            if (!unary(prog)) return false;
+            prog.push_back({Query::PredOp::Not});
+            return true;
+        }
+        if (eat("(")) {
+            if (!orExpr(prog)) return false;
+            ws();
+            return eat(")") || fail("expected ')'");
+        }
+        if (!operand(prog)) return false;
+        ws();
+        static const std::pair<const char*, size_t> ops[] = {
+            {"==", Eq}, {"!=", Ne}, {"<=", Le}, {">=", Ge}, {"<", Lt}, {">", Gt}};
+        for (const auto& [tok, op] : ops) {
+            if (!eat(tok)) continue;
+            ws();
+            if (!operand(prog)) return false;
+            prog.push_back({Query::PredOp::Cmp, op});
+            return true;
+        }
+        prog.push_back({Query::PredOp::Truthy});
+        return true;
+    }
+
+    bool operand(std::vector<Query::PredOp>& prog) {
+        if (eat("@")) {
+            std::vector<Query::Step> rel;
+            if (!path(rel, true)) return false;
+            prog.push_back({Query::PredOp::Load, q_.relPaths_.size()});
+            q_.relPaths_.push_back(std::move(rel));
+            return true;
+        }
+        json value;
+        if (at("'") || at("\"")) {
+            std::string str;
+            if (!quoted(str)) return false;
+            value = std::move(str);
+        } else if (eat("true")) {
+            value = true;
+        } else if (eat("false")) {
+            value = false;
+        } else if (eat("null")) {
+            value = nullptr;
+        } else {
+            const size_t begin = pos_;
+            while (pos_ < s_.size() && std::string("+-.eE0123456789").find(s_[pos_]) != std::string::npos) ++pos_;
+            value = json::parse(s_.substr(begin, pos_ - begin), nullptr, false);
+            if (!value.is_number()) {
+                pos_ = begin;
+                return fail("expected @path or a literal");
+            }
+        }
+        prog.push_back({Query::PredOp::Const, q_.constants_.size()});
+        q_.constants_.push_back(std::move(value));
+        return true;
+    }
+
+    const std::string& s_;
+    Query& q_;
+    size_t pos_ = 0;
+    std::string error_;
+};
+
+std::shared_ptr<const Query> Query::compile(const std::string& expr, std::string& error) {
+    auto q = std::make_shared<Query>();
+    Compiler c(expr, *q);
+    if (!c.compile(error)) return nullptr;
+    return q;
+}
+
+void Query::run(const json& root, std::vector<const json*>& out) const {
+    std::vector<const json*> current{&root};
+    runFrom(0, current, out);
+}
+
+void Query::run(const std::vector<Member>& rootMembers, std::vector<const json*>& out) const {
+    if (steps_.empty()) return;
+    // The first step against the root object, then as usual.
+    const Step& step = steps_.front();
+    std::vector<const json*> current;
+    switch (step.kind) {
+    case Step::Names:
+        for (const auto& n : step.names) {
+            for (const auto& [key, value] : rootMembers) {
+                if (*key == n) {
+                    current.push_back(value);
+                    break;
+                }
+            }
+        }
+        break;
+    case Step::Wildcard:
+        for (const auto& m : rootMembers) current.push_back(m.second);
+        break;
+    case Step::Filter:
+        for (const auto& m : rootMembers) {
+            if (test(step.filter, *m.second)) current.push_back(m.second);
+        }
+        break;
+    default: // indices and slices never match an object
+        break;
+    }
+    if (step.descend) {
+        for (const auto& m : rootMembers) apply(step, *m.second, current);
+    }
+    runFrom(1, current, out);
+}
+
+void Query::runFrom(size_t first, std::vector<const json*>& current, std::vector<const json*>& out) const {
+    std::vector<const json*> next;
+    for (size_t i = first; i < steps_.size() && !current.empty(); ++i) {
+        next.clear();
+        for (const json* node : current) apply(steps_[i], *node, next);
+        current.swap(next);
+    }
+    out.insert(out.end(), current.begin(), current.end());
+}
+
+void Query::apply(const Step& step, const json& node, std::vector<const json*>& out) const {
+    select(step, node, out);
+    if (!step.descend || !node.is_structured()) return;
+    for (const auto& child : node) apply(step, child, out);
+}
+
+void Query::select(const Step& step, const json& node, std::vector<const json*>& out) const {
+    switch (step.kind) {
+    case Step::Names:
+        if (!node.is_object()) return;
+        for (const auto& n : step.names) {
+            auto it = node.find(n);
+            if (it != node.end()) out.push_back(&*it);
+        }
+        return;
+    case Step::Wildcard:
+        if (!node.is_structured()) return;
+        for (const auto& child : node) out.push_back(&child);
+        return;
+    case Step::Indices:
+        if (!node.is_array()) return;
+        for (long long i : step.indices) {
+            if (const json* e = element(node, i)) out.push_back(e);
+        }
+        return;
+    case Step::Slice: {
+        if (!node.is_array() || step.step == 0) return;
+        long long from = 0, to = 0;
+        sliceBounds(step, static_cast<long long>(node.size()), from, to);
+        for (long long i = from; step.step > 0 ? i < to : i > to; i += step.step) out.push_back(&node[static_cast<size_t>(i)]);
+        return;
+    }
+    case Step::Filter:
+        if (!node.is_structured()) return;
+        for (const auto& child : node) {
+            if (test(step.filter, child)) out.push_back(&child);
+        }
+        return;
+    }
+}
+
+bool Query::test(size_t filter, const json& node) const {
+    struct Value {
+        const json* ptr;
+        bool truth;
+    };
+    Value stack[kFilterStack];
+    size_t top = 0;
+    auto resolve = [&](const std::vector<Step>& rel) -> const json* {
+        const json* cur = &node;
+        for (const auto& st : rel) {
+            if (st.kind == Step::Names) {
+                if (!cur->is_object()) return nullptr;
+                auto it = cur->find(st.names[0]);
+                if (it == cur->end()) return nullptr;
+                cur = &*it;
+            } else {
+                if (!cur->is_array()) return nullptr;
+                cur = element(*cur, st.indices[0]);
+                if (!cur) return nullptr;
+            }
+        }
+        return cur;
+    };
+    for (const auto& op : filters_[filter]) {
+        switch (op.kind) {
+        case PredOp::Load: stack[top++] = {resolve(relPaths_[op.arg]), false}; break;
+        case PredOp::Const: stack[top++] = {&constants_[op.arg], false}; break;
+        case PredOp::Cmp:
+            --top;
+            stack[top - 1] = {nullptr, compare(stack[top - 1].ptr, stack[top].ptr, op.arg)};
+            break;
+        case PredOp::Truthy: stack[top - 1] = {nullptr, truthy(stack[top - 1].ptr)}; break;
+        case PredOp::Not: stack[top - 1].truth = !stack[top - 1].truth; break;
+        case PredOp::And: --top; stack[top - 1].truth = stack[top - 1].truth && stack[top].truth; break;
+        case PredOp::Or: --top; stack[top - 1].truth = stack[top - 1].truth || stack[top].truth; break;
+        }
+    }
+    return top == 1 && stack[0].truth;
+}
+
+QueryCache& QueryCache::shared() {
+    static QueryCache cache;
+    return cache;
+}
+
+std::shared_ptr<const Query> QueryCache::get(const std::string& expr, std::string& error) {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        auto it = index_.find(expr);
+        if (it != index_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            ++hits_;
+            return it->second->second;
+        }
+        ++misses_;
+    }
+    // Compile outside the lock; a concurrent miss on the same text just
+    // compiles twice.
+    auto q = Query::compile(expr, error);
+    if (!q) return nullptr;
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto it = index_.find(expr);
+    if (it != index_.end()) return it->second->second;
+    lru_.emplace_front(expr, q);
+    index_[expr] = lru_.begin();
+    if (lru_.size() > capacity_) {
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+    return q;
+}
+
+size_t QueryCache::hits() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return hits_;
+}
+
+size_t QueryCache::misses() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return misses_;
+}
+
+} // namespace core::jsonpath
@@ -0,0 +1,102 @@
+// JSONPath subset for the "query" process method:
+//
+//   $.a.b  $['a']['b']  a.b       child members (leading `$` optional)
+//   .*  [*]                      all members / elements
+//   ..name  ..*  ..[0]           recursive descent (self and descendants)
+//   [2]  [-1]  [1:5]  [::2]      index, negative index, slice
+//   ['a','b']  [0,3]             unions
+//   [?(@.cpu > 80 && @.tag == 'x')]  filter on elements / member values;
+//                                ==, !=, <, <=, >, >=, &&, ||, !, (),
+//                                `@.path` alone tests for a truthy value
+//
+// Expressions compile once into a flat program of steps (filters into a
+// postfix program) and are cached by string in QueryCache.
+#pragma once
+#include "core/JsonArena.hpp"
+#include <nlohmann/json.hpp>
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace core::jsonpath {
+
+using json = ArenaJson;
+
+class Query {
+public:
+    // nullptr on syntax error, with `error` set.
+    static std::shared_ptr<const Query> compile(const std::string& expr, std::string& error);
+
+    // Appends the matches in document order. Pointers are into `root`.
+    void run(const json& root, std::vector<const json*>& out) const;
+
+    // run() on an object root held as its members (key, value), in order.
+    // A query selecting the root itself ("$") yields nothing here; check
+    // selectsRoot() first.
+    using Member = std::pair<const std::string*, const json*>;
+    void run(const std::vector<Member>& rootMembers, std::vector<const json*>& out) const;
+    bool selectsRoot() const { return steps_.empty(); }
+
+    // One selector; `descend` applies it to the node and all descendants.
+    struct Step {
+        enum Kind { Names, Wildcard, Indices, Slice, Filter } kind = Names;
+        bool descend = false;
+        std::vector<std::string> names;
+        std::vector<long long> indices;
+        long long start = 0, end = 0, step = 1;
+        bool hasStart = false, hasEnd = false;
+        size_t filter = 0; // into filters_
+    };
+
+    // Postfix filter instruction. Load/Const push an operand (`arg` indexes
+    // relPaths_/constants_), Cmp pops two (`arg` is the operator), Truthy
+    // turns an operand into a boolean.
+    struct PredOp {
+        enum Kind { Load, Const, Cmp, Truthy, Not, And, Or } kind;
+        size_t arg = 0;
+    };
+    static constexpr size_t kFilterStack = 32; // operands live at once, checked at compile time
+
+private:
+    void runFrom(size_t first, std::vector<const json*>& current, std::vector<const json*>& out) const;
+    void apply(const Step& step, const json& node, std::vector<const json*>& out) const;
+    void select(const Step& step, const json& node, std::vector<const json*>& out) const;
+    bool test(size_t filter, const json& node) const;
+
+    std::vector<Step> steps_;
+    std::vector<std::vector<PredOp>> filters_; // postfix programs
+    std::vector<json> constants_;
+    std::vector<std::vector<Step>> relPaths_;  // `@...` operands
+    friend class Compiler;
+};
+
+// LRU of compiled queries keyed by expression text; thread-safe.
+class QueryCache {
+public:
+    explicit QueryCache(size_t capacity = 256) : capacity_(capacity) {}
+
+    static QueryCache& shared();
+
+    std::shared_ptr<const Query> get(const std::string& expr, std::string& error);
+
+    size_t hits() const;
+    size_t misses() const;
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<const Query>>;
+
+    size_t capacity_;
+    mutable std::mutex mtx_;
+    std::list<Entry> lru_; // most recent first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+};
+
+} // namespace core::jsonpath
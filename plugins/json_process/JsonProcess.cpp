@@ -1,19 +1,61 @@
 // plugins/json_compare/JsonCompare.cpp
 #include "core/IJsonProcess.hpp"
+#include "core/JsonArena.hpp"
+#include "core/JsonCodec.hpp"
 #include "core/PluginManager.hpp"
+#include "runtime/MappedFile.hpp"
+#include "JsonPath.hpp"
 #include <nlohmann/json.hpp>
 
 #include <iostream>
+#include <ostream>
+#include <sstream>
 #include <string>
 #include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <cctype>
+#include <unordered_map>
 
-using json = nlohmann::ordered_json;  // 保持对象键的插入顺序
+using json = core::ArenaJson;  // 保持对象键的插入顺序；节点按请求分配在 JsonArena 上
 
 namespace {
 
+using core::JsonFormat;
+using core::encodeJson;
+using core::resolveFormat;
+using core::saxDecode;
+
+// Diagnostics go to stdout/stderr, except while a thread processes JSON
+// Lines records: then progress lines are dropped and errors are kept for
+// the record's error line.
+struct RecordLog {
+    std::ostringstream errors;
+    std::ostream dropped{nullptr};
+};
+thread_local RecordLog* tRecordLog = nullptr;
+
+// Points this thread's diagnostics at `log` until the scope ends, however
+// it ends: pool threads outlive the record's stack frame.
+class RecordLogScope {
+public:
+    explicit RecordLogScope(RecordLog& log) : outer_(tRecordLog) { tRecordLog = &log; }
+    ~RecordLogScope() { tRecordLog = outer_; }
+    RecordLogScope(const RecordLogScope&) = delete;
+    RecordLogScope& operator=(const RecordLogScope&) = delete;
+
+private:
+    RecordLog* outer_;
+};
+
+std::ostream& logOut() { return tRecordLog ? tRecordLog->dropped : std::cout; }
+std::ostream& logErr() { return tRecordLog ? static_cast<std::ostream&>(tRecordLog->errors) : std::cerr; }
+
 std::string trim(const std::string& input) {
     auto begin = std::find_if_not(input.begin(), input.end(),
                                   [](unsigned char c){ return std::isspace(c); });
@@ -86,9 +128,9 @@ bool ensurePathExists(const json& node,
 void collect_by_path(const json& node,
                      const std::vector<std::string>& keys,
                      size_t idx,
-                     std::vector<json>& results) {
+                     std::vector<const json*>& results) {
     if (idx >= keys.size()) {
-        results.push_back(node);
+        results.push_back(&node);
         return;
     }
 
@@ -102,116 +144,1280 @@ void collect_by_path(const json& node,
         }
     }
 }
-} // namespace
 
-namespace core {
+// Report output. The sink either appends to a string or fills a fixed
+// chunk that is handed to an ostream whenever it is full, so a report to
+// a file never exists in memory as a whole.
+class ReportSink : public nlohmann::detail::output_adapter_protocol<char> {
+public:
+    static constexpr size_t kChunk = 64 * 1024;
 
-class JsonProcess : public IJsonProcess {
+    explicit ReportSink(std::string& out) : str_(&out) {}
+    explicit ReportSink(std::ostream& out) : os_(&out) { buf_.reserve(kChunk); }
+
+    void write_character(char c) override {
+        if (str_) {
+            str_->push_back(c);
+            return;
+        }
+        buf_.push_back(c);
+        if (buf_.size() >= kChunk) flush();
+    }
+
+    void write_characters(const char* s, std::size_t length) override {
+        if (str_) {
+            str_->append(s, length);
+            return;
+        }
+        if (buf_.size() + length > kChunk) flush();
+        if (length >= kChunk) os_->write(s, static_cast<std::streamsize>(length));
+        else buf_.append(s, length);
+    }
+
+    bool flush() {
+        if (!os_) return true;
+        if (!buf_.empty()) os_->write(buf_.data(), static_cast<std::streamsize>(buf_.size()));
+        buf_.clear();
+        os_->flush();
+        return os_->good();
+    }
+
+private:
+    std::string* str_ = nullptr;
+    std::ostream* os_ = nullptr;
+    std::string buf_;
+};
+
+// Writes reports piecewise in the layout of json::dump(indent) of the whole
+// report (compact when indent < 0): values go through the library's
+// serializer straight into the sink, so no result DOM or string is built.
+// A binary output format needs sizes up front, so there the report is
+// assembled as a json value and encoded by tail().
+class ReportWriter {
 public:
-    bool processJsonFiles(const std::string& srcContent,
-                          std::string& outContent,
-                          const std::string& keywords,
-                          const std::string& processMethod) override {
-        json srcJson;
-        try {
-            srcJson = json::parse(srcContent);
-        } catch (const std::exception& e) {
-            std::cerr << "[JsonProcess] parse failed: " << e.what() << "\n";
-            return false;
+    template <class Target>
+    ReportWriter(Target& out, int indent, JsonFormat format = JsonFormat::Json)
+        : sink_(std::make_shared<ReportSink>(out)), serializer_(sink_, ' '), indent_(indent),
+          binary_(format != JsonFormat::Json && format != JsonFormat::Auto), format_(format) {}
+    ~ReportWriter() { sink_->flush(); }
+
+    bool flush() { return sink_->flush(); }
+
+    // Writes the report of the JSON Lines record at byte `offset`.
+    void record(size_t offset) { offset_ = offset; }
+
+    // Report header shared by all methods: `{"processMethod":..,"keywords":..,`
+    // up to the value of "results". A JSON Lines record (see record()) has
+    // `{"offset":..,` instead.
+    void head(const std::string& processMethod, const std::string& keywords) {
+        count_ = 0;
+        if (binary_) {
+            report_ = {{"processMethod", processMethod}, {"keywords", keywords}, {"results", Report::array()}};
+            return;
+        }
+        raw('{');
+        newline(1);
+        if (offset_ != kNoOffset) {
+            key("offset");
+            serializer_.dump(json(static_cast<std::uint64_t>(offset_)), false, false, 0);
+            raw(',');
+            newline(1);
+            key("results");
+            return;
         }
+        key("processMethod");
+        string(processMethod);
+        raw(',');
+        newline(1);
+        key("keywords");
+        string(keywords);
+        raw(',');
+        newline(1);
+        key("results");
+    }
 
-        json result = json::object();
-        result["processMethod"] = processMethod;
-        result["keywords"] = keywords;
-        result["results"] = json::array();
+    // "results" written element by element.
+    void result(const json& v) {
+        if (binary_) {
+            report_["results"].push_back(Report(v));
+            return;
+        }
+        item(v, 1);
+    }
+    void endResults() {
+        if (!binary_) endArray(1);
+    }
+    void results(const std::vector<const json*>& items) {
+        for (const json* v : items) result(*v);
+        endResults();
+    }
 
-        if (processMethod == "find") {
-            std::cout << "[JsonProcess] processMethod: find\n";
-            const auto keys = splitPath(keywords);
-
-            if (keys.empty()) {
-                std::cerr << "[JsonProcess] keywords are empty\n";
-                return false;
-            }
-
-            std::vector<json> results;
-            if (!srcJson.is_object()) {
-                std::cerr << "[JsonProcess] Root JSON is not an object\n";
-            } else {
-                auto it = srcJson.find(keys[0]);
-                if (it == srcJson.end()) {
-                    std::cerr << "[JsonProcess] Top-level key not found: "
-                              << keys[0] << "\n";
-                } else {
-                    collect_by_path(it.value(), keys, 1, results);
-                }
+    // `"results": {"query": [...], ...}` in query order, duplicates once.
+    template <class Results>
+    void batchResults(const std::vector<std::string>& paths,
+                      const std::vector<size_t>& slots, const Results& bySlot) {
+        std::vector<bool> written(bySlot.size(), false);
+        bool first = true;
+        if (binary_) report_["results"] = Report::object();
+        else raw('{');
+        for (size_t i = 0; i < paths.size(); ++i) {
+            if (written[slots[i]]) continue;
+            written[slots[i]] = true;
+            if (binary_) {
+                Report& list = report_["results"][paths[i]] = Report::array();
+                for (const json* v : bySlot[slots[i]]) list.push_back(Report(*v));
+                continue;
             }
+            if (!first) raw(',');
+            first = false;
+            newline(2);
+            key(paths[i]);
+            count_ = 0;
+            for (const json* v : bySlot[slots[i]]) item(*v, 2);
+            endArray(2);
+        }
+        if (!binary_) {
+            newline(1);
+            raw('}');
+        }
+    }
+
+    // "add": empty results, then the new path and the updated document.
+    template <class Document>
+    void added(const std::string& newPath, const Document& updated) {
+        if (binary_) {
+            report_["newPath"] = newPath;
+            report_["updatedJson"] = Report(updated.toJson());
+            return;
+        }
+        raw("[],");
+        newline(1);
+        key("newPath");
+        string(newPath);
+        raw(',');
+        newline(1);
+        key("updatedJson");
+        updated.writeTo(*this, 1);
+    }
+
+    void tail() {
+        if (binary_) {
+            encodeJson(report_, format_, sink_);
+            return;
+        }
+        newline(0);
+        raw('}');
+    }
+
+    // Pieces of the text layout.
+    void raw(char c) { sink_->write_character(c); }
+    void raw(const char* s) { sink_->write_characters(s, std::strlen(s)); }
+
+    void newline(int level) {
+        if (indent_ < 0) return;
+        raw('\n');
+        for (int i = indent_ * level; i > 0; --i) raw(' ');
+    }
+
+    void value(const json& v, int level) {
+        if (indent_ < 0) serializer_.dump(v, false, false, 0);
+        else serializer_.dump(v, true, false, static_cast<unsigned>(indent_),
+                              static_cast<unsigned>(indent_ * level));
+    }
+
+    void string(const std::string& s) { serializer_.dump(json(s), false, false, 0); }
+
+    void key(const std::string& k) {
+        string(k);
+        raw(indent_ < 0 ? ":" : ": ");
+    }
+
+private:
+    // Arrays at `level` written element by element; count_ is the number
+    // written so far.
+    void item(const json& v, int level) {
+        raw(count_++ ? ',' : '[');
+        newline(level + 1);
+        value(v, level + 1);
+    }
+    // Closes an array of count_ elements at `level`.
+    void endArray(int level) {
+        if (count_ == 0) {
+            raw("[]");
+            return;
+        }
+        newline(level);
+        raw(']');
+    }
+
+    std::shared_ptr<ReportSink> sink_;
+    nlohmann::detail::serializer<json> serializer_;
+    int indent_;
+    bool binary_;
+    JsonFormat format_;
+    size_t count_ = 0;
+    static constexpr size_t kNoOffset = static_cast<size_t>(-1);
+    size_t offset_ = kNoOffset;
+    // Binary formats only. A plain heap value: results may be copied in
+    // from a DOM that lives in a JsonArena.
+    using Report = nlohmann::ordered_json;
+    Report report_;
+};
+
+// Runs `write` against a string report that replaces `outContent` only if
+// it succeeds.
+template <class Write>
+auto writeString(std::string& outContent, JsonFormat format, Write write) {
+    std::string out;
+    auto result = [&] {
+        ReportWriter w(out, 4, format);
+        return write(w);
+    }();
+    if (result) outContent = std::move(out);
+    return result;
+}
+
+// Query paths merged by common prefix. Node 0 is the document root; a
+// node is terminal when some query ends there (`slot` is its result list).
+struct PathTrie {
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    struct Node {
+        std::unordered_map<std::string, size_t> children;
+        size_t slot = npos;
+    };
+    std::vector<Node> nodes{1};
+    size_t slots = 0;
+
+    // Returns the slot of `keys`; equal paths share one.
+    size_t insert(const std::vector<std::string>& keys) {
+        size_t n = 0;
+        for (const auto& k : keys) {
+            auto it = nodes[n].children.find(k);
+            if (it == nodes[n].children.end()) {
+                nodes.emplace_back();
+                it = nodes[n].children.emplace(k, nodes.size() - 1).first;
+            }
+            n = it->second;
+        }
+        if (nodes[n].slot == npos) nodes[n].slot = slots++;
+        return nodes[n].slot;
+    }
+
+    size_t child(size_t node, const std::string& key) const {
+        auto it = nodes[node].children.find(key);
+        return it == nodes[node].children.end() ? npos : it->second;
+    }
+};
+
+// collect_by_path for every query of the trie at once. `arrived` is false
+// for array elements: an expanded array keeps its node but its elements
+// are not results of the query ending there (the array itself is).
+template <class Sink>
+void collect_by_trie(const json& node, const PathTrie& trie, size_t t, bool arrived, Sink& sink) {
+    const auto& tn = trie.nodes[t];
+    if (arrived && tn.slot != PathTrie::npos) sink(tn.slot, node);
+    if (tn.children.empty()) return;
+    if (node.is_object()) {
+        for (const auto& [key, c] : tn.children) {
+            auto it = node.find(key);
+            if (it != node.end()) collect_by_trie(it.value(), trie, c, true, sink);
+        }
+    } else if (node.is_array()) {
+        for (const auto& element : node) collect_by_trie(element, trie, t, false, sink);
+    }
+}
+
+// SAX handler for one-shot finds: follows the query trie through the event
+// stream with the same rules as collect_by_trie, skips everything off the
+// paths by depth counting and builds json values only for matches.
+// Duplicate keys are not merged as the DOM parser does (last one wins
+// there); every occurrence on a path is reported.
+class StreamingFind : public nlohmann::json_sax<json> {
+public:
+    explicit StreamingFind(const PathTrie& trie) : trie_(trie), results(trie.slots) {}
+
+    const PathTrie& trie_;
+    std::vector<std::vector<json>> results; // by slot
+    // When set, each match is handed over as soon as it is complete and
+    // then dropped instead of being kept in `results`.
+    std::function<void(size_t slot, const json&)> onMatch;
+    bool rootIsObject = false;
+    bool topKeyFound = false;
+    std::string error;
+
+    bool null() override { return scalar(json()); }
+    bool boolean(bool val) override { return scalar(json(val)); }
+    bool number_integer(number_integer_t val) override { return scalar(json(val)); }
+    bool number_unsigned(number_unsigned_t val) override { return scalar(json(val)); }
+    bool number_float(number_float_t val, const string_t&) override { return scalar(json(val)); }
+    bool string(string_t& val) override {
+        if (skip_ > 0) return true;
+        return scalar(json(std::move(val)));
+    }
+    bool binary(binary_t& val) override { return scalar(json::binary(std::move(val))); }
+
+    bool start_object(std::size_t) override { return start(false); }
+    bool start_array(std::size_t) override { return start(true); }
+    bool end_object() override { return end(); }
+    bool end_array() override { return end(); }
+
+    bool key(string_t& val) override {
+        if (skip_ > 0) return true;
+        if (!capture_.empty()) {
+            pendingKey_ = std::move(val);
+            return true;
+        }
+        Frame& f = frames_.back();
+        f.next = trie_.child(f.node, val);
+        if (frames_.size() == 1 && f.next != PathTrie::npos) topKeyFound = true;
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) override {
+        error = ex.what();
+        return false;
+    }
+
+private:
+    struct Frame {
+        bool isArray;
+        size_t node;                  // trie node of this container
+        size_t next = PathTrie::npos; // objects: node of the value after the last key
+    };
+
+    // Trie node of the value about to start, and whether it was reached
+    // through a key (as opposed to array expansion).
+    std::pair<size_t, bool> upcoming() const {
+        if (frames_.empty()) return {PathTrie::npos, false}; // root is handled in start()
+        const Frame& f = frames_.back();
+        return f.isArray ? std::make_pair(f.node, false) : std::make_pair(f.next, true);
+    }
+
+    size_t terminalSlot(std::pair<size_t, bool> at) const {
+        return at.first != PathTrie::npos && at.second ? trie_.nodes[at.first].slot : PathTrie::npos;
+    }
+
+    json& attach(json value) {
+        json& parent = *capture_.back();
+        if (parent.is_array()) {
+            parent.push_back(std::move(value));
+            return parent.back();
+        }
+        return parent[pendingKey_] = std::move(value);
+    }
+
+    bool scalar(json value) {
+        if (skip_ > 0) return true;
+        if (!capture_.empty()) {
+            attach(std::move(value));
+            return true;
+        }
+        const size_t slot = terminalSlot(upcoming());
+        if (slot != PathTrie::npos) match(slot, std::move(value));
+        return true;
+    }
+
+    bool start(bool isArray) {
+        if (skip_ > 0) {
+            ++skip_;
+            return true;
+        }
+        json empty = isArray ? json::array() : json::object();
+        if (!capture_.empty()) {
+            capture_.push_back(&attach(std::move(empty)));
+            return true;
+        }
+        if (frames_.empty() && !rootSeen_) {
+            rootSeen_ = true;
+            rootIsObject = !isArray;
+            if (isArray) ++skip_;
+            else frames_.push_back({false, 0});
+            return true;
+        }
+        const auto at = upcoming();
+        const size_t slot = terminalSlot(at);
+        if (slot != PathTrie::npos) {
+            // Nothing else is pushed to `results[slot]` while the capture
+            // is open, so the pointer stays valid.
+            results[slot].push_back(std::move(empty));
+            capture_.push_back(&results[slot].back());
+            captureNode_ = at.first;
+            captureSlot_ = slot;
+        } else if (at.first == PathTrie::npos || trie_.nodes[at.first].children.empty()) {
+            ++skip_;
+        } else {
+            frames_.push_back({isArray, at.first});
+        }
+        return true;
+    }
 
-            for (const auto& item : results) {
-                result["results"].push_back(item);
+    bool end() {
+        if (skip_ > 0) {
+            --skip_;
+        } else if (!capture_.empty()) {
+            json* done = capture_.back();
+            capture_.pop_back();
+            // Longer queries through a captured value ("a/b" and "a/b/c")
+            // are answered from it.
+            // Their slots differ from the captured one, so `done` stays valid.
+            if (capture_.empty() && !trie_.nodes[captureNode_].children.empty()) {
+                auto sink = [&](size_t slot, const json& v) { match(slot, v); };
+                collect_by_trie(*done, trie_, captureNode_, false, sink);
             }
-        } else if (processMethod == "add") {
-            std::cout << "[JsonProcess] processMethod: add\n";
-            std::vector<std::string> prefix;
-            std::vector<std::string> target;
-            if (!parseAddKeywords(keywords, prefix, target)) {
-                std::cerr << "[JsonProcess] Invalid add keywords, use `prefix|target`\n";
-                return false;
+            if (capture_.empty() && onMatch) {
+                onMatch(captureSlot_, *done);
+                results[captureSlot_].pop_back();
             }
+        } else {
+            frames_.pop_back();
+        }
+        return true;
+    }
+
+    void match(size_t slot, json value) {
+        if (onMatch) onMatch(slot, value);
+        else results[slot].push_back(std::move(value));
+    }
 
-            if (!srcJson.is_object()) {
-                std::cerr << "[JsonProcess] Root JSON must be object for add\n";
-                return false;
+    std::vector<Frame> frames_;
+    std::vector<json*> capture_;
+    size_t captureNode_ = 0;
+    size_t captureSlot_ = 0;
+    std::string pendingKey_;
+    size_t skip_ = 0;
+    bool rootSeen_ = false;
+};
+
+bool saxFind(const char* first, const char* last, JsonFormat format, StreamingFind& sax) {
+    bool parsed = false;
+    try {
+        parsed = saxDecode<json>(first, last, resolveFormat<json>(first, last, format), &sax);
+    } catch (const std::exception& e) {
+        sax.error = e.what();
+    }
+    if (!parsed) logErr() << "[JsonProcess] parse failed: " << sax.error << "\n";
+    return parsed;
+}
+
+// Builds the trie for a batch; false (with a message) if a path is empty.
+bool buildTrie(const std::vector<std::string>& paths, PathTrie& trie, std::vector<size_t>& slots) {
+    if (paths.empty()) {
+        logErr() << "[JsonProcess] keywords are empty\n";
+        return false;
+    }
+    for (const auto& path : paths) {
+        const auto keys = splitPath(path);
+        if (keys.empty()) {
+            logErr() << "[JsonProcess] keywords are empty\n";
+            return false;
+        }
+        slots.push_back(trie.insert(keys));
+    }
+    return true;
+}
+
+std::string joinQueries(const std::vector<std::string>& paths) {
+    std::string joined;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (i) joined.push_back(';');
+        joined += paths[i];
+    }
+    return joined;
+}
+
+std::vector<std::string> splitQueries(const std::string& keywords) {
+    std::vector<std::string> paths;
+    size_t begin = 0;
+    while (begin <= keywords.size()) {
+        size_t end = keywords.find(';', begin);
+        if (end == std::string::npos) end = keywords.size();
+        auto path = trim(keywords.substr(begin, end - begin));
+        if (!path.empty()) paths.push_back(path);
+        begin = end + 1;
+    }
+    return paths;
+}
+
+std::vector<const json*> pointers(const std::vector<json>& values) {
+    std::vector<const json*> out;
+    out.reserve(values.size());
+    for (const auto& v : values) out.push_back(&v);
+    return out;
+}
+
+// "find" without a DOM: each match is written out as soon as it is
+// parsed, so memory is bounded by the largest single match plus the
+// nesting depth along the query path. A parse error part way leaves the
+// report written so far in `out`. Matches are built on the heap, not in a
+// JsonArena, so each one is freed once written.
+bool streamingFind(const char* first, const char* last, JsonFormat format,
+                   const std::string& keywords,
+                   ReportWriter& out) {
+    logOut() << "[JsonProcess] processMethod: find\n";
+    const auto keys = splitPath(keywords);
+    if (keys.empty()) {
+        logErr() << "[JsonProcess] keywords are empty\n";
+        return false;
+    }
+    PathTrie trie;
+    trie.insert(keys);
+    StreamingFind sax(trie);
+    out.head("find", keywords);
+    sax.onMatch = [&](size_t, const json& v) { out.result(v); };
+    if (!saxFind(first, last, format, sax)) return false;
+
+    if (!sax.rootIsObject) {
+        logErr() << "[JsonProcess] Root JSON is not an object\n";
+    } else if (!sax.topKeyFound) {
+        logErr() << "[JsonProcess] Top-level key not found: "
+                  << keys[0] << "\n";
+    }
+    out.endResults();
+    out.tail();
+    return true;
+}
+
+// Results are reported per path rather than in document order, so they
+// are collected (in a JsonArena for this call) before anything is written.
+bool streamingFindBatch(const char* first, const char* last, JsonFormat format,
+                        const std::vector<std::string>& paths,
+                        ReportWriter& out) {
+    PathTrie trie;
+    std::vector<size_t> slots;
+    if (!buildTrie(paths, trie, slots)) return false;
+    core::JsonArena arena;
+    core::JsonArena::Scope scope(&arena);
+    StreamingFind sax(trie);
+    if (!saxFind(first, last, format, sax)) return false;
+    if (!sax.rootIsObject) logErr() << "[JsonProcess] Root JSON is not an object\n";
+
+    std::vector<std::vector<const json*>> bySlot;
+    bySlot.reserve(sax.results.size());
+    for (const auto& r : sax.results) bySlot.push_back(pointers(r));
+    out.head("findBatch", joinQueries(paths));
+    out.batchResults(paths, slots, bySlot);
+    out.tail();
+    return true;
+}
+
+// Splits a JSON Lines buffer into batches of whole lines and processes
+// them on the calling thread plus helper tasks handed to an executor.
+// Batches are cut lazily at the first newline after `batchBytes`, so the
+// split costs one short scan per batch. At most `window` batches are
+// claimed and not yet written: that bounds both the reorder buffer
+// (ordered mode) and the memory held by finished batches. The caller
+// writes the output and takes batches itself whenever it would otherwise
+// wait, so a busy or missing pool only costs parallelism; helpers that
+// never get to run find nothing left to claim.
+class JsonLinesRun : public std::enable_shared_from_this<JsonLinesRun> {
+public:
+    // Appends the output lines of the records in [first, last) to `text`;
+    // false if any of them failed.
+    using Batch = std::function<bool(const char* first, const char* last, std::string& text)>;
+
+    JsonLinesRun(const char* data, size_t size, const core::JsonLinesOptions& options, Batch batch)
+        : data_(data), size_(size), ordered_(options.ordered), batchBytes_(std::max<size_t>(options.batchBytes, 1)),
+          parallelism_(options.parallelism ? options.parallelism
+                                           : std::max(1u, std::thread::hardware_concurrency())),
+          window_(4 * parallelism_), batch_(std::move(batch)), done_(window_) {}
+
+    bool run(std::ostream& out, const core::TaskExecutor& executor) {
+        if (executor) spawnHelpers(executor);
+        std::vector<std::string> ready;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            takeReady(ready);
+            if (!ready.empty()) {
+                lock.unlock();
+                for (const auto& text : ready) out.write(text.data(), static_cast<std::streamsize>(text.size()));
+                ready.clear();
+                if (executor) spawnHelpers(executor);
+                lock.lock();
+                continue;
+            }
+            size_t seq;
+            const char* first;
+            const char* last;
+            if (claim(seq, first, last)) {
+                lock.unlock();
+                process(seq, first, last);
+                lock.lock();
+                continue;
             }
+            if (cursor_ == size_ && outstanding_ == 0) break;
+            wakeCaller_.wait(lock);
+        }
+        // Helpers that started may still be returning from their last claim.
+        closed_ = true;
+        wakeCaller_.wait(lock, [&] { return running_ == 0; });
+        return !failed_ && out.good();
+    }
 
-            const auto& firstKey = target.front();
-            auto it = srcJson.find(firstKey);
-            if (it == srcJson.end()) {
-                std::cerr << "[JsonProcess] Target key not found: " << firstKey << "\n";
-                return false;
+private:
+    void spawnHelpers(const core::TaskExecutor& executor) {
+        size_t spawn = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (cursor_ == size_ || closed_) return;
+            while (posted_ + 1 < parallelism_) { ++posted_; ++spawn; }
+        }
+        auto self = shared_from_this();
+        for (; spawn > 0; --spawn) {
+            try {
+                executor([self] { self->help(); });
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(self->mutex_);
+                --self->posted_;
             }
+        }
+    }
 
-            if (!ensurePathExists(*it, target, 1)) {
-                std::cerr << "[JsonProcess] Target path not found under key: "
-                          << firstKey << "\n";
-                return false;
+    void help() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // run() waits for these counters, so they are released even if
+        // help() leaves by an exception.
+        struct Leave {
+            JsonLinesRun& run;
+            std::unique_lock<std::mutex>& lock;
+            bool running = false;
+            ~Leave() {
+                if (!lock.owns_lock()) lock.lock();
+                if (running) --run.running_;
+                --run.posted_;
+                run.wakeCaller_.notify_one();
             }
+        } leave{*this, lock};
+        if (closed_) return;
+        ++running_;
+        leave.running = true;
+        size_t seq;
+        const char* first;
+        const char* last;
+        while (claim(seq, first, last)) {
+            lock.unlock();
+            process(seq, first, last);
+            lock.lock();
+        }
+    }
 
-            json movedBranch = *it;
-            srcJson.erase(it);
+    // Next batch, under the lock.
+    bool claim(size_t& seq, const char*& first, const char*& last) {
+        if (cursor_ == size_ || outstanding_ == window_) return false;
+        first = data_ + cursor_;
+        size_t end = std::min(size_, cursor_ + batchBytes_);
+        if (end < size_) {
+            const void* nl = std::memchr(data_ + end - 1, '\n', size_ - end + 1);
+            end = nl ? static_cast<size_t>(static_cast<const char*>(nl) - data_) + 1 : size_;
+        }
+        last = data_ + end;
+        cursor_ = end;
+        seq = next_++;
+        ++outstanding_;
+        return true;
+    }
 
-            json* current = &srcJson;
-            for (const auto& key : prefix) {
-                if (current->is_null()) *current = json::object();
-                if (!current->is_object()) {
-                    std::cerr << "[JsonProcess] Cannot create prefix under non-object: "
-                              << key << "\n";
-                    return false;
-                }
-                current = &((*current)[key]);
+    // Always hands the batch back, so the writer never waits on a slot
+    // that will not fill. A batch that threw (bad_alloc, say) may have
+    // stopped mid-line: its output is dropped and the run fails.
+    void process(size_t seq, const char* first, const char* last) {
+        std::string text;
+        bool ok = false;
+        try {
+            ok = batch_(first, last, text);
+        } catch (...) {
+            text.clear();
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!ok) failed_ = true;
+        if (ordered_) {
+            done_[seq % window_] = Slot{std::move(text), true};
+        } else {
+            try {
+                unordered_.push_back(std::move(text));
+            } catch (...) {
+                failed_ = true;
+                --outstanding_; // nothing left to write for it
             }
-            if (current->is_null()) *current = json::object();
-            if (!current->is_object()) {
-                std::cerr << "[JsonProcess] Prefix terminates at non-object node\n";
-                return false;
+        }
+        wakeCaller_.notify_one();
+    }
+
+    // Finished batches that may be written now, under the lock.
+    void takeReady(std::vector<std::string>& ready) {
+        if (ordered_) {
+            while (done_[written_ % window_].full) {
+                Slot& slot = done_[written_++ % window_];
+                ready.push_back(std::move(slot.text));
+                slot = Slot{};
+                --outstanding_;
             }
+            return;
+        }
+        outstanding_ -= unordered_.size();
+        ready.swap(unordered_);
+    }
+
+    struct Slot {
+        std::string text;
+        bool full = false;
+    };
+
+    const char* data_;
+    size_t size_;
+    bool ordered_;
+    size_t batchBytes_;
+    size_t parallelism_;
+    size_t window_;
+    Batch batch_;
+
+    std::mutex mutex_;
+    std::condition_variable wakeCaller_;
+    size_t cursor_ = 0;      // byte offset of the next batch
+    size_t next_ = 0;        // sequence number of the next batch
+    size_t written_ = 0;     // ordered: sequence number of the next batch to write
+    size_t outstanding_ = 0; // claimed and not yet taken for writing
+    size_t posted_ = 0;      // helpers handed to the executor and not finished
+    size_t running_ = 0;     // helpers inside help()
+    bool closed_ = false;
+    bool failed_ = false;
+    std::vector<Slot> done_;               // ordered: reorder buffer, by seq % window_
+    std::vector<std::string> unordered_;   // unordered: finished, in completion order
+};
+
+} // namespace
+
+namespace core {
 
-            (*current)[firstKey] = movedBranch;
+// Parsed document. An object root is kept as its members, each behind its
+// own shared pointer: queries read them in place and "add" builds a new
+// member list that shares every member except the ones it rewrites. The
+// list is an IndexedOrderedMap, so wide roots get the same hash lookup as
+// wide objects inside the tree.
+//
+// "add" copies no values. Each object on the path to the insertion point
+// becomes a JsonDocument of its own, and its untouched children point into
+// the tree they came from. The moved branch is shared as it is.
+class JsonDocument : public IJsonDocument {
+public:
+    // A parsed value, or an object that add() rebuilt as a document.
+    struct Value {
+        std::shared_ptr<const json> parsed;
+        std::shared_ptr<const JsonDocument> object;
+    };
+    using Members = IndexedOrderedMap<std::string, Value>;
+    using Member = Members::value_type; // {key, value}
 
-            std::vector<std::string> combined = prefix;
-            combined.insert(combined.end(), target.begin(), target.end());
-            result["results"] = json::array();
-            result["newPath"] = joinPath(combined);
-            result["updatedJson"] = srcJson;
+    // `output` is the encoding of the reports from process(). The tree is
+    // built in an arena of its own, sized from the input, that the members
+    // keep alive, so the last handle sharing a member frees the whole parse
+    // at once.
+    static std::shared_ptr<const JsonDocument> parse(const char* first, const char* last,
+                                                     JsonFormat input = JsonFormat::Auto,
+                                                     JsonFormat output = JsonFormat::Json) {
+        auto arena = std::make_shared<JsonArena>(static_cast<size_t>(last - first));
+        JsonArena::Scope scope(arena.get());
+        json root;
+        std::string error;
+        if (!decodeJson(first, last, input, root, error)) {
+            logErr() << "[JsonProcess] parse failed: " << error << "\n";
+            return nullptr;
+        }
+        auto doc = std::make_shared<JsonDocument>();
+        doc->output_ = output;
+        if (root.is_object()) {
+            doc->members_.reserve(root.size());
+            for (auto it = root.begin(); it != root.end(); ++it) {
+                doc->members_.emplace(it.key(), Value{makeArenaShared(arena, std::move(it.value())), nullptr});
+            }
         } else {
-            std::cerr << "[JsonProcess] Unsupported processMethod: "
-                      << processMethod << "\n";
+            doc->scalar_ = makeArenaShared(arena, std::move(root));
+        }
+        return doc;
+    }
+
+    bool process(std::string& outContent,
+                 const std::string& keywords,
+                 const std::string& processMethod) const override {
+        return writeString(outContent, output_, [&](ReportWriter& w) { return process(w, keywords, processMethod); });
+    }
+
+    bool process(std::ostream& out,
+                 const std::string& keywords,
+                 const std::string& processMethod,
+                 int indent) const override {
+        ReportWriter w(out, indent, output_);
+        const bool ok = process(w, keywords, processMethod);
+        return w.flush() && ok;
+    }
+
+    bool process(ReportWriter& out,
+                 const std::string& keywords,
+                 const std::string& processMethod) const {
+        if (processMethod == "find") {
+            logOut() << "[JsonProcess] processMethod: find\n";
+            return find(keywords, out);
+        }
+        if (processMethod == "add") {
+            logOut() << "[JsonProcess] processMethod: add\n";
+            return add(keywords, out) != nullptr;
+        }
+        if (processMethod == "findBatch") {
+            logOut() << "[JsonProcess] processMethod: findBatch\n";
+            return findBatch(splitQueries(keywords), out);
+        }
+        if (processMethod == "query") {
+            logOut() << "[JsonProcess] processMethod: query\n";
+            return query(keywords, out);
+        }
+        logErr() << "[JsonProcess] Unsupported processMethod: "
+                  << processMethod << "\n";
+        return false;
+    }
+
+    bool find(const std::string& path, std::string& outContent) const override {
+        return writeString(outContent, output_, [&](ReportWriter& w) { return find(path, w); });
+    }
+
+    bool find(const std::string& path, ReportWriter& out) const {
+        const auto keys = splitPath(path);
+        if (keys.empty()) {
+            logErr() << "[JsonProcess] keywords are empty\n";
             return false;
         }
 
-        outContent = result.dump(4);
+        std::vector<const json*> results;
+        if (!isObject()) {
+            logErr() << "[JsonProcess] Root JSON is not an object\n";
+        } else if (const Member* m = member(keys[0])) {
+            collect(m->second, keys, 1, results);
+        } else {
+            logErr() << "[JsonProcess] Top-level key not found: "
+                      << keys[0] << "\n";
+        }
+
+        out.head("find", path);
+        out.results(results);
+        out.tail();
+        return true;
+    }
+
+    bool findBatch(const std::vector<std::string>& paths, std::string& outContent) const override {
+        return writeString(outContent, output_, [&](ReportWriter& w) { return findBatch(paths, w); });
+    }
+
+    bool findBatch(const std::vector<std::string>& paths, ReportWriter& out) const {
+        PathTrie trie;
+        std::vector<size_t> slots;
+        if (!buildTrie(paths, trie, slots)) return false;
+        if (!isObject()) logErr() << "[JsonProcess] Root JSON is not an object\n";
+
+        std::vector<std::vector<const json*>> bySlot(trie.slots);
+        auto sink = [&](size_t slot, const json& v) { bySlot[slot].push_back(&v); };
+        for (const auto& [key, c] : trie.nodes[0].children) {
+            if (const Member* m = member(key)) collect(m->second, trie, c, sink);
+        }
+
+        out.head("findBatch", joinQueries(paths));
+        out.batchResults(paths, slots, bySlot);
+        out.tail();
         return true;
     }
+
+    bool query(const std::string& expr, std::string& outContent) const override {
+        return writeString(outContent, output_, [&](ReportWriter& w) { return query(expr, w); });
+    }
+
+    bool query(const std::string& expr, ReportWriter& out) const {
+        std::string error;
+        auto q = jsonpath::QueryCache::shared().get(expr, error);
+        if (!q) {
+            logErr() << "[JsonProcess] Invalid query " << expr << ": " << error << "\n";
+            return false;
+        }
+
+        std::vector<const json*> results;
+        json root; // only for a query selecting the whole document
+        if (!isObject()) {
+            q->run(*scalar_, results);
+        } else if (q->selectsRoot()) {
+            root = toJson();
+            results.push_back(&root);
+        } else {
+            std::vector<jsonpath::Query::Member> members;
+            members.reserve(members_.size());
+            for (const auto& m : members_) members.emplace_back(&m.first, &asJson(m.second));
+            q->run(members, results);
+        }
+
+        out.head("query", expr);
+        out.results(results);
+        out.tail();
+        return true;
+    }
+
+    std::shared_ptr<const IJsonDocument> add(const std::string& keywords,
+                                             std::string& outContent) const override {
+        return writeString(outContent, output_, [&](ReportWriter& w) { return add(keywords, w); });
+    }
+
+    std::shared_ptr<const IJsonDocument> add(const std::string& keywords, ReportWriter& out) const {
+        std::vector<std::string> prefix;
+        std::vector<std::string> target;
+        if (!parseAddKeywords(keywords, prefix, target)) {
+            logErr() << "[JsonProcess] Invalid add keywords, use `prefix|target`\n";
+            return nullptr;
+        }
+
+        if (!isObject()) {
+            logErr() << "[JsonProcess] Root JSON must be object for add\n";
+            return nullptr;
+        }
+
+        const auto& firstKey = target.front();
+        const Member* moved = member(firstKey);
+        if (!moved) {
+            logErr() << "[JsonProcess] Target key not found: " << firstKey << "\n";
+            return nullptr;
+        }
+
+        if (!pathExists(moved->second, target, 1)) {
+            logErr() << "[JsonProcess] Target path not found under key: "
+                      << firstKey << "\n";
+            return nullptr;
+        }
+
+        auto updated = std::make_shared<JsonDocument>();
+        updated->members_.reserve(members_.size() + 1);
+        for (const auto& m : members_) {
+            if (&m != moved) updated->members_.insert(m);
+        }
+
+        auto head = updated->members_.find(prefix.front());
+        const bool existing = head != updated->members_.end();
+        auto branch = graft(existing ? &head->second : nullptr, prefix, 1, firstKey, moved->second);
+        if (!branch) return nullptr;
+        if (existing) head->second = Value{nullptr, std::move(branch)};
+        else updated->members_.emplace(prefix.front(), Value{nullptr, std::move(branch)});
+
+        std::vector<std::string> combined = prefix;
+        combined.insert(combined.end(), target.begin(), target.end());
+        out.head("add", keywords);
+        out.added(joinPath(combined), *updated);
+        out.tail();
+        return updated;
+    }
+
+    std::string dump(int indent) const override {
+        std::string out;
+        {
+            ReportWriter w(out, indent);
+            writeTo(w, 0);
+        }
+        return out;
+    }
+
+    // The document in the layout of dump(indent) nested at `level`.
+    void writeTo(ReportWriter& out, int level) const {
+        if (!isObject()) {
+            out.value(*scalar_, level);
+            return;
+        }
+        if (members_.empty()) {
+            out.raw("{}");
+            return;
+        }
+        out.raw('{');
+        bool first = true;
+        for (const auto& m : members_) {
+            if (!first) out.raw(',');
+            first = false;
+            out.newline(level + 1);
+            out.key(m.first);
+            if (m.second.object) m.second.object->writeTo(out, level + 1);
+            else out.value(*m.second.parsed, level + 1);
+        }
+        out.newline(level);
+        out.raw('}');
+    }
+
+    json toJson() const {
+        if (!isObject()) return *scalar_;
+        json root = json::object();
+        for (const auto& m : members_) {
+            root[m.first] = m.second.object ? m.second.object->toJson() : *m.second.parsed;
+        }
+        return root;
+    }
+
+private:
+    bool isObject() const { return scalar_ == nullptr; }
+
+    // A rebuilt object as one json value, built on first use; only needed
+    // when a query or result selects the object itself. It lives on the
+    // heap whatever arena the caller is parsing into.
+    static const json& asJson(const Value& v) {
+        if (!v.object) return *v.parsed;
+        const JsonDocument& d = *v.object;
+        std::call_once(d.flatOnce_, [&d] {
+            JsonArena::Scope heap(nullptr);
+            d.flat_ = makeArenaShared(std::shared_ptr<JsonArena>(), d.toJson());
+        });
+        return *d.flat_;
+    }
+
+    static bool pathExists(const Value& v, const std::vector<std::string>& path, size_t idx) {
+        if (!v.object) return ensurePathExists(*v.parsed, path, idx);
+        if (idx >= path.size()) return true;
+        const Member* m = v.object->member(path[idx]);
+        return m && pathExists(m->second, path, idx + 1);
+    }
+
+    // collect_by_path / collect_by_trie through rebuilt objects.
+    static void collect(const Value& v, const std::vector<std::string>& keys, size_t idx,
+                        std::vector<const json*>& results) {
+        if (!v.object) {
+            collect_by_path(*v.parsed, keys, idx, results);
+        } else if (idx >= keys.size()) {
+            results.push_back(&asJson(v));
+        } else if (const Member* m = v.object->member(keys[idx])) {
+            collect(m->second, keys, idx + 1, results);
+        }
+    }
+
+    template <class Sink>
+    static void collect(const Value& v, const PathTrie& trie, size_t t, Sink& sink) {
+        if (!v.object) {
+            collect_by_trie(*v.parsed, trie, t, true, sink);
+            return;
+        }
+        const auto& tn = trie.nodes[t];
+        if (tn.slot != PathTrie::npos) sink(tn.slot, asJson(v));
+        for (const auto& [key, c] : tn.children) {
+            if (const Member* m = v.object->member(key)) collect(m->second, trie, c, sink);
+        }
+    }
+
+    // The object at prefix[0..idx) (`node`, null when missing) rebuilt with
+    // the rest of the prefix below it and `value` under `key` at its end.
+    // Only this path is new: every other member is the pointer it was, or
+    // an aliasing pointer into the parsed tree it came from.
+    static std::shared_ptr<const JsonDocument> graft(const Value* node,
+                                                     const std::vector<std::string>& prefix, size_t idx,
+                                                     const std::string& key, const Value& value) {
+        auto rebuilt = std::make_shared<JsonDocument>();
+        if (node && node->object) {
+            const Members& from = node->object->members_;
+            rebuilt->members_.reserve(from.size() + 1);
+            rebuilt->members_.insert(from.begin(), from.end());
+        } else if (node && !node->parsed->is_null()) {
+            const json& parsed = *node->parsed;
+            if (!parsed.is_object()) {
+                if (idx < prefix.size()) {
+                    logErr() << "[JsonProcess] Cannot create prefix under non-object: "
+                              << prefix[idx] << "\n";
+                } else {
+                    logErr() << "[JsonProcess] Prefix terminates at non-object node\n";
+                }
+                return nullptr;
+            }
+            rebuilt->members_.reserve(parsed.size() + 1);
+            for (auto it = parsed.begin(); it != parsed.end(); ++it) {
+                rebuilt->members_.emplace(it.key(), Value{std::shared_ptr<const json>(node->parsed, &it.value()), nullptr});
+            }
+        }
+
+        if (idx == prefix.size()) {
+            auto slot = rebuilt->members_.find(key);
+            if (slot != rebuilt->members_.end()) slot->second = value;
+            else rebuilt->members_.emplace(key, Value(value));
+            return rebuilt;
+        }
+        auto child = rebuilt->members_.find(prefix[idx]);
+        const bool existing = child != rebuilt->members_.end();
+        auto below = graft(existing ? &child->second : nullptr, prefix, idx + 1, key, value);
+        if (!below) return nullptr;
+        if (existing) child->second = Value{nullptr, std::move(below)};
+        else rebuilt->members_.emplace(prefix[idx], Value{nullptr, std::move(below)});
+        return rebuilt;
+    }
+
+    const Member* member(const std::string& key) const {
+        auto it = members_.find(key);
+        return it != members_.end() ? &*it : nullptr;
+    }
+
+    Members members_;
+    std::shared_ptr<const json> scalar_; // root that is not an object
+    JsonFormat output_ = JsonFormat::Json;
+    mutable std::once_flag flatOnce_; // see asJson()
+    mutable std::shared_ptr<const json> flat_;
+};
+
+class JsonProcess : public IJsonProcess {
+public:
+    bool processJsonFiles(const std::string& srcContent,
+                          std::string& outContent,
+                          const std::string& keywords,
+                          const std::string& processMethod) override {
+        return writeString(outContent, output_, [&](ReportWriter& w) {
+            return process(srcContent.data(), srcContent.data() + srcContent.size(),
+                           input_, output_, w, keywords, processMethod);
+        });
+    }
+
+    bool processJsonFile(const std::string& srcPath,
+                         std::string& outContent,
+                         const std::string& keywords,
+                         const std::string& processMethod) override {
+        rt::MappedFile src;
+        if (!src.openRead(srcPath, rt::MappedFile::Access::Sequential)) {
+            logErr() << "[JsonProcess] cannot map " << srcPath << "\n";
+            return false;
+        }
+        return writeString(outContent, output_, [&](ReportWriter& w) {
+            return process(src.data(), src.data() + src.size(), input_, output_, w, keywords, processMethod);
+        });
+    }
+
+    bool processJsonFile(const std::string& srcPath,
+                         std::ostream& out,
+                         const std::string& keywords,
+                         const std::string& processMethod,
+                         int indent) override {
+        rt::MappedFile src;
+        if (!src.openRead(srcPath, rt::MappedFile::Access::Sequential)) {
+            logErr() << "[JsonProcess] cannot map " << srcPath << "\n";
+            return false;
+        }
+        ReportWriter w(out, indent, output_);
+        const bool ok = process(src.data(), src.data() + src.size(), input_, output_, w, keywords, processMethod);
+        return w.flush() && ok;
+    }
+
+    std::shared_ptr<const IJsonDocument> parseDocument(const std::string& srcContent) override {
+        return JsonDocument::parse(srcContent.data(), srcContent.data() + srcContent.size(), input_, output_);
+    }
+
+    std::shared_ptr<const IJsonDocument> parseDocumentFile(const std::string& srcPath) override {
+        rt::MappedFile src;
+        if (!src.openRead(srcPath, rt::MappedFile::Access::Sequential)) {
+            logErr() << "[JsonProcess] cannot map " << srcPath << "\n";
+            return nullptr;
+        }
+        return JsonDocument::parse(src.data(), src.data() + src.size(), input_, output_);
+    }
+
+    bool findBatch(const std::string& srcContent,
+                   const std::vector<std::string>& paths,
+                   std::string& outContent) override {
+        return writeString(outContent, output_, [&](ReportWriter& w) {
+            return streamingFindBatch(srcContent.data(), srcContent.data() + srcContent.size(), input_, paths, w);
+        });
+    }
+
+    void setFormats(JsonFormat input, JsonFormat output) override {
+        input_ = input;
+        output_ = output;
+    }
+
+    void setExecutor(TaskExecutor executor) override { executor_ = std::move(executor); }
+
+    bool processJsonLines(const std::string& srcPath,
+                          std::ostream& out,
+                          const std::string& keywords,
+                          const std::string& processMethod,
+                          const JsonLinesOptions& options) override {
+        static const char* const methods[] = {"find", "findBatch", "query", "add"};
+        if (std::find(std::begin(methods), std::end(methods), processMethod) == std::end(methods)) {
+            logErr() << "[JsonProcess] Unsupported processMethod: " << processMethod << "\n";
+            return false;
+        }
+        rt::MappedFile src;
+        if (!src.openRead(srcPath, rt::MappedFile::Access::Sequential)) {
+            logErr() << "[JsonProcess] cannot map " << srcPath << "\n";
+            return false;
+        }
+        logOut() << "[JsonProcess] processMethod: " << processMethod << " (JSON Lines)\n";
+        const char* base = src.data();
+        auto run = std::make_shared<JsonLinesRun>(
+            src.data(), src.size(), options,
+            [&, base](const char* first, const char* last, std::string& text) {
+                return processRecords(base, first, last, text, keywords, processMethod);
+            });
+        const bool ok = run->run(out, executor_);
+        out.flush();
+        return ok && out.good();
+    }
+
+private:
+    static bool process(const char* first, const char* last,
+                        JsonFormat input, JsonFormat output,
+                        ReportWriter& out,
+                        const std::string& keywords,
+                        const std::string& processMethod) {
+        if (processMethod == "find") return streamingFind(first, last, input, keywords, out);
+        if (processMethod == "findBatch") {
+            logOut() << "[JsonProcess] processMethod: findBatch\n";
+            return streamingFindBatch(first, last, input, splitQueries(keywords), out);
+        }
+        auto doc = JsonDocument::parse(first, last, input, output);
+        return doc && doc->process(out, keywords, processMethod);
+    }
+
+    // One output line per non-blank line in [first, last); `base` is the
+    // start of the file, for the offsets. Diagnostics of a failing record
+    // become its error line instead of going to stderr.
+    static bool processRecords(const char* base, const char* first, const char* last, std::string& text,
+                               const std::string& keywords, const std::string& processMethod) {
+        RecordLog log;
+        RecordLogScope scope(log);
+        bool ok = true;
+        for (const char* line = first; line < last;) {
+            const char* nl = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(last - line)));
+            const char* end = nl ? nl : last;
+            const char* next = nl ? nl + 1 : last;
+            if (end > line && end[-1] == '\r') --end;
+            if (std::all_of(line, end, [](char c) { return std::isspace(static_cast<unsigned char>(c)); })) {
+                line = next;
+                continue;
+            }
+            const size_t mark = text.size();
+            bool recordOk = false;
+            try {
+                ReportWriter w(text, -1);
+                w.record(static_cast<size_t>(line - base));
+                recordOk = process(line, end, JsonFormat::Json, JsonFormat::Json, w, keywords, processMethod);
+            } catch (const std::exception& e) {
+                log.errors << "[JsonProcess] " << e.what() << "\n";
+            }
+            if (!recordOk) {
+                ok = false;
+                text.resize(mark);
+                text += "{\"offset\":" + std::to_string(line - base) + ",\"error\":" +
+                        nlohmann::json(lastError(log.errors.str()))
+                                    .dump(-1, ' ', false, nlohmann::json::error_handler_t::replace) + "}";
+            }
+            text += '\n';
+            log.errors.str(std::string());
+            line = next;
+        }
+        return ok;
+    }
+
+    // Last diagnostic line, without the plugin prefix.
+    static std::string lastError(const std::string& errors) {
+        std::string line = trim(errors);
+        const auto nl = line.rfind('\n');
+        if (nl != std::string::npos) line = line.substr(nl + 1);
+        const std::string prefix = "[JsonProcess] ";
+        if (line.compare(0, prefix.size(), prefix) == 0) line = line.substr(prefix.size());
+        return line.empty() ? "record failed" : line;
+    }
+
+    JsonFormat input_ = JsonFormat::Auto;
+    JsonFormat output_ = JsonFormat::Json;
+    TaskExecutor executor_;
 };
 
 } // namespace core
@@ -1,5 +1,6 @@
 #pragma once
 #include "core/IObject.hpp"
+#include "core/JsonFormat.hpp"
 #include <string>
 
 namespace core {
@@ -14,6 +15,9 @@ public:
     virtual bool compareFiles(const std::string& oursPath,
                               const std::string& goldenPath,
                               const std::string& outPath) = 0;
+
+    // Encoding of both inputs; Auto (the default) detects it per file.
+    virtual void setInputFormat(JsonFormat format) = 0;
 };
 
 } // namespace core
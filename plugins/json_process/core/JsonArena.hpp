@@ -0,0 +1,142 @@
+#pragma once
+#include "core/IndexedOrderedMap.hpp"
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace core {
+
+// Monotonic arena for the JSON plugins' DOMs: allocation bumps a pointer
+// through geometrically growing chunks, deallocation is a no-op and the
+// memory goes back in one release() when the arena dies. Containers that
+// grow leave their old buffers behind, so a DOM takes up to about twice
+// its heap footprint here; the point is a per-request allocator that never
+// touches malloc's shared state on the hot path.
+class JsonArena {
+public:
+    JsonArena() = default;
+    // First chunk sized for a DOM parsed from about `inputBytes` of input
+    // (1 KB to the default 64 KB), so a small document, such as one JSON
+    // Lines record, is not handed a full chunk from malloc's shared pool.
+    explicit JsonArena(size_t inputBytes)
+        : firstChunk_(std::min(kFirstChunk, std::max(kMinChunk, 4 * inputBytes))), nextChunk_(firstChunk_) {}
+    ~JsonArena() { release(); }
+    JsonArena(const JsonArena&) = delete;
+    JsonArena& operator=(const JsonArena&) = delete;
+
+    void* allocate(size_t bytes, size_t align) {
+        size_t offset = (used_ + align - 1) & ~(align - 1);
+        if (offset + bytes > capacity_) {
+            grow(bytes);
+            offset = 0; // chunks come from operator new, aligned for any JSON type
+        }
+        used_ = offset + bytes;
+        ++allocations_;
+        return chunks_.back() + offset;
+    }
+
+    void release() {
+        for (char* chunk : chunks_) ::operator delete(chunk);
+        chunks_.clear();
+        used_ = capacity_ = reserved_ = 0;
+        nextChunk_ = firstChunk_;
+    }
+
+    size_t allocations() const { return allocations_; }
+    size_t bytesReserved() const { return reserved_; }
+
+    // Points ArenaAllocator at `arena` on this thread while alive (nullptr:
+    // the heap). Scopes nest.
+    class Scope {
+    public:
+        explicit Scope(JsonArena* arena) : prev_(current()) { current() = arena; }
+        ~Scope() { current() = prev_; }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        JsonArena* prev_;
+    };
+
+    static JsonArena*& current() {
+        static thread_local JsonArena* arena = nullptr;
+        return arena;
+    }
+
+private:
+    static constexpr size_t kMinChunk = size_t(1) << 10;
+    static constexpr size_t kFirstChunk = size_t(64) << 10;
+    static constexpr size_t kMaxChunk = size_t(16) << 20;
+
+    void grow(size_t atLeast) {
+        const size_t size = std::max(atLeast, nextChunk_);
+        nextChunk_ = std::min(nextChunk_ * 2, kMaxChunk);
+        chunks_.push_back(static_cast<char*>(::operator new(size)));
+        capacity_ = size;
+        used_ = 0;
+        reserved_ += size;
+    }
+
+    std::vector<char*> chunks_;
+    size_t used_ = 0;
+    size_t capacity_ = 0;
+    size_t reserved_ = 0;
+    size_t firstChunk_ = kFirstChunk;
+    size_t nextChunk_ = kFirstChunk;
+    size_t allocations_ = 0;
+};
+
+// Stateless allocator for ArenaJson (basic_json default-constructs its
+// allocators): draws from the thread's current JsonArena, or the heap when
+// there is none, and frees by the same rule. A value must therefore be
+// destroyed under the scope it was built in; makeArenaShared() arranges
+// that for values that outlive it.
+template <class T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    ArenaAllocator() noexcept = default;
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        if (JsonArena* arena = JsonArena::current())
+            return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t) noexcept {
+        if (!JsonArena::current()) ::operator delete(p);
+    }
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>&) const noexcept { return true; }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>&) const noexcept { return false; }
+};
+
+// ordered_json with object, array and string nodes (and container buffers)
+// placed through ArenaAllocator, and objects hash-indexed by key once they
+// are large (IndexedOrderedMap). String contents beyond the small-string
+// buffer still live on the heap.
+using ArenaJson = nlohmann::basic_json<IndexedOrderedMap, std::vector, std::string, bool,
+                                       std::int64_t, std::uint64_t, double, ArenaAllocator>;
+
+// Shared handle to a value built under `arena`: it is destroyed under the
+// arena and keeps it alive until then.
+template <class Json>
+std::shared_ptr<const Json> makeArenaShared(const std::shared_ptr<JsonArena>& arena, Json value) {
+    return std::shared_ptr<const Json>(new Json(std::move(value)), [arena](const Json* p) {
+        JsonArena::Scope scope(arena.get());
+        delete p;
+    });
+}
+
+} // namespace core
@@ -0,0 +1,98 @@
+#pragma once
+#include "core/JsonFormat.hpp"
+#include <nlohmann/json.hpp>
+
+#include <exception>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace core {
+
+inline nlohmann::detail::input_format_t inputFormat(JsonFormat format) {
+    using F = nlohmann::detail::input_format_t;
+    switch (format) {
+    case JsonFormat::Cbor: return F::cbor;
+    case JsonFormat::MsgPack: return F::msgpack;
+    case JsonFormat::Ubjson: return F::ubjson;
+    case JsonFormat::Bson: return F::bson;
+    default: return F::json;
+    }
+}
+
+// SAX pass over `[first, last)` in a concrete format. CBOR tags (such as
+// the self-describe prefix) are skipped.
+template <class Json, class Sax>
+bool saxDecode(const char* first, const char* last, JsonFormat format, Sax* sax) {
+    if (format == JsonFormat::Json || format == JsonFormat::Auto)
+        return Json::sax_parse(first, last, sax);
+    auto ia = nlohmann::detail::input_adapter(first, last);
+    const auto f = inputFormat(format);
+    return nlohmann::detail::binary_reader<Json, decltype(ia), Sax>(std::move(ia), f)
+        .sax_parse(f, sax, true, nlohmann::detail::cbor_tag_handler_t::ignore);
+}
+
+// Settles Auto: the only candidate of detectFormats(), or the first one
+// that validates (without building values) when the leading byte is
+// ambiguous.
+template <class Json>
+JsonFormat resolveFormat(const char* first, const char* last, JsonFormat format) {
+    if (format != JsonFormat::Auto) return format;
+    const auto candidates = detectFormats(first, last);
+    if (candidates.size() == 1) return candidates.front();
+    for (auto candidate : candidates) {
+        nlohmann::detail::json_sax_acceptor<Json> acceptor;
+        try {
+            if (saxDecode<Json>(first, last, candidate, &acceptor)) return candidate;
+        } catch (const std::exception&) {
+        }
+    }
+    return candidates.front();
+}
+
+// Parses `[first, last)`; false with `error` set on malformed input.
+template <class Json>
+bool decodeJson(const char* first, const char* last, JsonFormat format, Json& out, std::string& error) {
+    try {
+        switch (resolveFormat<Json>(first, last, format)) {
+        case JsonFormat::Cbor:
+            out = Json::from_cbor(first, last, true, true, nlohmann::detail::cbor_tag_handler_t::ignore);
+            break;
+        case JsonFormat::MsgPack: out = Json::from_msgpack(first, last); break;
+        case JsonFormat::Ubjson: out = Json::from_ubjson(first, last); break;
+        case JsonFormat::Bson: out = Json::from_bson(first, last); break;
+        default: out = Json::parse(first, last); break;
+        }
+    } catch (const std::exception& e) {
+        error = e.what();
+        return false;
+    }
+    return true;
+}
+
+// Serializes `value` into `out`; `indent` applies to JSON text only
+// (< 0 is compact). BSON needs an object and throws otherwise.
+template <class Json>
+void encodeJson(const Json& value, JsonFormat format,
+                nlohmann::detail::output_adapter_t<char> out, int indent = -1) {
+    nlohmann::detail::binary_writer<Json, char> writer(out);
+    switch (format) {
+    case JsonFormat::Cbor: writer.write_cbor(value); break;
+    case JsonFormat::MsgPack: writer.write_msgpack(value); break;
+    case JsonFormat::Ubjson: writer.write_ubjson(value, true, false); break;
+    case JsonFormat::Bson: writer.write_bson(value); break;
+    default: {
+        nlohmann::detail::serializer<Json> s(out, ' ');
+        if (indent >= 0) s.dump(value, true, false, static_cast<unsigned>(indent));
+        else s.dump(value, false, false, 0);
+        break;
+    }
+    }
+}
+
+template <class Json>
+void encodeJson(const Json& value, JsonFormat format, std::ostream& out, int indent = -1) {
+    encodeJson(value, format, std::make_shared<nlohmann::detail::output_stream_adapter<char>>(out), indent);
+}
+
+} // namespace core
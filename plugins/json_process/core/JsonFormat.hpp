@@ -0,0 +1,89 @@
+#pragma once
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace core {
+
+// Encodings the JSON plugins read and write. Auto (input only) picks the
+// format from the leading bytes, see detectFormats().
+enum class JsonFormat { Auto, Json, Cbor, MsgPack, Ubjson, Bson };
+
+inline const char* formatName(JsonFormat format) {
+    switch (format) {
+    case JsonFormat::Auto: return "auto";
+    case JsonFormat::Json: return "json";
+    case JsonFormat::Cbor: return "cbor";
+    case JsonFormat::MsgPack: return "msgpack";
+    case JsonFormat::Ubjson: return "ubjson";
+    case JsonFormat::Bson: return "bson";
+    }
+    return "?";
+}
+
+inline bool parseFormat(const std::string& name, JsonFormat& out) {
+    for (auto f : {JsonFormat::Auto, JsonFormat::Json, JsonFormat::Cbor,
+                   JsonFormat::MsgPack, JsonFormat::Ubjson, JsonFormat::Bson}) {
+        if (name == formatName(f)) {
+            out = f;
+            return true;
+        }
+    }
+    return false;
+}
+
+// By file extension (.json, .cbor, .msgpack/.mpk, .ubj/.ubjson, .bson);
+// Auto for anything else.
+inline JsonFormat formatFromExtension(const std::string& path) {
+    const auto dot = path.rfind('.');
+    if (dot == std::string::npos) return JsonFormat::Auto;
+    std::string ext = path.substr(dot + 1);
+    for (auto& ch : ext) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    if (ext == "json") return JsonFormat::Json;
+    if (ext == "cbor") return JsonFormat::Cbor;
+    if (ext == "msgpack" || ext == "mpk") return JsonFormat::MsgPack;
+    if (ext == "ubj" || ext == "ubjson") return JsonFormat::Ubjson;
+    if (ext == "bson") return JsonFormat::Bson;
+    return JsonFormat::Auto;
+}
+
+// Candidate formats for `[first, last)`, most likely first. Text is JSON
+// unless a leading '['/'{' is followed by a UBJSON type marker; BSON is
+// recognised by its length prefix matching the size. A leading byte
+// shared by CBOR and MessagePack yields both, to be settled by a parse.
+inline std::vector<JsonFormat> detectFormats(const char* first, const char* last) {
+    const auto* p = reinterpret_cast<const unsigned char*>(first);
+    const auto* end = reinterpret_cast<const unsigned char*>(last);
+    const size_t size = static_cast<size_t>(end - p);
+    if (size >= 5 && end[-1] == 0 &&
+        (uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24) == size)
+        return {JsonFormat::Bson};
+    if (size == 0 || (p[0] != 0 && std::strchr(" \t\r\n", p[0]) != nullptr)) return {JsonFormat::Json};
+
+    const unsigned char c = p[0];
+    if (c == '[' || c == '{') {
+        // What follows the opening brackets differs: whitespace, a quote or
+        // a literal in JSON, a type or count marker in UBJSON.
+        const auto* q = p;
+        while (q < end && *q == '[') ++q;
+        if (q < end && *q == '{') ++q;
+        const bool marker = q < end && *q != 0 && std::strchr("$#ZNTFiUIlLdDCSH", *q) != nullptr;
+        return {marker ? JsonFormat::Ubjson : JsonFormat::Json};
+    }
+    if (size >= 3 && c == 0xEF && p[1] == 0xBB && p[2] == 0xBF) return {JsonFormat::Json}; // UTF-8 BOM
+    if (size >= 3 && c == 0xD9 && p[1] == 0xD9 && p[2] == 0xF7) return {JsonFormat::Cbor}; // self-described
+    if (c >= 0xDC && c <= 0xDF) return {JsonFormat::MsgPack}; // array16/32, map16/32
+    if (c >= 0xA0 && c <= 0xBF) {
+        // CBOR map, or a MessagePack fixstr that is the whole document.
+        if (size == 1 + size_t(c & 0x1F)) return {JsonFormat::MsgPack, JsonFormat::Cbor};
+        return {JsonFormat::Cbor};
+    }
+    if (c >= 0x80 && c <= 0x8F) return {JsonFormat::MsgPack, JsonFormat::Cbor}; // fixmap / CBOR array
+    if (c >= 0x80 || c < 0x20) return {JsonFormat::Cbor, JsonFormat::MsgPack};
+    return {JsonFormat::Json};
+}
+
+} // namespace core
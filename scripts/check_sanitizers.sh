@@ -0,0 +1,21 @@
+#!/usr/bin/env bash
+# 用法: scripts/check_sanitizers.sh [address,undefined|thread ...]
+# 每种 sanitizer 单独构建到 _sanitize_build/*，跑 ctest；address 构建开启 LeakSanitizer，
+# 泄漏即失败。插件输出在 plugins/ 下与普通构建共用，结束时删掉插桩版本，
+# 下次普通构建会重新链接。
+set -euo pipefail
+cd "$(dirname "$0")/.."
+sanitizers=("$@")
+[ ${#sanitizers[@]} -eq 0 ] && sanitizers=("address,undefined" "thread")
+
+cleanup() { rm -f plugins/libjson_process.so plugins/libjson_compare.so plugins/libsimple.so; }
+trap cleanup EXIT
+
+for san in "${sanitizers[@]}"; do
+  dir="_sanitize_build/${san//,/-}"
+  cleanup
+  cmake -S . -B "$dir" -DCMAKE_BUILD_TYPE=Debug -DSPF_SANITIZE="$san" -DSPF_BUILD_BENCH=OFF
+  cmake --build "$dir" -j"$(nproc)"
+  ASAN_OPTIONS=detect_leaks=1:abort_on_error=1 UBSAN_OPTIONS=halt_on_error=1:print_stacktrace=1 \
+    ctest --test-dir "$dir" --output-on-failure
+done
@@ -24,7 +24,6 @@
 #include <thread>
 #include <chrono>
 #include <fstream>
-#include <sstream>
 #include "nlohmann/json.hpp"
 #include <filesystem>
 using namespace core;
@@ -110,59 +109,48 @@ int main()
     auto desAbs = std::filesystem::weakly_canonical(desPath).string();
     std::cout << "[Abs paths] " << srcAbs << " -> " << desAbs << "\n";
 
-    std::ifstream srcStream(srcAbs);
-    if (!srcStream) {
+    std::error_code sizeErr;
+    const auto srcSize = std::filesystem::file_size(srcAbs, sizeErr);
+    if (sizeErr) {
         std::cerr << "[Main] Failed to open " << srcAbs << "\n";
         return -1;
     }
-    std::ostringstream buffer;
-    buffer << srcStream.rdbuf();
-    const std::string srcContent = buffer.str();
-    std::cout << "[Main] Loaded " << srcContent.size() << " bytes from src file\n";
+    std::cout << "[Main] Loading " << srcSize << " bytes from src file\n";
 
-    if (jsonProcess) {
-        std::string pluginOutput;
-        bool ok = jsonProcess->processJsonFiles(
-            srcContent,
-            pluginOutput,
-            "key1/key2",
-            "find");
+    // 插件直接从内存映射解析一次，find / add 共用同一个文档
+    auto srcDoc = jsonProcess ? jsonProcess->parseDocumentFile(srcAbs) : nullptr;
+    if (srcDoc) {
+        // 报告直接写入输出文件，不在内存中拼接
+        std::ofstream out(desAbs);
+        if (!out) {
+            std::cerr << "[Main] Failed to open " << desAbs << " for writing\n";
+            return -1;
+        }
+        bool ok = srcDoc->process(out, "key1/key2", "find");
         if (ok) {
-            std::ofstream out(desAbs);
-            if (!out) {
-                std::cerr << "[Main] Failed to open " << desAbs << " for writing\n";
-                return -1;
-            }
-            out << pluginOutput;
             std::cout << "[Main] Plugin output saved to " << desAbs << "\n";
         } else {
             std::cerr << "[Main] Plugin find() failed\n";
         }
 
         // Demo for the "add" process method: wrap key1/key2 under key11/key12.
-        std::string addOutput;
         const std::string addKeywords = "key11/key12|key1/key2";
         const std::string addOutputPath = "output_add.json";
-        bool addOk = jsonProcess->processJsonFiles(
-            srcContent,
-            addOutput,
-            addKeywords,
-            "add");
+        auto addAbs = std::filesystem::weakly_canonical(addOutputPath).string();
+        std::ofstream addOut(addAbs);
+        if (!addOut) {
+            std::cerr << "[Main] Failed to open " << addAbs << " for writing\n";
+            return -1;
+        }
+        bool addOk = srcDoc->process(addOut, addKeywords, "add");
         if (addOk) {
-            auto addAbs = std::filesystem::weakly_canonical(addOutputPath).string();
-            std::ofstream addOut(addAbs);
-            if (!addOut) {
-                std::cerr << "[Main] Failed to open " << addAbs << " for writing\n";
-                return -1;
-            }
-            addOut << addOutput;
             std::cout << "[Main] Add demo finished, output saved to " << addAbs
                       << " for keywords " << addKeywords << "\n";
         } else {
             std::cerr << "[Main] Plugin add() failed for keywords "
                       << addKeywords << "\n";
         }
-    } else {
+    } else if (!jsonProcess) {
         std::cerr << "Failed to create JsonProcess instance." << std::endl;
     }
 
@@ -0,0 +1,247 @@
+#include "gen/Generator.hpp"
+
+#include <algorithm>
+#include <string>
+
+namespace gen {
+
+namespace {
+
+// splitmix64: cheap, and the same sequence on every platform.
+struct Rng {
+    uint64_t s;
+    explicit Rng(uint64_t seed) : s(seed) {}
+    uint64_t next() {
+        uint64_t z = (s += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    uint64_t below(uint64_t n) { return n ? next() % n : 0; }
+    double unit() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+// Buffered writer to one or two streams; only the buffers are held in
+// memory. Structure goes to both, leaves may differ.
+class Out {
+public:
+    Out(std::ostream& a, std::ostream* b) : a_(a), b_(b) {}
+    ~Out() { flush(); }
+
+    void raw(const std::string& s) { raw(s.data(), s.size()); }
+    void raw(const char* s, size_t n) {
+        bufA_.append(s, n);
+        if (b_) bufB_.append(s, n);
+        spill();
+    }
+    void raw(char c) { raw(&c, 1); }
+    void leaf(const std::string& va, const std::string& vb) {
+        bufA_ += va;
+        if (b_) bufB_ += vb;
+        spill();
+    }
+
+    uint64_t bytes() const { return bytesA_ + bufA_.size(); }
+
+    void flush() {
+        a_.write(bufA_.data(), static_cast<std::streamsize>(bufA_.size()));
+        bytesA_ += bufA_.size();
+        bufA_.clear();
+        if (b_) {
+            b_->write(bufB_.data(), static_cast<std::streamsize>(bufB_.size()));
+            bufB_.clear();
+        }
+    }
+
+private:
+    static constexpr size_t kChunk = 64 * 1024;
+    void spill() {
+        if (bufA_.size() >= kChunk || bufB_.size() >= kChunk) flush();
+    }
+
+    std::ostream& a_;
+    std::ostream* b_;
+    std::string bufA_, bufB_;
+    uint64_t bytesA_ = 0;
+};
+
+std::string quoted(const std::string& s) {
+    std::string q = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') { q += '\\'; q += c; }
+        else if (static_cast<unsigned char>(c) < 0x20) q += ' ';
+        else q += c;
+    }
+    return q + '"';
+}
+
+class JsonWriter {
+public:
+    JsonWriter(Out& out, const JsonSpec& spec, double diffRate)
+        : out_(out), spec_(spec), diffRate_(diffRate), rng_(spec.seed), diffRng_(~spec.seed) {
+        fanout_ = std::max(1, std::min(spec.fanout, std::max(1, spec.keyCardinality)));
+    }
+
+    void item(uint64_t id) {
+        out_.raw("{\"id\":" + std::to_string(id));
+        members(0, true);
+        out_.raw('}');
+        ++stats.items;
+    }
+
+    GenStats stats;
+
+private:
+    // Writes `fanout` distinct keys; `comma` when members precede them.
+    void members(int level, bool comma) {
+        const uint64_t card = static_cast<uint64_t>(std::max(1, spec_.keyCardinality));
+        const uint64_t base = rng_.below(card);
+        for (int j = 0; j < fanout_; ++j) {
+            if (comma || j) out_.raw(',');
+            out_.raw("\"k" + std::to_string((base + static_cast<uint64_t>(j)) % card) + "\":");
+            value(level + 1);
+        }
+    }
+
+    void value(int level) {
+        if (level >= spec_.depth) { leaf(); return; }
+        if (rng_.below(4) == 0) {
+            out_.raw('[');
+            for (int i = 0; i < spec_.arrayLen; ++i) {
+                if (i) out_.raw(',');
+                value(level + 1);
+            }
+            out_.raw(']');
+        } else {
+            out_.raw('{');
+            members(level, false);
+            out_.raw('}');
+        }
+    }
+
+    void leaf() {
+        ++stats.leaves;
+        std::string a = rng_.unit() < spec_.numericRatio ? std::to_string(rng_.below(1000000)) : randomString(rng_);
+        if (diffRate_ > 0 && diffRng_.unit() < diffRate_) {
+            ++stats.diffs;
+            // Same kind of value, always different from `a`.
+            std::string b = a[0] == '"' ? randomString(diffRng_) : std::to_string(1000000 + diffRng_.below(1000000));
+            if (b == a) b.insert(1, "x");
+            out_.leaf(a, b);
+        } else {
+            out_.leaf(a, a);
+        }
+    }
+
+    std::string randomString(Rng& r) {
+        std::string s(static_cast<size_t>(std::max(1, spec_.stringLen)) + 2, '"');
+        for (size_t i = 1; i + 1 < s.size(); ++i) s[i] = static_cast<char>('a' + r.below(26));
+        return s;
+    }
+
+    Out& out_;
+    const JsonSpec& spec_;
+    double diffRate_;
+    Rng rng_, diffRng_;
+    int fanout_;
+};
+
+bool more(const JsonSpec& spec, const Out& out, uint64_t n) {
+    if (spec.targetBytes > 0) return n == 0 || out.bytes() < spec.targetBytes;
+    return n < spec.items;
+}
+
+GenStats writeDocument(Out& out, const JsonSpec& spec, double diffRate) {
+    JsonWriter w(out, spec, diffRate);
+    out.raw("{\"meta\":{\"generator\":\"spf_gen\",\"seed\":" + std::to_string(spec.seed) +
+            ",\"depth\":" + std::to_string(spec.depth) + ",\"fanout\":" + std::to_string(spec.fanout) +
+            "},\"items\":[");
+    for (uint64_t n = 0; more(spec, out, n); ++n) {
+        if (n) out.raw(',');
+        w.item(n);
+    }
+    out.raw("]}\n");
+    out.flush();
+    w.stats.bytes = out.bytes();
+    return w.stats;
+}
+
+} // namespace
+
+GenStats writeJson(std::ostream& os, const JsonSpec& spec) {
+    Out out(os, nullptr);
+    return writeDocument(out, spec, 0.0);
+}
+
+GenStats writeJsonPair(std::ostream& a, std::ostream& b, const JsonSpec& spec, double diffRate) {
+    Out out(a, &b);
+    return writeDocument(out, spec, diffRate);
+}
+
+GenStats writeNdjson(std::ostream& os, const JsonSpec& spec) {
+    Out out(os, nullptr);
+    JsonWriter w(out, spec, 0.0);
+    for (uint64_t n = 0; more(spec, out, n); ++n) {
+        w.item(n);
+        out.raw('\n');
+    }
+    out.flush();
+    w.stats.bytes = out.bytes();
+    return w.stats;
+}
+
+bool parseDagShape(const std::string& s, DagShape& out) {
+    if (s == "wide") out = DagShape::Wide;
+    else if (s == "deep") out = DagShape::Deep;
+    else if (s == "random") out = DagShape::Random;
+    else return false;
+    return true;
+}
+
+GenStats writeWorkflow(std::ostream& os, const WorkflowGenSpec& spec) {
+    Out out(os, nullptr);
+    GenStats stats;
+    const uint64_t n = std::max<uint64_t>(spec.tasks, 1);
+    const std::string cmd = quoted(spec.cmd);
+    auto id = [](uint64_t i) { return "\"t" + std::to_string(i) + "\""; };
+
+    out.raw("{\"final_key\":\"\",\"vars\":{},\"tasks\":[");
+    for (uint64_t i = 0; i < n; ++i) {
+        if (i) out.raw(',');
+        out.raw("\n{\"id\":" + id(i) + ",\"type\":\"Shell\",\"params\":{\"cmd\":" + cmd + "}}");
+        ++stats.items;
+    }
+    out.raw("\n],\"edges\":[");
+    auto edge = [&](uint64_t from, uint64_t to) {
+        out.raw(stats.edges ? ",\n[" : "\n[");
+        out.raw(id(from) + "," + id(to) + "]");
+        ++stats.edges;
+    };
+    switch (spec.shape) {
+    case DagShape::Wide:
+        for (uint64_t i = 1; i + 1 < n; ++i) { edge(0, i); edge(i, n - 1); }
+        if (n == 2) edge(0, 1);
+        break;
+    case DagShape::Deep:
+        for (uint64_t i = 1; i < n; ++i) edge(i - 1, i);
+        break;
+    case DagShape::Random: {
+        Rng rng(spec.seed);
+        const uint64_t window = static_cast<uint64_t>(std::max(1, spec.window));
+        for (uint64_t i = 1; i < n; ++i) {
+            // Distinct parents: k consecutive tasks from a random offset in the window.
+            const uint64_t span = std::min(i, window);
+            const uint64_t k = 1 + rng.below(std::min<uint64_t>(span, static_cast<uint64_t>(std::max(1, spec.maxParents))));
+            const uint64_t start = rng.below(span);
+            for (uint64_t p = 0; p < k; ++p) edge(i - 1 - (start + p) % span, i);
+        }
+        break;
+    }
+    }
+    out.raw("\n]}\n");
+    out.flush();
+    stats.bytes = out.bytes();
+    return stats;
+}
+
+} // namespace gen
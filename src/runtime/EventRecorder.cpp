@@ -0,0 +1,431 @@
+#include "runtime/EventRecorder.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+
+#include "nlohmann/json.hpp"
+
+namespace rt {
+
+// =============== Encoding helpers ===============
+namespace {
+
+inline std::int64_t toNs(EventTime t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+inline EventTime fromNs(std::int64_t ns) {
+    return EventTime(std::chrono::duration_cast<EventClock::duration>(std::chrono::nanoseconds(ns)));
+}
+
+inline std::uint64_t zigzag(std::int64_t v) {
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+inline std::int64_t unzigzag(std::uint64_t v) {
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+inline std::size_t putVarint(char* out, std::uint64_t v) {
+    std::size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = static_cast<char>((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    out[n++] = static_cast<char>(v);
+    return n;
+}
+
+inline void appendVarint(std::string& out, std::uint64_t v) {
+    char buf[10];
+    out.append(buf, putVarint(buf, v));
+}
+
+inline void appendString(std::string& out, const std::string& s) {
+    appendVarint(out, s.size());
+    out.append(s);
+}
+
+// Bounds-checked cursor used by the reader.
+struct Cursor {
+    const char* p;
+    const char* end;
+
+    bool varint(std::uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64 && p < end; shift += 7) {
+            auto b = static_cast<unsigned char>(*p++);
+            v |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+    bool str(std::string& s) {
+        std::uint64_t n;
+        if (!varint(n) || n > static_cast<std::uint64_t>(end - p)) return false;
+        s.assign(p, static_cast<std::size_t>(n));
+        p += n;
+        return true;
+    }
+    bool u8(std::uint8_t& v) {
+        if (p >= end) return false;
+        v = static_cast<std::uint8_t>(*p++);
+        return true;
+    }
+    bool f64(double& v) {
+        if (end - p < 8) return false;
+        std::memcpy(&v, p, 8);
+        p += 8;
+        return true;
+    }
+    bool i32(int& v) {
+        std::uint64_t u;
+        if (!varint(u)) return false;
+        v = static_cast<int>(unzigzag(u));
+        return true;
+    }
+};
+
+inline void putU64(char* out, std::uint64_t v) {
+    for (int i = 0; i < 8; ++i) out[i] = static_cast<char>((v >> (8 * i)) & 0xFF);
+}
+
+inline std::uint64_t getU64(const char* in) {
+    std::uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    return v;
+}
+
+bool decodeFields(EventKind kind, EventTime ts, Cursor& c, AnyEvent& out) {
+    switch (kind) {
+        case EventKind::WorkflowStarted: {
+            std::uint64_t n;
+            if (!c.varint(n)) return false;
+            out = WorkflowStarted{static_cast<std::size_t>(n), ts};
+            return true;
+        }
+        case EventKind::TaskQueued: {
+            TaskQueued e; e.ts = ts;
+            if (!c.str(e.id)) return false;
+            out = std::move(e);
+            return true;
+        }
+        case EventKind::TaskStarted: {
+            TaskStarted e; e.ts = ts;
+            if (!c.str(e.id) || !c.i32(e.worker)) return false;
+            out = std::move(e);
+            return true;
+        }
+        case EventKind::TaskFinished: {
+            TaskFinished e; e.ts = ts;
+            std::uint8_t ok;
+            if (!c.str(e.id) || !c.i32(e.worker) || !c.u8(ok) || !c.str(e.message)) return false;
+            e.success = ok != 0;
+            out = std::move(e);
+            return true;
+        }
+        case EventKind::WorkflowFinished: {
+            std::uint8_t ok;
+            if (!c.u8(ok)) return false;
+            out = WorkflowFinished{ts, ok != 0};
+            return true;
+        }
+        case EventKind::OutputChunk: {
+            OutputChunk e; e.ts = ts;
+            if (!c.str(e.id) || !c.str(e.data)) return false;
+            out = std::move(e);
+            return true;
+        }
+        case EventKind::MetricSample: {
+            MetricSample e; e.ts = ts;
+            if (!c.str(e.name) || !c.f64(e.value)) return false;
+            out = std::move(e);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+namespace evlog {
+void encodeFields(const WorkflowStarted& e, std::string& out) { appendVarint(out, e.taskCount); }
+void encodeFields(const TaskQueued& e, std::string& out) { appendString(out, e.id); }
+void encodeFields(const TaskStarted& e, std::string& out) {
+    appendString(out, e.id);
+    appendVarint(out, zigzag(e.worker));
+}
+void encodeFields(const TaskFinished& e, std::string& out) {
+    appendString(out, e.id);
+    appendVarint(out, zigzag(e.worker));
+    out.push_back(e.success ? 1 : 0);
+    appendString(out, e.message);
+}
+void encodeFields(const WorkflowFinished& e, std::string& out) { out.push_back(e.success ? 1 : 0); }
+void encodeFields(const OutputChunk& e, std::string& out) {
+    appendString(out, e.id);
+    appendString(out, e.data);
+}
+void encodeFields(const MetricSample& e, std::string& out) {
+    appendString(out, e.name);
+    char buf[8];
+    std::memcpy(buf, &e.value, 8);
+    out.append(buf, 8);
+}
+} // namespace evlog
+
+// =============== EventRecorder ===============
+EventRecorder::EventRecorder(std::string basePath)
+    : EventRecorder(std::move(basePath), Options{}) {}
+
+EventRecorder::EventRecorder(std::string basePath, Options opt)
+    : basePath_(std::move(basePath)), opt_(opt) {
+    if (opt_.segmentBytes < 4096) opt_.segmentBytes = 4096;
+}
+
+EventRecorder::~EventRecorder() { close(); }
+
+std::string EventRecorder::segmentPath(std::size_t n) const {
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), ".%03zu.evt", n);
+    return basePath_ + suffix;
+}
+
+bool EventRecorder::open() {
+    std::lock_guard<std::mutex> g(m_);
+    if (seg_.isOpen()) return true;
+    return openSegmentLocked(toNs(EventClock::now()));
+}
+
+bool EventRecorder::openSegmentLocked(std::int64_t baseNs) {
+    if (seg_.isOpen()) seg_.close(used_);
+    const std::string path = segmentPath(segments_.size());
+    if (!seg_.create(path, opt_.segmentBytes)) return false;
+    std::memcpy(seg_.data(), evlog::kMagic, sizeof(evlog::kMagic));
+    putU64(seg_.data() + 8, static_cast<std::uint64_t>(baseNs));
+    used_ = evlog::kHeaderSize;
+    lastNs_ = baseNs;
+    segments_.push_back(path);
+    return true;
+}
+
+void EventRecorder::append(EventKind kind, EventTime ts, const std::string& fields) {
+    const std::int64_t ns = toNs(ts);
+    std::lock_guard<std::mutex> g(m_);
+    if (!seg_.isOpen()) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    char head[1 + 10 + 10]; // kind + delta, then prefixed with the length
+    char lenBuf[10];
+    std::size_t need = 0;
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        std::size_t h = 0;
+        head[h++] = static_cast<char>(kind);
+        h += putVarint(head + h, zigzag(ns - lastNs_));
+        const std::size_t body = h + fields.size();
+        const std::size_t l = putVarint(lenBuf, body);
+        need = l + body;
+        if (used_ + need <= seg_.size()) {
+            char* out = seg_.data() + used_;
+            std::memcpy(out, lenBuf, l);
+            std::memcpy(out + l, head, h);
+            std::memcpy(out + l + h, fields.data(), fields.size());
+            used_ += need;
+            lastNs_ = ns;
+            records_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // Segment full: roll over once, then give up on oversized records.
+        if (attempt == 0 && need + evlog::kHeaderSize <= opt_.segmentBytes) {
+            if (!openSegmentLocked(ns)) break;
+        } else {
+            break;
+        }
+    }
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void EventRecorder::attach(EventBus& bus) {
+    detach();
+    bus_ = &bus;
+    subs_.push_back(bus.subscribe<WorkflowStarted>([this](const WorkflowStarted& e) { record(e); }));
+    subs_.push_back(bus.subscribe<TaskQueued>([this](const TaskQueued& e) { record(e); }));
+    subs_.push_back(bus.subscribe<TaskStarted>([this](const TaskStarted& e) { record(e); }));
+    subs_.push_back(bus.subscribe<TaskFinished>([this](const TaskFinished& e) { record(e); }));
+    subs_.push_back(bus.subscribe<WorkflowFinished>([this](const WorkflowFinished& e) { record(e); }));
+    subs_.push_back(bus.subscribe<OutputChunk>([this](const OutputChunk& e) { record(e); }));
+    subs_.push_back(bus.subscribe<MetricSample>([this](const MetricSample& e) { record(e); }));
+}
+
+void EventRecorder::detach() {
+    if (bus_) {
+        for (auto id : subs_) bus_->unsubscribe(id);
+    }
+    subs_.clear();
+    bus_ = nullptr;
+}
+
+bool EventRecorder::flush() {
+    std::lock_guard<std::mutex> g(m_);
+    return seg_.sync();
+}
+
+void EventRecorder::close() {
+    detach();
+    std::lock_guard<std::mutex> g(m_);
+    if (seg_.isOpen()) seg_.close(used_);
+}
+
+std::vector<std::string> EventRecorder::segments() const {
+    std::lock_guard<std::mutex> g(m_);
+    return segments_;
+}
+
+// =============== EventReader ===============
+bool EventReader::open(const std::vector<std::string>& segmentPaths) {
+    maps_.clear();
+    error_.clear();
+    for (const auto& path : segmentPaths) {
+        MappedFile mf;
+        if (!mf.openRead(path, MappedFile::Access::Sequential)) {
+            error_ = "cannot open segment: " + path;
+            return false;
+        }
+        if (mf.size() < evlog::kHeaderSize ||
+            std::memcmp(mf.data(), evlog::kMagic, sizeof(evlog::kMagic)) != 0) {
+            error_ = "not an event segment: " + path;
+            return false;
+        }
+        maps_.push_back(std::move(mf));
+    }
+    return true;
+}
+
+bool EventReader::forEach(const std::function<void(const AnyEvent&)>& fn) {
+    for (size_t s = 0; s < maps_.size(); ++s) {
+        const MappedFile& mf = maps_[s];
+        std::int64_t lastNs = static_cast<std::int64_t>(getU64(mf.data() + 8));
+        Cursor c{mf.data() + evlog::kHeaderSize, mf.data() + mf.size()};
+        while (c.p < c.end) {
+            std::uint64_t len;
+            if (!c.varint(len)) break;
+            if (len == 0) break; // zero-filled tail of an unfinished segment
+            if (len > static_cast<std::uint64_t>(c.end - c.p)) {
+                error_ = "truncated record in segment " + std::to_string(s);
+                return false;
+            }
+            Cursor rec{c.p, c.p + len};
+            c.p += len;
+
+            std::uint8_t kind;
+            std::uint64_t delta;
+            if (!rec.u8(kind) || !rec.varint(delta)) {
+                error_ = "corrupt record header in segment " + std::to_string(s);
+                return false;
+            }
+            lastNs += unzigzag(delta);
+            AnyEvent ev;
+            if (!decodeFields(static_cast<EventKind>(kind), fromNs(lastNs), rec, ev)) {
+                error_ = "corrupt record body in segment " + std::to_string(s);
+                return false;
+            }
+            fn(ev);
+        }
+    }
+    return true;
+}
+
+std::size_t EventReader::replay(EventBus& bus) {
+    std::size_t n = 0;
+    forEach([&](const AnyEvent& ev) {
+        std::visit([&](const auto& e) { bus.publish(e); }, ev);
+        ++n;
+    });
+    return n;
+}
+
+// =============== Converters ===============
+namespace {
+
+nlohmann::json toJson(const AnyEvent& ev) {
+    nlohmann::json j;
+    std::visit([&](const auto& e) {
+        j["kind"] = eventKindName(e.kind);
+        j["ts_ns"] = toNs(e.ts);
+    }, ev);
+    if (auto* e = std::get_if<WorkflowStarted>(&ev)) {
+        j["task_count"] = e->taskCount;
+    } else if (auto* e = std::get_if<TaskQueued>(&ev)) {
+        j["id"] = e->id;
+    } else if (auto* e = std::get_if<TaskStarted>(&ev)) {
+        j["id"] = e->id; j["worker"] = e->worker;
+    } else if (auto* e = std::get_if<TaskFinished>(&ev)) {
+        j["id"] = e->id; j["worker"] = e->worker;
+        j["success"] = e->success; j["message"] = e->message;
+    } else if (auto* e = std::get_if<WorkflowFinished>(&ev)) {
+        j["success"] = e->success;
+    } else if (auto* e = std::get_if<OutputChunk>(&ev)) {
+        j["id"] = e->id; j["data"] = e->data;
+    } else if (auto* e = std::get_if<MetricSample>(&ev)) {
+        j["name"] = e->name; j["value"] = e->value;
+    }
+    return j;
+}
+
+} // namespace
+
+bool writeJsonLines(EventReader& reader, std::ostream& os) {
+    const auto handler = nlohmann::json::error_handler_t::replace;
+    bool ok = reader.forEach([&](const AnyEvent& ev) {
+        os << toJson(ev).dump(-1, ' ', false, handler) << '\n';
+    });
+    return ok && static_cast<bool>(os);
+}
+
+bool writeChromeTrace(EventReader& reader, std::ostream& os) {
+    const auto handler = nlohmann::json::error_handler_t::replace;
+    bool first = true;
+    std::int64_t originNs = 0;
+    bool haveOrigin = false;
+
+    os << "{\"traceEvents\":[\n";
+    auto emit = [&](nlohmann::json e) {
+        e["pid"] = 1;
+        if (!first) os << ",\n";
+        os << e.dump(-1, ' ', false, handler);
+        first = false;
+    };
+
+    bool ok = reader.forEach([&](const AnyEvent& ev) {
+        std::int64_t ns = 0;
+        std::visit([&](const auto& e) { ns = toNs(e.ts); }, ev);
+        if (!haveOrigin) { originNs = ns; haveOrigin = true; }
+        const double us = static_cast<double>(ns - originNs) / 1000.0;
+
+        nlohmann::json e;
+        e["ts"] = us;
+        if (auto* s = std::get_if<TaskStarted>(&ev)) {
+            e["ph"] = "B"; e["name"] = s->id; e["tid"] = s->worker;
+        } else if (auto* f = std::get_if<TaskFinished>(&ev)) {
+            e["ph"] = "E"; e["name"] = f->id; e["tid"] = f->worker;
+            e["args"] = {{"success", f->success}, {"message", f->message}};
+        } else if (auto* m = std::get_if<MetricSample>(&ev)) {
+            e["ph"] = "C"; e["name"] = m->name; e["tid"] = 0;
+            e["args"] = {{"value", m->value}};
+        } else {
+            auto j = toJson(ev);
+            e["ph"] = "i"; e["s"] = "g"; e["tid"] = 0;
+            e["name"] = j["kind"];
+            j.erase("kind"); j.erase("ts_ns");
+            e["args"] = std::move(j);
+        }
+        emit(std::move(e));
+    });
+    os << "\n]}\n";
+    return ok && static_cast<bool>(os);
+}
+
+} // namespace rt
@@ -0,0 +1,133 @@
+#include "runtime/PoolMetrics.hpp"
+
+#include <limits>
+#include <sstream>
+
+#include "nlohmann/json.hpp"
+
+namespace rt {
+
+namespace {
+
+constexpr double kQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+nlohmann::json workerJson(const WorkerMetrics& w) {
+    return {
+        {"tasks", w.tasks},
+        {"steal_attempts", w.stealAttempts},
+        {"steals", w.steals},
+        {"parks", w.parks},
+        {"unparks", w.unparks},
+        {"busy_ns", w.busyNs},
+    };
+}
+
+nlohmann::json histogramJson(const HistogramSnapshot& h) {
+    nlohmann::json buckets = nlohmann::json::array();
+    for (size_t b = 0; b < HistogramSnapshot::kBuckets; ++b) {
+        if (h.buckets[b] == 0) continue;
+        buckets.push_back({HistogramLayout::lowerBound(b), HistogramLayout::upperBound(b), h.buckets[b]});
+    }
+    return {
+        {"count", h.count},
+        {"sum", h.sum},
+        {"max", h.max},
+        {"mean", h.mean()},
+        {"p50", h.percentile(0.5)},
+        {"p90", h.percentile(0.9)},
+        {"p99", h.percentile(0.99)},
+        {"p999", h.percentile(0.999)},
+        {"buckets", std::move(buckets)}, // [lower, upper, count], non-empty only
+    };
+}
+
+// `{a="1",b="2"}` from the caller's labels plus an optional extra one.
+std::string labelSet(const std::string& labels, const std::string& extra = {}) {
+    if (labels.empty() && extra.empty()) return {};
+    std::string out = "{" + labels;
+    if (!labels.empty() && !extra.empty()) out += ",";
+    return out + extra + "}";
+}
+
+double seconds(uint64_t ns) { return static_cast<double>(ns) / 1e9; }
+
+} // namespace
+
+WorkerMetrics PoolMetrics::total() const {
+    WorkerMetrics t = external;
+    for (const auto& w : workers) t.merge(w);
+    return t;
+}
+
+double PoolMetrics::utilization() const {
+    if (workers.empty() || uptimeNs == 0) return 0.0;
+    uint64_t busy = 0;
+    for (const auto& w : workers) busy += w.busyNs;
+    const double u = static_cast<double>(busy) / (static_cast<double>(uptimeNs) * static_cast<double>(workers.size()));
+    return u < 1.0 ? u : 1.0;
+}
+
+std::string PoolMetrics::toJson() const {
+    nlohmann::json j;
+    j["uptime_ns"] = uptimeNs;
+    j["queued"] = queued;
+    j["utilization"] = utilization();
+    j["total"] = workerJson(total());
+    j["external"] = workerJson(external);
+    j["workers"] = nlohmann::json::array();
+    for (const auto& w : workers) j["workers"].push_back(workerJson(w));
+    j["queue_wait_ns"] = histogramJson(queueWait);
+    j["run_time_ns"] = histogramJson(runTime);
+    return j.dump();
+}
+
+std::string PoolMetrics::toPrometheus(const std::string& prefix, const std::string& labels) const {
+    std::ostringstream os;
+    // Round-trip precision: with the default 6 digits long uptimes and busy
+    // totals stop changing between scrapes, and rate() over them goes flat.
+    os.precision(std::numeric_limits<double>::max_digits10);
+    auto header = [&](const char* name, const char* type, const char* help) {
+        os << "# HELP " << prefix << '_' << name << ' ' << help << '\n';
+        os << "# TYPE " << prefix << '_' << name << ' ' << type << '\n';
+    };
+    auto perWorker = [&](const char* name, const char* help, auto field) {
+        header(name, "counter", help);
+        for (size_t i = 0; i < workers.size(); ++i) {
+            os << prefix << '_' << name << labelSet(labels, "worker=\"" + std::to_string(i) + "\"") << ' '
+               << field(workers[i]) << '\n';
+        }
+        os << prefix << '_' << name << labelSet(labels, "worker=\"external\"") << ' ' << field(external) << '\n';
+    };
+    auto summary = [&](const char* name, const char* help, const HistogramSnapshot& h) {
+        header(name, "summary", help);
+        for (double q : kQuantiles) {
+            std::ostringstream ql;
+            ql << "quantile=\"" << q << '"';
+            os << prefix << '_' << name << labelSet(labels, ql.str()) << ' ' << seconds(h.percentile(q)) << '\n';
+        }
+        os << prefix << '_' << name << "_sum" << labelSet(labels) << ' ' << seconds(h.sum) << '\n';
+        os << prefix << '_' << name << "_count" << labelSet(labels) << ' ' << h.count << '\n';
+    };
+
+    perWorker("tasks_total", "Tasks run.", [](const WorkerMetrics& w) { return w.tasks; });
+    perWorker("steal_attempts_total", "Scans of other workers' queues.", [](const WorkerMetrics& w) { return w.stealAttempts; });
+    perWorker("steals_total", "Scans that found a task.", [](const WorkerMetrics& w) { return w.steals; });
+    perWorker("parks_total", "Times a worker went to sleep.", [](const WorkerMetrics& w) { return w.parks; });
+    perWorker("unparks_total", "Times a worker was woken.", [](const WorkerMetrics& w) { return w.unparks; });
+    perWorker("busy_seconds_total", "Time spent running tasks.", [](const WorkerMetrics& w) { return seconds(w.busyNs); });
+
+    header("workers", "gauge", "Worker threads.");
+    os << prefix << "_workers" << labelSet(labels) << ' ' << workers.size() << '\n';
+    header("queued", "gauge", "Tasks waiting to run (approximate).");
+    os << prefix << "_queued" << labelSet(labels) << ' ' << queued << '\n';
+    header("utilization", "gauge", "Share of worker time spent running tasks.");
+    os << prefix << "_utilization" << labelSet(labels) << ' ' << utilization() << '\n';
+    header("uptime_seconds", "gauge", "Time since the workers started.");
+    os << prefix << "_uptime_seconds" << labelSet(labels) << ' ' << seconds(uptimeNs) << '\n';
+
+    summary("queue_wait_seconds", "Time from submit to start.", queueWait);
+    summary("run_time_seconds", "Task run time.", runTime);
+    return os.str();
+}
+
+} // namespace rt
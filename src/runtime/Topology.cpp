@@ -0,0 +1,212 @@
+#include "runtime/Topology.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#if defined(_WIN32)
+  #include <windows.h>
+#elif defined(__linux__)
+  #include <dirent.h>
+  #include <pthread.h>
+  #include <sched.h>
+#endif
+
+#if defined(SPF_HAVE_LIBNUMA)
+  #include <numa.h>
+#endif
+
+namespace rt {
+
+namespace {
+
+#if defined(__linux__)
+bool readFirstLine(const std::string& path, std::string& out) {
+    std::ifstream ifs(path);
+    return static_cast<bool>(std::getline(ifs, out));
+}
+
+// Nodes from /sys/devices/system/node/node<N>/{cpulist,distance}.
+bool loadSysfs(CpuTopology& topo) {
+    const std::string root = "/sys/devices/system/node";
+    DIR* dir = ::opendir(root.c_str());
+    if (!dir) return false;
+    std::vector<int> ids;
+    while (dirent* ent = ::readdir(dir)) {
+        const std::string name = ent->d_name;
+        if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+            std::all_of(name.begin() + 4, name.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); })) {
+            ids.push_back(std::stoi(name.substr(4)));
+        }
+    }
+    ::closedir(dir);
+    std::sort(ids.begin(), ids.end());
+
+    for (int id : ids) {
+        const std::string base = root + "/node" + std::to_string(id);
+        std::string line;
+        if (!readFirstLine(base + "/cpulist", line)) continue;
+        CpuTopology::Node node;
+        node.id = id;
+        node.cpus = parseCpuList(line);
+        if (node.cpus.empty()) continue; // memory-only node
+        if (readFirstLine(base + "/distance", line)) {
+            std::istringstream iss(line);
+            int d;
+            std::vector<int> all;
+            while (iss >> d) all.push_back(d);
+            // sysfs lists distances to every node id; keep those we kept
+            for (int other : ids) {
+                node.distance.push_back(static_cast<size_t>(other) < all.size() ? all[other] : 0);
+            }
+        }
+        topo.nodes.push_back(std::move(node));
+    }
+    if (topo.nodes.empty()) return false;
+
+    // Re-index distances by position in `nodes` (memory-only nodes dropped).
+    for (auto& node : topo.nodes) {
+        std::vector<int> byIndex;
+        for (const auto& other : topo.nodes) {
+            auto pos = std::find(ids.begin(), ids.end(), other.id) - ids.begin();
+            byIndex.push_back(static_cast<size_t>(pos) < node.distance.size() ? node.distance[pos] : 0);
+        }
+        node.distance = std::move(byIndex);
+    }
+    return true;
+}
+#endif
+
+CpuTopology detect() {
+    CpuTopology topo;
+#if defined(__linux__)
+    if (loadSysfs(topo)) return topo;
+#endif
+    CpuTopology::Node node;
+    const unsigned n = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < n; ++i) node.cpus.push_back(static_cast<int>(i));
+    node.distance.push_back(10);
+    topo.nodes.push_back(std::move(node));
+    return topo;
+}
+
+} // namespace
+
+size_t CpuTopology::cpuCount() const {
+    size_t n = 0;
+    for (const auto& node : nodes) n += node.cpus.size();
+    return n;
+}
+
+int CpuTopology::nodeOf(int cpu) const {
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const auto& cpus = nodes[i].cpus;
+        if (std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+std::vector<int> CpuTopology::nodesByDistance(int node) const {
+    std::vector<int> order(nodes.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int>(i);
+    if (node < 0 || static_cast<size_t>(node) >= nodes.size()) return order;
+    const auto& dist = nodes[static_cast<size_t>(node)].distance;
+    auto d = [&](int i) {
+        if (i == node) return -1; // self first even with odd distance tables
+        return static_cast<size_t>(i) < dist.size() ? dist[static_cast<size_t>(i)] : 0;
+    };
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return d(a) < d(b); });
+    return order;
+}
+
+const CpuTopology& CpuTopology::system() {
+    static const CpuTopology topo = detect();
+    return topo;
+}
+
+std::vector<int> parseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    std::istringstream iss(text);
+    std::string part;
+    while (std::getline(iss, part, ',')) {
+        part.erase(std::remove_if(part.begin(), part.end(), [](char c) { return std::isspace(static_cast<unsigned char>(c)); }),
+                   part.end());
+        if (part.empty()) continue;
+        try {
+            const auto dash = part.find('-');
+            if (dash == std::string::npos) {
+                cpus.push_back(std::stoi(part));
+            } else {
+                const int lo = std::stoi(part.substr(0, dash));
+                const int hi = std::stoi(part.substr(dash + 1));
+                for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+            }
+        } catch (...) {
+            return {}; // malformed list: treat as unknown
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+bool pinCurrentThread(const std::vector<int>& cpus) {
+    if (cpus.empty()) return false;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus) {
+        if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &set);
+    }
+    return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for (int c : cpus) {
+        if (c >= 0 && c < static_cast<int>(sizeof(DWORD_PTR) * 8)) mask |= DWORD_PTR(1) << c;
+    }
+    return mask != 0 && ::SetThreadAffinityMask(::GetCurrentThread(), mask) != 0;
+#else
+    return false; // macOS has no hard affinity
+#endif
+}
+
+int currentCpu() {
+#if defined(__linux__)
+    return ::sched_getcpu();
+#elif defined(_WIN32)
+    return static_cast<int>(::GetCurrentProcessorNumber());
+#else
+    return -1;
+#endif
+}
+
+void* allocateOnNode(size_t bytes, int node) {
+#if defined(SPF_HAVE_LIBNUMA)
+    if (node >= 0 && ::numa_available() >= 0) {
+        const auto& topo = CpuTopology::system();
+        const int osNode = static_cast<size_t>(node) < topo.nodes.size() ? topo.nodes[node].id : node;
+        if (void* p = ::numa_alloc_onnode(bytes, osNode)) return p;
+        throw std::bad_alloc();
+    }
+#else
+    (void)node;
+#endif
+    return ::operator new(bytes);
+}
+
+void freeOnNode(void* p, size_t bytes, int node) {
+    if (!p) return;
+#if defined(SPF_HAVE_LIBNUMA)
+    if (node >= 0 && ::numa_available() >= 0) { ::numa_free(p, bytes); return; }
+#else
+    (void)bytes;
+    (void)node;
+#endif
+    ::operator delete(p);
+}
+
+} // namespace rt
@@ -1,16 +1,34 @@
 #include <gtest/gtest.h>
 #include "threadpool/ThreadPool.hpp"
+#include "threadpool/threadpool.h"
 #include "config/ConfigParser.hpp"
 #include "ui/console_ui.hpp"
+#include "ui/dashboard.hpp"
 #include "core/PluginManager.hpp"
 #include "core/IJsonProcess.hpp"
 #include "core/IComparator.hpp"
+#include "core/JsonArena.hpp"
+#include "core/JsonCodec.hpp"
+#include "runtime/EventBus.hpp"
+#include "runtime/EventRecorder.hpp"
+#include "runtime/ThreadPool.hpp"
+#include "runtime/Parallel.hpp"
+#include "runtime/TaskGroup.hpp"
+#include "runtime/Future.hpp"
+#include "runtime/MpmcQueue.hpp"
+#include "runtime/PoolMetrics.hpp"
+#include "runtime/Topology.hpp"
+#include "gen/Generator.hpp"
+#include "workflow/WorkflowParser.hpp"
+#include "workflow/Executor.hpp"
+#include "runtime/Services.hpp"
 #include <nlohmann/json.hpp>
 
 #include <atomic>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <numeric>
 #include <sstream>
 #include <unordered_set>
 
@@ -18,6 +36,17 @@ using namespace std::chrono_literals;
 
 namespace {
 
+// Plugin shared library as produced by the build (plugins/<name>.dll or plugins/lib<name>.so).
+std::string pluginPath(const std::string& name) {
+#if defined(_WIN32)
+    return "plugins/" + name + ".dll";
+#elif defined(__APPLE__)
+    return "plugins/lib" + name + ".dylib";
+#else
+    return "plugins/lib" + name + ".so";
+#endif
+}
+
 bool ensurePluginLoaded(const std::string& relPath) {
     static std::unordered_set<std::string> loaded;
     if (loaded.count(relPath)) return true;
@@ -63,6 +92,185 @@ TEST(ConsoleUITests, TaskListAndProgress) {
     SUCCEED();
 }
 
+TEST(ConsoleUITests, DashboardTracksExecutorEvents) {
+    rt::EventBus bus;
+    std::ostringstream sink;
+    ui::Dashboard::Options opt;
+    opt.maxFps = 50;
+    ui::Dashboard dash(bus, opt, sink);
+    dash.start();
+
+    auto t0 = rt::EventClock::now();
+    bus.emit<rt::WorkflowStarted>(size_t(4), t0);
+    for (const char* id : {"a", "b", "c"}) bus.emit<rt::TaskQueued>(id, t0);
+    bus.emit<rt::TaskStarted>("a", t0, 0);
+    bus.emit<rt::TaskStarted>("b", t0, 1);
+    bus.emit<rt::TaskFinished>("a", t0 + 1s, 0, true, "");
+
+    const std::string frame = dash.renderFrame();
+    EXPECT_EQ(frame.rfind("[##########", 0), 0u);
+    EXPECT_NE(frame.find("1/4 done"), std::string::npos);
+    EXPECT_NE(frame.find("running 1 | queued 1"), std::string::npos);
+    EXPECT_NE(frame.find("[>] b (worker 1"), std::string::npos);
+
+    dash.stop();
+    EXPECT_FALSE(sink.str().empty());
+
+    // Events recorded while nobody renders are folded in by the next frame;
+    // a new run starts from a clean view.
+    bus.emit<rt::TaskStarted>("c", t0, 2);
+    bus.emit<rt::WorkflowStarted>(size_t(2), t0 + 2s);
+    bus.emit<rt::TaskQueued>("x", t0 + 2s);
+    const std::string next = dash.renderFrame();
+    EXPECT_NE(next.find("0/2 done"), std::string::npos);
+    EXPECT_NE(next.find("running 0 | queued 1"), std::string::npos);
+}
+
+TEST(EventBusTests, TypedSubscriptionsOnlySeeTheirTopic) {
+    rt::EventBus bus;
+    int started = 0, finished = 0;
+    bus.subscribe<rt::TaskStarted>([&](const rt::TaskStarted& e) {
+        EXPECT_EQ(e.id, "t1");
+        EXPECT_EQ(e.worker, 3);
+        ++started;
+    });
+    auto sub = bus.subscribe<rt::TaskFinished>([&](const rt::TaskFinished& e) {
+        EXPECT_FALSE(e.success);
+        ++finished;
+    });
+
+    bus.publish(rt::TaskStarted{"t1", rt::EventClock::now(), 3});
+    bus.emit<rt::TaskFinished>("t1", rt::EventClock::now(), 3, false, "boom");
+    bus.emit<rt::OutputChunk>("t1", rt::EventClock::now(), "ignored");
+    EXPECT_EQ(started, 1);
+    EXPECT_EQ(finished, 1);
+
+    EXPECT_TRUE(bus.unsubscribe(sub));
+    EXPECT_FALSE(bus.hasSubscribers<rt::TaskFinished>());
+    bus.emit<rt::TaskFinished>("t1", rt::EventClock::now(), 3, true, "");
+    EXPECT_EQ(finished, 1);
+    EXPECT_FALSE(bus.unsubscribe(sub));
+}
+
+TEST(EventBusTests, UnsubscribeWaitsForRunningHandlers) {
+    rt::EventBus bus;
+    std::atomic<int> inside(0), calls(0);
+    auto sub = bus.subscribe<rt::MetricSample>([&](const rt::MetricSample&) {
+        inside.fetch_add(1);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        calls.fetch_add(1);
+        inside.fetch_sub(1);
+    });
+    std::atomic<bool> done(false);
+    std::thread publisher([&] {
+        while (!done.load()) bus.emit<rt::MetricSample>("cpu", rt::EventClock::now(), 1.0);
+    });
+    while (calls.load() == 0) std::this_thread::yield();
+    ASSERT_TRUE(bus.unsubscribe(sub));
+    EXPECT_EQ(inside.load(), 0);
+    const int after = calls.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    EXPECT_EQ(calls.load(), after);
+    done = true;
+    publisher.join();
+
+    // A handler may remove itself without waiting on its own call.
+    rt::EventBus::SubscriptionId self = 0;
+    int seen = 0;
+    self = bus.subscribe<rt::TaskQueued>([&](const rt::TaskQueued&) {
+        ++seen;
+        EXPECT_TRUE(bus.unsubscribe(self));
+    });
+    bus.emit<rt::TaskQueued>("a", rt::EventClock::now());
+    bus.emit<rt::TaskQueued>("b", rt::EventClock::now());
+    EXPECT_EQ(seen, 1);
+}
+
+TEST(EventBusTests, ExecutorPublishesOutputAndTimings) {
+    struct EchoTask : wf::ITask {
+        std::string name, text;
+        bool ok;
+        EchoTask(std::string n, std::string t, bool o) : name(std::move(n)), text(std::move(t)), ok(o) {}
+        std::string id() const override { return name; }
+        wf::TaskResult run(wf::ITaskContext&) override { return {ok, text}; }
+    };
+    wf::WorkflowSpec spec;
+    spec.tasks.push_back(std::make_shared<EchoTask>("a", "hello", true));
+    spec.tasks.push_back(std::make_shared<EchoTask>("b", "broken", false));
+    spec.edges.push_back({"a", "b"});
+
+    rt::EventBus bus;
+    std::vector<std::string> output;
+    int samples = 0;
+    bus.subscribe<rt::OutputChunk>([&](const rt::OutputChunk& e) { output.push_back(e.id + ":" + e.data); });
+    bus.subscribe<rt::MetricSample>([&](const rt::MetricSample& e) {
+        EXPECT_EQ(e.name, "task_ms");
+        EXPECT_GE(e.value, 0.0);
+        ++samples;
+    });
+    rt::StdLogger logger;
+    rt::SteadyClock clock;
+    rt::LocalFS fs;
+    wf::SimpleContext ctx(logger, clock, fs);
+    rt::ThreadPool pool(2);
+    EXPECT_FALSE(wf::Executor(bus, pool).run(spec, ctx));
+    EXPECT_EQ(output, std::vector<std::string>{"a:hello"});
+    EXPECT_EQ(samples, 2);
+}
+
+TEST(EventRecorderTests, RoundTripAndReplay) {
+    auto base = uniqueTempFile("events", "").string();
+    rt::EventBus bus;
+    rt::EventRecorder::Options opt;
+    opt.segmentBytes = 4096; // force a rollover
+    std::vector<std::string> segments;
+    {
+        rt::EventRecorder rec(base, opt);
+        ASSERT_TRUE(rec.open());
+        rec.attach(bus);
+        auto t0 = rt::EventClock::now();
+        bus.emit<rt::WorkflowStarted>(size_t(200), t0);
+        for (int i = 0; i < 200; ++i) {
+            auto id = "task" + std::to_string(i);
+            bus.emit<rt::TaskStarted>(id, t0 + std::chrono::microseconds(i), i % 4);
+            bus.emit<rt::TaskFinished>(id, t0 + std::chrono::microseconds(i + 1), i % 4, i != 7, "");
+        }
+        bus.emit<rt::MetricSample>("cpu", t0, 42.5);
+        rec.close();
+        EXPECT_EQ(rec.recordCount(), 402u);
+        EXPECT_EQ(rec.droppedCount(), 0u);
+        segments = rec.segments();
+    }
+    ASSERT_GT(segments.size(), 1u);
+
+    rt::EventReader reader;
+    ASSERT_TRUE(reader.open(segments)) << reader.error();
+    rt::EventBus replayBus;
+    int started = 0, failed = 0;
+    double metric = 0;
+    replayBus.subscribe<rt::TaskStarted>([&](const rt::TaskStarted& e) {
+        EXPECT_EQ(e.worker, started % 4);
+        ++started;
+    });
+    replayBus.subscribe<rt::TaskFinished>([&](const rt::TaskFinished& e) {
+        if (!e.success) { EXPECT_EQ(e.id, "task7"); ++failed; }
+    });
+    replayBus.subscribe<rt::MetricSample>([&](const rt::MetricSample& e) { metric = e.value; });
+    EXPECT_EQ(reader.replay(replayBus), 402u);
+    EXPECT_TRUE(reader.error().empty()) << reader.error();
+    EXPECT_EQ(started, 200);
+    EXPECT_EQ(failed, 1);
+    EXPECT_DOUBLE_EQ(metric, 42.5);
+
+    std::ostringstream trace;
+    ASSERT_TRUE(rt::writeChromeTrace(reader, trace));
+    auto parsed = nlohmann::json::parse(trace.str());
+    EXPECT_EQ(parsed["traceEvents"].size(), 402u);
+
+    std::error_code ec;
+    for (auto& s : segments) std::filesystem::remove(s, ec);
+}
+
 TEST(ThreadPoolTests, HighConcurrencySubmission) {
     tp::ThreadPool pool(4);
     const int N = 1000;
@@ -77,8 +285,592 @@ TEST(ThreadPoolTests, HighConcurrencySubmission) {
     EXPECT_EQ(counter.load(), N);
 }
 
+TEST(ThreadPoolTests, NestedSubmissionsAreStolenAndDrained) {
+    std::atomic<int> counter(0);
+    {
+        tp::ThreadPool pool(4);
+        std::function<void(int)> spawn = [&](int depth) {
+            counter.fetch_add(1);
+            EXPECT_GE(pool.currentWorker(), 0);
+            if (depth == 0) return;
+            pool.submit(spawn, depth - 1);
+            pool.submit(spawn, depth - 1);
+        };
+        EXPECT_EQ(pool.currentWorker(), -1);
+        pool.submit(spawn, 10).get();
+
+        // A child left on a worker that waits without helping can only be
+        // taken by another worker stealing it.
+        const uint64_t stealsBefore = pool.metrics().total().steals;
+        std::atomic<bool> childRan(false);
+        pool.submit([&] {
+            pool.post([&] { childRan = true; });
+            while (!childRan) std::this_thread::yield();
+        }).get();
+        EXPECT_GT(pool.metrics().total().steals, stealsBefore);
+
+        pool.shutdown(); // runs everything still queued; `spawn` must outlive it
+    }
+    EXPECT_EQ(counter.load(), (1 << 11) - 1);
+}
+
+TEST(ThreadPoolTests, SubmitRacingShutdownRunsOrThrows) {
+    for (int round = 0; round < 20; ++round) {
+        tp::ThreadPool pool(2);
+        std::vector<std::future<int>> accepted; // producer's until joined
+        std::atomic<size_t> submitted(0);
+        std::atomic<bool> refused(false);
+        std::thread producer([&] {
+            for (int i = 0; !refused; ++i) {
+                try {
+                    accepted.push_back(pool.submit([i] { return i; }));
+                    submitted.fetch_add(1);
+                } catch (const std::runtime_error&) {
+                    refused = true;
+                }
+            }
+        });
+        while (submitted.load() < 10) std::this_thread::yield();
+        pool.shutdown();
+        producer.join();
+        EXPECT_FALSE(pool.try_submit([] { return 0; }));
+        // every accepted task ran; none was dropped with a broken promise
+        for (size_t i = 0; i < accepted.size(); ++i) EXPECT_EQ(accepted[i].get(), static_cast<int>(i));
+    }
+}
+
+TEST(ThreadPoolTests, RuntimePoolPostAndSubmitWithoutStdFunction) {
+    // small captures live inline; move-only captures are accepted
+    auto owned = std::make_unique<int>(7);
+    rt::Task task([p = std::move(owned)]{ EXPECT_EQ(*p, 7); });
+    auto small = [&owned, i = 0]{ (void)owned; (void)i; };
+    static_assert(rt::Task::fitsInline<decltype(small)>(), "small captures must be stored inline");
+    ASSERT_TRUE(static_cast<bool>(task));
+    task();
+
+    std::atomic<int> counter(0);
+    {
+        rt::ThreadPool pool(4);
+        for (int i = 0; i < 1000; ++i) pool.post([&counter]{ counter.fetch_add(1); });
+        auto sum = pool.submit([](int a, std::unique_ptr<int> b) { return a + *b; },
+                               40, std::make_unique<int>(2));
+        EXPECT_EQ(sum.get(), 42);
+        auto failed = pool.submit([]() -> int { throw std::runtime_error("boom"); });
+        EXPECT_THROW(failed.get(), std::runtime_error);
+        pool.submit([]{}).get();
+    }
+    EXPECT_EQ(counter.load(), 1000);
+}
+
+TEST(ThreadPoolTests, WorkersOfAnotherPoolCannotSubmitToAStoppedPool) {
+    rt::ThreadPool a(2);
+    rt::ThreadPool b(2);
+    b.shutdown();
+    auto rejected = a.submit([&b] {
+        try {
+            b.post([]{});
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    });
+    EXPECT_TRUE(rejected.get());
+}
+
+TEST(ThreadPoolTests, RuntimePoolSubmitRacingShutdownRunsOrThrows) {
+    for (int round = 0; round < 20; ++round) {
+        rt::ThreadPool pool(2);
+        std::vector<std::future<int>> accepted; // producer's until joined
+        std::atomic<size_t> submitted(0);
+        std::atomic<bool> refused(false);
+        std::thread producer([&] {
+            for (int i = 0; !refused; ++i) {
+                try {
+                    accepted.push_back(pool.submit([i] { return i; }));
+                    submitted.fetch_add(1);
+                } catch (const std::runtime_error&) {
+                    refused = true;
+                }
+            }
+        });
+        while (submitted.load() < 10) std::this_thread::yield();
+        pool.shutdown();
+        producer.join();
+        EXPECT_THROW(pool.post([]{}), std::runtime_error);
+        // every accepted task ran before the workers exited
+        for (size_t i = 0; i < accepted.size(); ++i) {
+            ASSERT_EQ(accepted[i].wait_for(0s), std::future_status::ready);
+            EXPECT_EQ(accepted[i].get(), static_cast<int>(i));
+        }
+    }
+}
+
+TEST(ThreadPoolTests, ParallelForReduceAndSort) {
+    rt::ThreadPool pool(4);
+    const size_t n = 100000;
+
+    std::vector<int> hits(n, 0);
+    EXPECT_TRUE(rt::parallel_for(pool, 0, n, [&](size_t i) { hits[i]++; }));
+    EXPECT_EQ(std::count(hits.begin(), hits.end(), 1), static_cast<long>(n));
+
+    const auto sum = rt::parallel_reduce(pool, 0, n, uint64_t(0),
+                                         [](size_t i) { return uint64_t(i); },
+                                         [](uint64_t a, uint64_t b) { return a + b; }, 1000);
+    EXPECT_EQ(sum, uint64_t(n) * (n - 1) / 2);
+
+    std::vector<uint32_t> data(n);
+    uint32_t x = 12345;
+    for (auto& v : data) { x ^= x << 13; x ^= x >> 17; x ^= x << 5; v = x; }
+    auto expected = data;
+    std::sort(expected.begin(), expected.end());
+    rt::parallel_sort(pool, data.begin(), data.end());
+    EXPECT_EQ(data, expected);
+
+    // cancellation skips pending chunks; exceptions surface on the caller
+    rt::CancellationToken token;
+    std::atomic<size_t> ran(0);
+    EXPECT_FALSE(rt::parallel_for(pool, 0, n, [&](size_t) {
+        if (ran.fetch_add(1) == 0) token.cancel();
+    }, 100, token));
+    EXPECT_LT(ran.load(), n);
+    EXPECT_THROW(rt::parallel_for(pool, 0, n, [](size_t i) {
+        if (i == n / 2) throw std::runtime_error("bad element");
+    }), std::runtime_error);
+}
+
+namespace {
+
+template<class Pool>
+long groupFib(Pool& pool, int n) {
+    if (n < 12) return n < 2 ? n : groupFib(pool, n - 1) + groupFib(pool, n - 2);
+    long a = 0, b = 0;
+    rt::TaskGroup<Pool> g(pool);
+    g.run([&]{ a = groupFib(pool, n - 1); });
+    g.run([&]{ b = groupFib(pool, n - 2); });
+    g.wait();
+    return a + b;
+}
+
+} // namespace
+
+TEST(ThreadPoolTests, TaskGroupsNestWaitAndCancel) {
+    // nested waits on a two-worker pool: waiters must help, not block
+    tp::ThreadPool tpPool(2);
+    EXPECT_EQ(groupFib(tpPool, 22), 17711);
+    rt::ThreadPool rtPool(2);
+    EXPECT_EQ(groupFib(rtPool, 22), 17711);
+
+    // first exception cancels the rest and is rethrown by wait()
+    std::atomic<int> ran(0);
+    rt::TaskGroup<rt::ThreadPool> g(rtPool);
+    g.run([]{ throw std::runtime_error("first"); });
+    EXPECT_THROW(g.wait(), std::runtime_error);
+    EXPECT_TRUE(g.cancelled());
+    g.run([&]{ ran.fetch_add(1); });
+    EXPECT_NO_THROW(g.wait());
+
+    rt::TaskGroup<tp::ThreadPool> h(tpPool);
+    for (int i = 0; i < 100; ++i) {
+        h.run([&]{ if (ran.fetch_add(1) == 9) h.cancel(); });
+    }
+    h.wait();
+    EXPECT_TRUE(h.cancelled());
+    EXPECT_GE(ran.load(), 10);
+
+    // an off-pool waiter parks until the last task retires, and the group
+    // can be destroyed right after wait() returns
+    for (int i = 0; i < 200; ++i) {
+        rt::TaskGroup<rt::ThreadPool> once(rtPool);
+        once.run([i]{ if (i % 50 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(5)); });
+        once.wait();
+    }
+}
+
+TEST(ThreadPoolTests, FutureContinuationsAndCombinators) {
+    rt::ThreadPool pool(2);
+
+    auto chained = rt::async(pool, [](int x) { return x * 2; }, 21)
+                       .then([](int x) { return std::to_string(x); })
+                       .then([](std::string s) { return s + "!"; });
+    EXPECT_EQ(chained.get(), "42!");
+
+    // exceptions skip continuations and surface at the end of the chain
+    std::atomic<bool> skipped(true);
+    auto failed = rt::async(pool, []() -> int { throw std::runtime_error("stage 1"); })
+                      .then([&](int) { skipped = false; return 0; });
+    EXPECT_THROW(failed.get(), std::runtime_error);
+    EXPECT_TRUE(skipped.load());
+
+    std::vector<rt::Future<int>> parts;
+    for (int i = 0; i < 8; ++i) parts.push_back(rt::async(pool, [i]{ return i * i; }));
+    auto total = rt::when_all(std::move(parts)).then([](std::vector<int> v) {
+        return std::accumulate(v.begin(), v.end(), 0);
+    });
+    EXPECT_EQ(total.get(), 140);
+
+    rt::Promise<int> slow(pool);
+    std::vector<rt::Future<int>> racers;
+    racers.push_back(slow.get_future());
+    racers.push_back(rt::async(pool, []{ return 7; }));
+    auto first = rt::when_any(std::move(racers)).get();
+    EXPECT_EQ(first.index, 1u);
+    EXPECT_EQ(first.value, 7);
+    slow.set_value(1); // late result is dropped
+
+    rt::Future<void> orphan;
+    {
+        rt::Promise<void> dropped;
+        orphan = dropped.get_future();
+    }
+    EXPECT_THROW(orphan.get(), std::future_error);
+}
+
+TEST(ThreadPoolTests, PriorityLanesDeadlinesAndAging) {
+    using namespace std::chrono;
+    auto runBlocked = [](rt::ThreadPool& pool, const std::function<void(std::vector<int>&)>& queue) {
+        // one worker, parked on a gate while the test queues work behind it
+        std::promise<void> gate;
+        auto opened = gate.get_future().share();
+        pool.post(rt::Priority::High, [opened]{ opened.wait(); });
+        std::this_thread::sleep_for(milliseconds(5));
+        std::vector<int> order;
+        queue(order);
+        gate.set_value();
+        pool.submit(rt::TaskOptions(rt::Priority::Low, steady_clock::time_point::max()), []{}).get();
+        return order;
+    };
+
+    rt::PoolOptions noAging;
+    noAging.threads = 1;
+    noAging.aging = microseconds(0);
+    rt::ThreadPool strict(noAging);
+    const auto soon = steady_clock::now() + seconds(1);
+    auto order = runBlocked(strict, [&](std::vector<int>& out) {
+        strict.post(rt::Priority::Low, [&out]{ out.push_back(5); });
+        strict.post(rt::Priority::Normal, [&out]{ out.push_back(3); });
+        strict.post(rt::Priority::High, [&out]{ out.push_back(2); });
+        strict.post({rt::Priority::Normal, soon}, [&out]{ out.push_back(4); });
+        strict.post({rt::Priority::High, soon}, [&out]{ out.push_back(1); });
+    });
+    EXPECT_EQ(order, (std::vector<int>{1, 2, 4, 3, 5}));
+    EXPECT_EQ(strict.queueWait(rt::Priority::Low).count, 2u);
+    EXPECT_EQ(strict.queueWait(rt::Priority::High).count, 3u);
+    EXPECT_GT(strict.queueWait(rt::Priority::Low).max, 0u);
+
+    // a Low task that has waited several aging periods overtakes fresh High work
+    rt::PoolOptions aging;
+    aging.threads = 1;
+    aging.aging = milliseconds(1);
+    rt::ThreadPool fair(aging);
+    order = runBlocked(fair, [&](std::vector<int>& out) {
+        fair.post(rt::Priority::Low, [&out]{ out.push_back(1); });
+        std::this_thread::sleep_for(milliseconds(10));
+        fair.post(rt::Priority::High, [&out]{ out.push_back(2); });
+    });
+    EXPECT_EQ(order, (std::vector<int>{1, 2}));
+}
+
+TEST(ThreadPoolTests, TopologyAndPinnedWorkers) {
+    EXPECT_EQ(rt::parseCpuList("0-3,8, 10-11"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_TRUE(rt::parseCpuList("3-x").empty());
+
+    const auto& topo = rt::CpuTopology::system();
+    ASSERT_FALSE(topo.nodes.empty());
+    const int cpu = topo.nodes[0].cpus.front();
+    EXPECT_EQ(topo.nodeOf(cpu), 0);
+    EXPECT_EQ(topo.nodesByDistance(0).front(), 0);
+
+    // node-bound storage survives growth and frees with the matching call
+    std::vector<int, rt::NodeAllocator<int>> local{rt::NodeAllocator<int>(0)};
+    for (int i = 0; i < 10000; ++i) local.push_back(i);
+    EXPECT_EQ(local.get_allocator().node, 0);
+    EXPECT_EQ(local.back(), 9999);
+
+    rt::PoolOptions opts;
+    opts.threads = 2;
+    opts.affinity = rt::Affinity::Core;
+    opts.cpus = {cpu};
+    opts.numaAware = true;
+    rt::ThreadPool pool(opts);
+    EXPECT_EQ(pool.shardCount(), 1u); // a single allowed CPU means a single node
+    EXPECT_EQ(pool.workerCpus(1), std::vector<int>{cpu});
+#if defined(__linux__)
+    EXPECT_EQ(pool.submit([]{ return rt::currentCpu(); }).get(), cpu);
+#endif
+}
+
+TEST(ThreadPoolTests, BlockingRegionCompensatesAndShrinks) {
+    using namespace std::chrono;
+    rt::PoolOptions opts;
+    opts.threads = 1;
+    opts.sizing.idleShrink = milliseconds(20);
+    rt::ThreadPool pool(opts);
+    EXPECT_EQ(pool.liveThreads(), 1u);
+
+    // The only core worker blocks on work queued behind it; that only
+    // finishes because the pool starts a compensation thread.
+    std::atomic<bool> released{false};
+    std::atomic<size_t> liveWhileBlocked{0};
+    auto blocked = pool.submit([&] {
+        rt::BlockingRegion region;
+        liveWhileBlocked = pool.liveThreads();
+        const auto until = steady_clock::now() + seconds(10);
+        while (!released && steady_clock::now() < until) std::this_thread::sleep_for(milliseconds(1));
+        return released.load();
+    });
+    pool.post([&] { released = true; });
+    EXPECT_TRUE(blocked.get());
+    EXPECT_EQ(liveWhileBlocked.load(), 2u);
+
+    const auto until = steady_clock::now() + seconds(5);
+    while (pool.liveThreads() > 1 && steady_clock::now() < until) std::this_thread::sleep_for(milliseconds(5));
+    EXPECT_EQ(pool.liveThreads(), 1u);
+    EXPECT_EQ(pool.size(), 1u);
+    // only the compensation thread retires; the core worker keeps its slot
+    EXPECT_EQ(pool.submit([] { return rt::ThreadPool::currentWorker(); }).get(), 0);
+
+    // Off-pool regions are no-ops; the shrunk pool still runs work.
+    { rt::BlockingRegion none; }
+    EXPECT_EQ(pool.submit([] { return 7; }).get(), 7);
+}
+
+TEST(ThreadPoolTests, BoundedMpmcQueue) {
+    rt::MpmcQueue<std::unique_ptr<int>> small(3);
+    EXPECT_EQ(small.capacity(), 4u);
+    for (int i = 0; i < 4; ++i) EXPECT_TRUE(small.tryPush(std::make_unique<int>(i)));
+    auto extra = std::make_unique<int>(99);
+    EXPECT_FALSE(small.tryPush(std::move(extra))); // full: rejected, not moved from
+    ASSERT_TRUE(extra);
+    std::unique_ptr<int> out;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(small.tryPop(out));
+        EXPECT_EQ(*out, i);
+    }
+    EXPECT_FALSE(small.tryPop(out));
+
+    // 4 producers and 4 consumers through a 64-slot ring: nothing lost or duplicated.
+    rt::MpmcQueue<int> q(64);
+    constexpr int kPerProducer = 20000;
+    std::atomic<long long> sum{0};
+    std::atomic<int> popped{0};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < 4; ++p) {
+        threads.emplace_back([&q, p] {
+            for (int i = 1; i <= kPerProducer; ++i) {
+                int v = p * kPerProducer + i;
+                while (!q.tryPush(std::move(v))) std::this_thread::yield();
+            }
+        });
+    }
+    for (int c = 0; c < 4; ++c) {
+        threads.emplace_back([&] {
+            int v;
+            while (popped.load() < 4 * kPerProducer) {
+                if (q.tryPop(v)) { sum += v; ++popped; }
+                else std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    const long long n = 4LL * kPerProducer;
+    EXPECT_EQ(popped.load(), n);
+    EXPECT_EQ(sum.load(), n * (n + 1) / 2);
+}
+
+TEST(ThreadPoolTests, LegacyPoolBoundedQueueRejectsWhenFull) {
+    ::ThreadPool unstarted;
+    EXPECT_FALSE(unstarted.trySubmitTask([] { return 0; }));
+
+    ::ThreadPool pool;
+    pool.setTaskQueMaxThreshHold(2);
+    pool.start(1);
+
+    // park the only worker so queued tasks stay queued
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    std::atomic<bool> started(false);
+    auto blocker = pool.submitTask([&] { started = true; opened.wait(); });
+    while (!started) std::this_thread::yield();
+
+    // capacity 2, not the default 1024
+    auto first = pool.trySubmitTask([] { return 1; });
+    auto second = pool.trySubmitTask([] { return 2; });
+    ASSERT_TRUE(first);
+    ASSERT_TRUE(second);
+    EXPECT_FALSE(pool.trySubmitTask([] { return 3; }));
+
+    // FAIL_FUTURE (the default): a timed-out submit hands back a failed future
+    const auto t0 = std::chrono::steady_clock::now();
+    auto late = pool.submitTaskFor(20ms, [] { return 4; });
+    EXPECT_GE(std::chrono::steady_clock::now() - t0, 20ms);
+    EXPECT_THROW(late.get(), TaskRejected);
+
+    pool.setRejectPolicy(RejectPolicy::THROW);
+    EXPECT_THROW(pool.submitTaskFor(1ms, [] { return 5; }), TaskRejected);
+    pool.setSubmitTimeout(1ms);
+    EXPECT_THROW(pool.submitTask([] { return 6; }), TaskRejected);
+
+    gate.set_value();
+    blocker.get();
+    EXPECT_EQ(first->get(), 1);
+    EXPECT_EQ(second->get(), 2);
+
+    // a second pool in the same process gets thread ids that do not start at 0
+    ::ThreadPool other;
+    other.start(2);
+    EXPECT_EQ(other.submitTask([](int a, int b) { return a * b; }, 6, 7).get(), 42);
+    EXPECT_EQ(pool.submitTask([] { return 8; }).get(), 8);
+}
+
+TEST(ThreadPoolTests, LegacyPoolCachedModeFollowsSizingPolicy) {
+    ::ThreadPool pool;
+    pool.setMode(PoolMode::MODE_CACHED);
+    rt::SizingPolicy policy;
+    policy.maxThreads = 2;
+    policy.idleShrink = 50ms;
+    pool.setSizingPolicy(policy);
+    pool.start(1);
+
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    std::atomic<int> running(0);
+    std::vector<std::future<void>> blocked;
+    // the pool grows on submit when no thread is idle, so let each task start first
+    for (int i = 0; i < 4; ++i) {
+        blocked.push_back(pool.submitTask([&] { ++running; opened.wait(); }));
+        const auto until = std::chrono::steady_clock::now() + 50ms;
+        while (running.load() < std::min(i + 1, 2) && std::chrono::steady_clock::now() < until)
+            std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(20ms);
+    EXPECT_EQ(running.load(), 2); // grew to maxThreads, not one thread per task
+    gate.set_value();
+    for (auto& f : blocked) f.get();
+    EXPECT_EQ(running.load(), 4);
+}
+
+TEST(ThreadPoolTests, MetricsSnapshotAndExport) {
+    tp::ThreadPool ws(2);
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 200; ++i) results.push_back(ws.submit([i] { return i; }));
+    for (auto& r : results) r.get();
+    ws.shutdown(); // quiescent: counters are exact
+
+    rt::PoolMetrics m = ws.metrics();
+    ASSERT_EQ(m.workers.size(), 2u);
+    EXPECT_EQ(m.total().tasks, 200u);
+    EXPECT_EQ(m.queueWait.count, 200u);
+    EXPECT_EQ(m.runTime.count, 200u);
+    EXPECT_LE(m.total().steals, m.total().stealAttempts);
+    EXPECT_GE(m.utilization(), 0.0);
+    EXPECT_LE(m.utilization(), 1.0);
+
+    const auto j = nlohmann::json::parse(m.toJson());
+    EXPECT_EQ(j["total"]["tasks"], 200u);
+    EXPECT_EQ(j["workers"].size(), 2u);
+    EXPECT_EQ(j["run_time_ns"]["count"], 200u);
+
+    const std::string prom = m.toPrometheus("spf_ws", "pool=\"test\"");
+    EXPECT_NE(prom.find("# TYPE spf_ws_tasks_total counter"), std::string::npos);
+    EXPECT_NE(prom.find("spf_ws_tasks_total{pool=\"test\",worker=\"external\"} 0"), std::string::npos);
+    EXPECT_NE(prom.find("spf_ws_queue_wait_seconds_count{pool=\"test\"} 200"), std::string::npos);
+
+    // large second counts keep every digit a scrape needs for rate()
+    rt::PoolMetrics old;
+    old.uptimeNs = 1234567800000000ull + 1000000ull; // 1234567.801 s
+    const std::string promOld = old.toPrometheus("spf", "");
+    const std::string uptime = "\nspf_uptime_seconds ";
+    const auto at = promOld.find(uptime);
+    ASSERT_NE(at, std::string::npos);
+    EXPECT_EQ(std::stod(promOld.substr(at + uptime.size())), 1234567.801);
+
+    rt::ThreadPool pool(1);
+    for (int i = 0; i < 10; ++i) pool.submit([] {}).get();
+    pool.shutdown(); // the last task's counters land after its future is ready
+    const rt::PoolMetrics pm = pool.metrics();
+    EXPECT_EQ(pm.total().tasks, 10u);
+    EXPECT_EQ(pm.runTime.count, 10u);
+    EXPECT_EQ(pm.queueWait.count, 10u);
+
+    // HDR buckets keep percentiles within 12.5% of the recorded value.
+    rt::Histogram h;
+    for (int i = 0; i < 100; ++i) h.record(1000000);
+    const uint64_t p50 = h.snapshot().percentile(0.5);
+    EXPECT_GE(p50, 1000000u - 125000u);
+    EXPECT_LE(p50, 1000000u);
+}
+
+namespace {
+size_t countLeafDiffs(const nlohmann::json& a, const nlohmann::json& b) {
+    if (a.is_structured()) {
+        size_t n = 0;
+        for (auto it = a.begin(); it != a.end(); ++it) n += countLeafDiffs(*it, a.is_object() ? b.at(it.key()) : b.at(static_cast<size_t>(it - a.begin())));
+        return n;
+    }
+    return a == b ? 0 : 1;
+}
+} // namespace
+
+TEST(GeneratorTests, JsonPairNdjsonAndWorkflow) {
+    gen::JsonSpec spec;
+    spec.items = 200;
+    spec.targetBytes = 0;
+    spec.depth = 4;
+    spec.seed = 7;
+    std::ostringstream a, b, single;
+    const auto st = gen::writeJsonPair(a, b, spec, 0.05);
+    gen::writeJson(single, spec);
+    EXPECT_EQ(a.str(), single.str());
+    EXPECT_EQ(st.bytes, a.str().size());
+    EXPECT_EQ(st.items, 200u);
+
+    const auto ja = nlohmann::json::parse(a.str());
+    const auto jb = nlohmann::json::parse(b.str());
+    ASSERT_EQ(ja["items"].size(), 200u);
+    EXPECT_GT(st.diffs, 0u);
+    EXPECT_LT(st.diffs, st.leaves / 5);
+    EXPECT_EQ(countLeafDiffs(ja, jb), st.diffs);
+
+    spec.items = 0;
+    spec.targetBytes = 64 * 1024;
+    std::ostringstream nd;
+    const auto nst = gen::writeNdjson(nd, spec);
+    EXPECT_GE(nst.bytes, spec.targetBytes);
+    std::istringstream lines(nd.str());
+    std::string line;
+    uint64_t records = 0;
+    while (std::getline(lines, line)) {
+        EXPECT_EQ(nlohmann::json::parse(line)["id"], records);
+        ++records;
+    }
+    EXPECT_EQ(records, nst.items);
+
+    const auto path = std::filesystem::temp_directory_path() / "spf_gen_workflow.json";
+    const std::pair<gen::DagShape, uint64_t> shapes[] = {
+        {gen::DagShape::Wide, 2 * (50 - 2)}, {gen::DagShape::Deep, 49}, {gen::DagShape::Random, 0}};
+    for (const auto& [shape, edges] : shapes) {
+        gen::WorkflowGenSpec w;
+        w.shape = shape;
+        w.tasks = 50;
+        gen::GenStats wst;
+        {
+            std::ofstream os(path);
+            wst = gen::writeWorkflow(os, w);
+        }
+        const auto parsed = wf::parseWorkflowJson(path.string());
+        EXPECT_EQ(parsed.tasks.size(), 50u);
+        EXPECT_EQ(parsed.edges.size(), wst.edges);
+        EXPECT_EQ(wst.diffs, 0u);
+        if (edges) {
+            EXPECT_EQ(wst.edges, edges);
+        }
+        for (const auto& e : parsed.edges) EXPECT_LT(std::stoi(e.from.substr(1)), std::stoi(e.to.substr(1)));
+    }
+    std::filesystem::remove(path);
+}
+
 TEST(JsonProcessTests, FindExtractsExpectedValue) {
-    ASSERT_TRUE(ensurePluginLoaded("plugins/json_process.dll"));
+    ASSERT_TRUE(ensurePluginLoaded(pluginPath("json_process")));
     auto jsonProcess = core::PluginManager::instance()
         .createTyped<core::IJsonProcess>("default_json_process");
     ASSERT_TRUE(jsonProcess);
@@ -96,7 +888,7 @@ TEST(JsonProcessTests, FindExtractsExpectedValue) {
 }
 
 TEST(JsonProcessTests, AddWrapsBranchUnderPrefix) {
-    ASSERT_TRUE(ensurePluginLoaded("plugins/json_process.dll"));
+    ASSERT_TRUE(ensurePluginLoaded(pluginPath("json_process")));
     auto jsonProcess = core::PluginManager::instance()
         .createTyped<core::IJsonProcess>("default_json_process");
     ASSERT_TRUE(jsonProcess);
@@ -121,8 +913,507 @@ TEST(JsonProcessTests, AddWrapsBranchUnderPrefix) {
     EXPECT_EQ(leaf, "VALUE-A");
 }
 
+TEST(JsonProcessTests, DocumentHandleIsParsedOnceAndCopyOnWrite) {
+    ASSERT_TRUE(ensurePluginLoaded(pluginPath("json_process")));
+    auto jsonProcess = core::PluginManager::instance()
+        .createTyped<core::IJsonProcess>("default_json_process");
+    ASSERT_TRUE(jsonProcess);
+
+    const std::string content = readFile("input.json");
+    auto doc = jsonProcess->parseDocument(content);
+    ASSERT_TRUE(doc);
+    EXPECT_FALSE(jsonProcess->parseDocument("{not json"));
+
+    // Reports are byte-identical to the one-shot API.
+    for (const char* method : {"find", "add"}) {
+        const std::string keywords = std::string(method) == "find" ? "key1/key2" : "key11/key12|key1/key2";
+        std::string oneShot, viaDoc;
+        ASSERT_TRUE(jsonProcess->processJsonFiles(content, oneShot, keywords, method));
+        ASSERT_TRUE(doc->process(viaDoc, keywords, method));
+        EXPECT_EQ(viaDoc, oneShot) << method;
+    }
+
+    const auto original = nlohmann::ordered_json::parse(content);
+    EXPECT_EQ(doc->dump(), original.dump());
+    EXPECT_EQ(doc->dump(4), original.dump(4));
+
+    std::string report;
+    auto updated = doc->add("key11/key12|key1/key2", report);
+    ASSERT_TRUE(updated);
+    EXPECT_FALSE(doc->add("key11|no/such", report));
+    EXPECT_EQ(doc->dump(), original.dump()); // unchanged
+    const auto after = nlohmann::json::parse(updated->dump());
+    EXPECT_FALSE(after.contains("key1"));
+    EXPECT_EQ(after["key11"]["key12"]["key1"]["key2"], "VALUE-A");
+
+    ASSERT_TRUE(updated->find("key11/key12/key1/key2", report));
+    EXPECT_EQ(nlohmann::json::parse(report)["results"][0], "VALUE-A");
+    ASSERT_TRUE(doc->find("key1/key2", report));
+    EXPECT_EQ(nlohmann::json::parse(report)["results"][0], "VALUE-A");
+
+    // A wide root: top-level lookups go through the member index.
+    std::string wide = "{";
+    for (int i = 0; i < 40; ++i) wide += (i ? ",\"k" : "\"k") + std::to_string(i) + "\":{\"v\":" + std::to_string(i) + "}";
+    wide += "}";
+    auto wideDoc = jsonProcess->parseDocument(wide);
+    ASSERT_TRUE(wideDoc);
+    ASSERT_TRUE(wideDoc->find("k37/v", report));
+    EXPECT_EQ(nlohmann::json::parse(report)["results"][0], 37);
+    auto moved = wideDoc->add("k30/inner|k3/v", report);
+    ASSERT_TRUE(moved);
+    const auto wideAfter = nlohmann::ordered_json::parse(moved->dump());
+    EXPECT_EQ(wideAfter.size(), 39u);
+    EXPECT_FALSE(wideAfter.contains("k3"));
+    EXPECT_EQ(wideAfter["k30"]["inner"]["k3"]["v"], 3);
+    EXPECT_EQ(wideAfter.begin().key(), "k0");
+    ASSERT_TRUE(moved->find("k39/v", report));
+    EXPECT_EQ(nlohmann::json::parse(report)["results"][0], 39);
+}
+
+TEST(JsonProcessTests, AddRebuildsOnlyThePathToTheInsertionPoint) {
+    ASSERT_TRUE(ensurePluginLoaded(pluginPath("json_process")));
+    auto jsonProcess = core::PluginManager::instance()
+        .createTyped<core::IJsonProcess>("default_json_process");
+    ASSERT_TRUE(jsonProcess);
+
+    using ojson = nlohmann::ordered_json;
+    auto doc = jsonProcess->parseDocument(R"({"a":{"x":1,"b":{"y":2},"w":[3]},"t":{"u":[1,2]},"s":"str"})");
+    ASSERT_TRUE(doc);
+    std::string report;
+    auto once = doc->add("a/b/c|t/u", report);
+    ASSERT_TRUE(once);
+    auto twice = once->add("a/z|s", report);
+    ASSERT_TRUE(twice);
+    EXPECT_FALSE(once->add("a/x/k|s", report)); // prefix runs into a number
+    EXPECT_FALSE(once->add("a/w|s", report));   // prefix ends at an array
+
+    auto expected = ojson::parse(R"({"a":{"x":1,"b":{"y":2,"c":{"t":{"u":[1,2]}}},"w":[3],"z":{"s":"str"}}})");
+    EXPECT_EQ(twice->dump(), expected.dump());
+    EXPECT_EQ(twice->dump(4), expected.dump(4));
+    EXPECT_EQ(ojson::parse(once->dump())["a"]["b"]["c"]["t"], expected["a"]["b"]["c"]["t"]);
+    EXPECT_EQ(ojson::parse(doc->dump())["t"]["u"], ojson::parse("[1,2]")); // unchanged
+
+    // Every read agrees with a document parsed from the same text.
+    auto reparsed = jsonProcess->parseDocument(expected.dump());
+    ASSERT_TRUE(reparsed);
+    const std::vector<std::string> paths = {"a", "a/b", "a/b/c/t/u", "a/w", "a/z/s", "a/missing"};
+    for (const auto& path : paths) {
+        std::string grafted, plain;
+        ASSERT_TRUE(twice->find(path, grafted)) << path;
+        ASSERT_TRUE(reparsed->find(path, plain)) << path;
+        EXPECT_EQ(grafted, plain) << path;
+    }
+    std::string grafted, plain;
+    ASSERT_TRUE(twice->findBatch(paths, grafted));
+    ASSERT_TRUE(reparsed->findBatch(paths, plain));
+    EXPECT_EQ(grafted, plain);
+    for (const char* expr : {"$..y", "$.a.b", "$.a.*", "$"}) {
+        ASSERT_TRUE(twice->query(expr, grafted)) << expr;
+        ASSERT_TRUE(reparsed->query(expr, plain)) << expr;
+        EXPECT_EQ(grafted, plain) << expr;
+    }
+}
+
+TEST(JsonProcessTests, StreamingFindMatchesDocumentFind) {
+    ASSERT_TRUE(ensurePluginLoaded(pluginPath("json_process")));
+    auto jsonProcess = core::PluginManager::instance()
+        .createTyped<core::IJsonProcess>("default_json_process");
+    ASSERT_TRUE(jsonProcess);
+
+    const std::string content =
+        R"({"a":{"b":[{"c":1},[{"c":{"d":[true,null]}}],{"x":{"c":0}},7],"c":"skip"},"z":{"b":{"c":2}},)"
+        R"("s":"é\n","e":{}})";
+    auto doc = jsonProcess->parseDocument(content);
+    ASSERT_TRUE(doc);
+    for (const char* path : {"a/b/c", "a/b/c/d", "a/b", "a", "z/b/c", "e", "s", "a/x", "missing", "a/b/x/c"}) {
+        std::string streamed, viaDoc;
+        ASSERT_TRUE(jsonProcess->processJsonFiles(content, streamed, path, "find")) << path;
+        ASSERT_TRUE(doc->find(path, viaDoc)) << path;
+        EXPECT_EQ(streamed, viaDoc) << path;
+    }
+
+    std::string out;
+    ASSERT_TRUE(jsonProcess->processJsonFiles(content, out, "a/b/c", "find"));
+    const auto results = nlohmann::json::parse(out)["results"];
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_EQ(results[0], 1);
+    EXPECT_EQ(results[1]["d"], nlohmann::json::parse("[true,null]"));
+
+    EXPECT_TRUE(jsonProcess->processJsonFiles("[1,2]", out, "a", "find"));
+    EXPECT_FALSE(jsonProcess->processJsonFiles(R"({"a":1} trailing)", out, "a", "find"));
+    EXPECT_FALSE(jsonProcess->processJsonFiles(content, out, "", "find"));
+}
+
+TEST(JsonProcessTests, FindBatchSharesOneTraversal) {
+    ASSERT_TRUE(ensurePluginLoaded(pluginPath("json_process")));
+    auto jsonProcess = core::PluginManager::instance()
+        .createTyped<core::IJsonProcess>("default_json_process");
+    ASSERT_TRUE(jsonProcess);
+
+    const std::string content =
+        R"({"a":{"b":[{"c":1},[{"c":{"d":[true,null]}}],{"x":{"c":0}},7],"c":"skip"},"z":{"b":{"c":2}}})";
+    const std::vector<std::string> paths = {"a/b/c", "a/b", "a/b/c/d", "z/b/c", "missing", "a/b/c"};
+    std::string streamed, viaDoc;
+    ASSERT_TRUE(jsonProcess->findBatch(content, paths, streamed));
+    auto doc = jsonProcess->parseDocument(content);
+    ASSERT_TRUE(doc->findBatch(paths, viaDoc));
+    EXPECT_EQ(streamed, viaDoc);
+
+    const auto results = nlohmann::ordered_json::parse(streamed)["results"];
+    ASSERT_EQ(results.size(), 5u); // duplicate query reported once
+    EXPECT_EQ(results.begin().key(), "a/b/c");
+    for (const auto& path : paths) {
+        std::string single;
+        ASSERT_TRUE(doc->find(path, single));
+        EXPECT_EQ(nlohmann::ordered_json::parse(single)["results"], results[path]) << path;
+    }
+
+    std::string viaProcess;
+    ASSERT_TRUE(jsonProcess->processJsonFiles(content, viaProcess, "a/b/c; a/b ;a/b/c/d;z/b/c;missing;a/b/c", "findBatch"));
+    EXPECT_EQ(nlohmann::ordered_json::parse(viaProcess)["results"], results);
+    EXPECT_FALSE(jsonProcess->findBatch(content, {"a", ""}, streamed));
+}
+
+TEST(JsonProcessTests, QueryEvaluatesJsonPathSubset) {
+    ASSERT_TRUE(ensurePluginLoaded(pluginPath("json_process")));
+    auto jsonProcess = core::PluginManager::instance()
+        .createTyped<core::IJsonProcess>("default_json_process");
+    ASSERT_TRUE(jsonProcess);
+
+    const std::string content =
+        R"({"hosts":[{"name":"a","cpu":90,"tags":["x","y"]},{"name":"b","cpu":50,"tags":[]},)"
+        R"({"name":"c","cpu":85.5,"meta":{"cpu":99}}],"cfg":{"cpu":1,"name":"root"}})";
+    auto doc = jsonProcess->parseDocument(content);
+    ASSERT_TRUE(doc);
+    auto query = [&](const std::string& expr) {
+        std::string out;
+        EXPECT_TRUE(doc->query(expr, out)) << expr;
+        return out.empty() ? nlohmann::json() : nlohmann::json::parse(out)["results"];
+    };
+    using nlohmann::json;
+    EXPECT_EQ(query("$.hosts[*].name"), json::parse(R"(["a","b","c"])"));
+    EXPECT_EQ(query("hosts[?(@.cpu > 80)].name"), json::parse(R"(["a","c"])"));
+    EXPECT_EQ(query("$..cpu"), json::parse("[90,50,85.5,99,1]"));
+    EXPECT_EQ(query("$.hosts[-1].name"), json::parse(R"(["c"])"));
+    EXPECT_EQ(query("$.hosts[0:2].name"), json::parse(R"(["a","b"])"));
+    EXPECT_EQ(query("$.hosts[::-1].name"), json::parse(R"(["c","b","a"])"));
+    EXPECT_EQ(query("$.hosts[?(@.name == 'b' || @.meta)].name"), json::parse(R"(["b","c"])"));
+    EXPECT_EQ(query("$.hosts[?(!@.meta && @.cpu >= 50)].name"), json::parse(R"(["a","b"])"));
+    EXPECT_EQ(query("$.hosts[?(@.tags[1] == \"y\")].cpu"), json::parse("[90]"));
+    EXPECT_EQ(query("$['cfg']['cpu','name']"), json::parse(R"([1,"root"])"));
+    EXPECT_EQ(query("$.hosts[0].tags[0,1,5]"), json::parse(R"(["x","y"])"));
+    EXPECT_EQ(query("$"), json::array({json::parse(content)}));
+    EXPECT_EQ(query("$.hosts[0].tags[1]"), query("$.hosts[0].tags[1]")); // cached
+
+    std::string out;
+    EXPECT_FALSE(doc->query("$.hosts[?(@.cpu >)]", out));
+    EXPECT_FALSE(doc->query("$.hosts[", out));
+    ASSERT_TRUE(jsonProcess->processJsonFiles(content, out, "$..meta.cpu", "query"));
+    EXPECT_EQ(nlohmann::json::parse(out)["results"], json::parse("[99]"));
+}
+
+TEST(JsonProcessTests, FileEntryPointsParseFromMapping) {
+    ASSERT_TRUE(ensurePluginLoaded(pluginPath("json_process")));
+    auto jsonProcess = core::PluginManager::instance()
+        .createTyped<core::IJsonProcess>("default_json_process");
+    ASSERT_TRUE(jsonProcess);
+
+    const std::string content = readFile("input.json");
+    for (const char* method : {"find", "add", "query"}) {
+        const std::string keywords = std::string(method) == "add" ? "key11/key12|key1/key2" : "key1/key2";
+        std::string fromString, fromFile;
+        const bool okString = jsonProcess->processJsonFiles(content, fromString, keywords, method);
+        EXPECT_EQ(jsonProcess->processJsonFile("input.json", fromFile, keywords, method), okString) << method;
+        EXPECT_EQ(fromFile, fromString) << method;
+    }
+
+    auto doc = jsonProcess->parseDocumentFile("input.json");
+    ASSERT_TRUE(doc);
+    EXPECT_EQ(doc->dump(), jsonProcess->parseDocument(content)->dump());
+
+    std::string out;
+    EXPECT_FALSE(jsonProcess->processJsonFile("no/such/file.json", out, "a", "find"));
+    EXPECT_FALSE(jsonProcess->parseDocumentFile("no/such/file.json"));
+    const auto empty = uniqueTempFile("json_process_empty", ".json");
+    std::ofstream(empty).close();
+    EXPECT_FALSE(jsonProcess->processJsonFile(empty.string(), out, "a", "find"));
+    std::filesystem::remove(empty);
+}
+
+TEST(JsonProcessTests, StreamsReportsToOstream) {
+    ASSERT_TRUE(ensurePluginLoaded(pluginPath("json_process")));
+    auto jsonProcess = core::PluginManager::instance()
+        .createTyped<core::IJsonProcess>("default_json_process");
+    ASSERT_TRUE(jsonProcess);
+
+    const std::string content = R"({"a":{"b":[{"c":1},{"c":{"d":"x\ny"}}]},"e":2})";
+    const auto src = uniqueTempFile("json_process_stream", ".json");
+    std::ofstream(src) << content;
+
+    auto doc = jsonProcess->parseDocument(content);
+    ASSERT_TRUE(doc);
+    for (const char* method : {"find", "add", "query", "findBatch"}) {
+        const std::string m = method;
+        const std::string keywords = m == "add" ? "x|a" : m == "query" ? "$..c" : "a/b/c";
+        std::string expected;
+        ASSERT_TRUE(jsonProcess->processJsonFiles(content, expected, keywords, method)) << method;
+
+        std::ostringstream pretty, fromFile, compact;
+        EXPECT_TRUE(doc->process(pretty, keywords, method)) << method;
+        EXPECT_EQ(pretty.str(), expected) << method;
+        EXPECT_TRUE(jsonProcess->processJsonFile(src.string(), fromFile, keywords, method)) << method;
+        EXPECT_EQ(fromFile.str(), expected) << method;
+
+        // Compact output is the same report as a single line.
+        EXPECT_TRUE(jsonProcess->processJsonFile(src.string(), compact, keywords, method, -1)) << method;
+        EXPECT_EQ(compact.str(), nlohmann::ordered_json::parse(expected).dump()) << method;
+    }
+
+    std::ostringstream out;
+    EXPECT_FALSE(jsonProcess->processJsonFile(src.string(), out, "", "find"));
+    std::filesystem::remove(src);
+}
+
+TEST(JsonProcessTests, ReadsAndWritesBinaryFormats) {
+    ASSERT_TRUE(ensurePluginLoaded(pluginPath("json_process")));
+    ASSERT_TRUE(ensurePluginLoaded(pluginPath("json_compare")));
+    auto jsonProcess = core::PluginManager::instance()
+        .createTyped<core::IJsonProcess>("default_json_process");
+    auto comparator = core::PluginManager::instance()
+        .createTyped<core::IComparator>("default_json_compare");
+    ASSERT_TRUE(jsonProcess);
+    ASSERT_TRUE(comparator);
+
+    using ojson = nlohmann::ordered_json;
+    using core::JsonFormat;
+    const std::string content = R"({"a":{"b":[{"c":1},{"c":[2.5,"x"]}]},"e":{"f":null}})";
+    const auto doc = ojson::parse(content);
+    auto bytes = [](const std::vector<std::uint8_t>& v) { return std::string(v.begin(), v.end()); };
+    const std::vector<std::pair<JsonFormat, std::string>> encoded = {
+        {JsonFormat::Cbor, bytes(ojson::to_cbor(doc))},
+        {JsonFormat::MsgPack, bytes(ojson::to_msgpack(doc))},
+        {JsonFormat::Ubjson, bytes(ojson::to_ubjson(doc, true))},
+        {JsonFormat::Bson, bytes(ojson::to_bson(doc))},
+    };
+
+    for (const char* method : {"find", "query", "findBatch"}) {
+        const std::string keywords = std::string(method) == "query" ? "$..c" : "a/b/c";
+        std::string expected;
+        jsonProcess->setFormats(JsonFormat::Auto, JsonFormat::Json);
+        ASSERT_TRUE(jsonProcess->processJsonFiles(content, expected, keywords, method)) << method;
+
+        for (const auto& [format, input] : encoded) {
+            const char* name = core::formatName(format);
+            const auto detected = core::resolveFormat<ojson>(input.data(), input.data() + input.size(), JsonFormat::Auto);
+            EXPECT_EQ(detected, format) << name;
+
+            // Detected binary input gives the same text report.
+            std::string out;
+            EXPECT_TRUE(jsonProcess->processJsonFiles(input, out, keywords, method)) << name << " " << method;
+            EXPECT_EQ(out, expected) << name << " " << method;
+
+            // Binary output is the same report, encoded.
+            jsonProcess->setFormats(format, format);
+            ASSERT_TRUE(jsonProcess->processJsonFiles(input, out, keywords, method)) << name << " " << method;
+            ojson report;
+            std::string error;
+            ASSERT_TRUE(core::decodeJson(out.data(), out.data() + out.size(), format, report, error)) << error;
+            EXPECT_EQ(report, ojson::parse(expected)) << name << " " << method;
+            jsonProcess->setFormats(JsonFormat::Auto, JsonFormat::Json);
+        }
+    }
+
+    // A leading 0x00 (integer 0 in CBOR and MessagePack) is not JSON whitespace.
+    const std::string zero(1, '\0');
+    ojson decoded;
+    std::string error;
+    EXPECT_EQ(core::detectFormats(zero.data(), zero.data() + 1).front(), JsonFormat::Cbor);
+    ASSERT_TRUE(core::decodeJson(zero.data(), zero.data() + 1, JsonFormat::Auto, decoded, error)) << error;
+    EXPECT_EQ(decoded, 0);
+
+    // The comparator accepts binary inputs as well.
+    auto ours = uniqueTempFile("json_compare_ours", ".cbor");
+    auto golden = uniqueTempFile("json_compare_golden", ".json");
+    auto report = uniqueTempFile("json_compare_report", ".html");
+    std::ofstream(ours, std::ios::binary) << encoded[0].second;
+    std::ofstream(golden) << content;
+    EXPECT_TRUE(comparator->compareFiles(ours.string(), golden.string(), report.string()));
+    comparator->setInputFormat(JsonFormat::Json);
+    EXPECT_FALSE(comparator->compareFiles(ours.string(), golden.string(), report.string()));
+    comparator->setInputFormat(JsonFormat::Auto);
+
+    std::error_code ec;
+    std::filesystem::remove(ours, ec);
+    std::filesystem::remove(golden, ec);
+    std::filesystem::remove(report, ec);
+}
+
+TEST(JsonArenaTests, ParsesIntoArenaAndOutlivesScopeThroughSharedHandles) {
+    const std::string content = R"({"a":{"b":[{"c":1},{"c":[2.5,"a string past the SSO buffer"]}]},"e":null})";
+    const auto expected = nlohmann::ordered_json::parse(content);
+
+    auto arena = std::make_shared<core::JsonArena>();
+    std::shared_ptr<const core::ArenaJson> member;
+    {
+        core::JsonArena::Scope scope(arena.get());
+        auto value = core::ArenaJson::parse(content);
+        EXPECT_GT(arena->allocations(), 0u);
+        EXPECT_GT(arena->bytesReserved(), 0u);
+        EXPECT_EQ(nlohmann::ordered_json(value), expected);
+        EXPECT_EQ(value.dump(), expected.dump()); // key order kept
+        member = core::makeArenaShared(arena, std::move(value["a"]));
+    }
+    EXPECT_EQ(core::JsonArena::current(), nullptr);
+
+    // The handle keeps the arena alive and is readable outside the scope.
+    const std::weak_ptr<core::JsonArena> weak = arena;
+    arena.reset();
+    EXPECT_FALSE(weak.expired());
+    EXPECT_EQ(member->dump(), expected["a"].dump());
+    member.reset();
+    EXPECT_TRUE(weak.expired());
+
+    // Without a scope the same type allocates from the heap.
+    auto heap = core::ArenaJson::parse(content);
+    EXPECT_EQ(heap.dump(), expected.dump());
+
+    // An arena sized for a small record starts with a small chunk.
+    core::JsonArena sized(content.size());
+    {
+        core::JsonArena::Scope scope(&sized);
+        EXPECT_EQ(core::ArenaJson::parse(content).dump(), expected.dump());
+    }
+    EXPECT_LT(sized.bytesReserved(), size_t(64) << 10);
+}
+
+TEST(JsonProcessTests, ProcessesJsonLinesInParallel) {
+    ASSERT_TRUE(ensurePluginLoaded(pluginPath("json_process")));
+    auto jsonProcess = core::PluginManager::instance()
+        .createTyped<core::IJsonProcess>("default_json_process");
+    ASSERT_TRUE(jsonProcess);
+
+    // Records with CRLF endings, a blank line, a malformed record and no
+    // trailing newline.
+    std::string content;
+    std::vector<std::pair<size_t, std::string>> records; // offset, text
+    for (int i = 0; i < 300; ++i) {
+        std::string rec = i == 123 ? "{oops" :
+            R"({"id":)" + std::to_string(i) + R"(,"a":{"b":[{"c":)" + std::to_string(i) +
+            R"(},{"c":"s"}]},"e":)" + std::to_string(i % 3) + "}";
+        records.push_back({content.size(), rec});
+        content += rec;
+        if (i == 299) break;
+        content += i % 5 == 0 ? "\r\n" : "\n";
+        if (i == 7) content += "  \n";
+    }
+    const auto src = uniqueTempFile("json_process_lines", ".jsonl");
+    std::ofstream(src, std::ios::binary) << content;
+
+    rt::ThreadPool pool(4);
+    core::JsonLinesOptions options;
+    options.parallelism = 4;
+    options.batchBytes = 256; // many batches
+    for (const char* method : {"find", "query", "findBatch", "add"}) {
+        const std::string m = method;
+        const std::string keywords = m == "add" ? "x|a" : m == "query" ? "$..c" : m == "findBatch" ? "a/b/c;e" : "a/b/c";
+
+        jsonProcess->setExecutor([&pool](std::function<void()> task) { pool.post(std::move(task)); });
+        std::ostringstream ordered, unordered, serial;
+        options.ordered = true;
+        EXPECT_FALSE(jsonProcess->processJsonLines(src.string(), ordered, keywords, method, options)) << method;
+        options.ordered = false;
+        EXPECT_FALSE(jsonProcess->processJsonLines(src.string(), unordered, keywords, method, options)) << method;
+        jsonProcess->setExecutor(nullptr);
+        options.ordered = true;
+        EXPECT_FALSE(jsonProcess->processJsonLines(src.string(), serial, keywords, method, options)) << method;
+        EXPECT_EQ(serial.str(), ordered.str()) << method;
+
+        // One line per record, in input order, each the record's own report.
+        std::istringstream lines(ordered.str());
+        std::string line;
+        size_t n = 0;
+        for (; std::getline(lines, line); ++n) {
+            ASSERT_LT(n, records.size());
+            auto report = nlohmann::ordered_json::parse(line);
+            EXPECT_EQ(report["offset"], records[n].first) << method << " " << n;
+            report.erase("offset");
+            std::string expected;
+            if (n == 123) {
+                EXPECT_FALSE(jsonProcess->processJsonFiles(records[n].second, expected, keywords, method));
+                EXPECT_NE(report["error"].get<std::string>().find("parse"), std::string::npos) << report.dump();
+                continue;
+            }
+            ASSERT_TRUE(jsonProcess->processJsonFiles(records[n].second, expected, keywords, method));
+            auto full = nlohmann::ordered_json::parse(expected);
+            full.erase("processMethod");
+            full.erase("keywords");
+            EXPECT_EQ(report, full) << method << " " << n;
+        }
+        EXPECT_EQ(n, records.size()) << method;
+
+        // Unordered: the same lines in completion order.
+        auto sorted = [](const std::string& text) {
+            std::vector<std::string> v;
+            std::istringstream in(text);
+            for (std::string l; std::getline(in, l);) v.push_back(l);
+            std::sort(v.begin(), v.end());
+            return v;
+        };
+        EXPECT_EQ(sorted(unordered.str()), sorted(ordered.str())) << method;
+    }
+
+    std::ostringstream out;
+    EXPECT_FALSE(jsonProcess->processJsonLines(src.string(), out, "a", "zzz"));
+    EXPECT_TRUE(out.str().empty());
+    std::filesystem::remove(src);
+}
+
+TEST(IndexedOrderedMapTests, KeepsInsertionOrderAndIndexesLargeObjects) {
+    using ojson = nlohmann::ordered_json;
+    // Keys in non-sorted order, one of them repeated: the later value wins in place.
+    std::string content = "{";
+    for (int i = 0; i < 2000; ++i) content += "\"k" + std::to_string((i * 7919) % 2000) + "\":" + std::to_string(i) + ",";
+    content += "\"k5\":\"dup\"}";
+    const auto expected = ojson::parse(content);
+
+    auto value = core::ArenaJson::parse(content);
+    EXPECT_EQ(value.dump(), expected.dump());
+    const auto& object = value.get_ref<const core::ArenaJson::object_t&>();
+    EXPECT_TRUE(object.indexed());
+    EXPECT_EQ(value.size(), 2000u);
+    EXPECT_EQ(value["k5"], "dup");
+    for (int i = 0; i < 2000; i += 97) {
+        const std::string key = "k" + std::to_string(i);
+        EXPECT_TRUE(value.contains(key));
+        EXPECT_EQ(value.at(key).dump(), expected.at(key).dump());
+    }
+    EXPECT_FALSE(value.contains("missing"));
+    EXPECT_THROW(value.at("missing"), std::exception);
+
+    // Mutations keep the index in step with the positions.
+    value.erase("k0");
+    value.erase(value.begin());
+    value["new"] = 1;
+    auto check = expected;
+    check.erase("k0");
+    check.erase(check.begin());
+    check["new"] = 1;
+    EXPECT_EQ(value.dump(), check.dump());
+    for (auto it = check.begin(); it != check.end(); ++it) ASSERT_EQ(value.at(it.key()).dump(), it.value().dump()) << it.key();
+
+    // Small objects stay unindexed; copies and conversions keep the order.
+    auto small = core::ArenaJson::parse(R"({"z":1,"a":2,"m":3})");
+    EXPECT_FALSE(small.get_ref<const core::ArenaJson::object_t&>().indexed());
+    EXPECT_EQ(small.dump(), R"({"z":1,"a":2,"m":3})");
+    const core::ArenaJson copy = value;
+    EXPECT_EQ(copy, value);
+    EXPECT_TRUE(copy.get_ref<const core::ArenaJson::object_t&>().indexed());
+    EXPECT_EQ(core::ArenaJson(expected).dump(), expected.dump());
+    EXPECT_TRUE(core::ArenaJson(expected).contains("k1999"));
+}
+
 TEST(JsonCompareTests, GeneratesHtmlReport) {
-    ASSERT_TRUE(ensurePluginLoaded("plugins/json_compare.dll"));
+    ASSERT_TRUE(ensurePluginLoaded(pluginPath("json_compare")));
     auto comparator = core::PluginManager::instance()
         .createTyped<core::IComparator>("default_json_compare");
     ASSERT_TRUE(comparator);
@@ -137,7 +1428,7 @@ TEST(JsonCompareTests, GeneratesHtmlReport) {
     }
     {
         std::ofstream ofs(golden);
-        ofs << R"({"value":2,"arr":[1,3]})";
+        ofs << R"({"value":2,"arr":[1,3],"extra":true})";
     }
 
     ASSERT_TRUE(comparator->compareFiles(
@@ -0,0 +1,98 @@
+// Offline inspection of event segments written by rt::EventRecorder.
+//
+//   event_replay [--json out.jsonl] [--trace out.json] [--print] seg.000.evt [seg.001.evt ...]
+//
+// --print re-publishes the events into an EventBus with console subscribers,
+// the same way a live run would deliver them.
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "runtime/EventBus.hpp"
+#include "runtime/EventRecorder.hpp"
+
+namespace {
+
+void usage() {
+    std::cerr << "usage: event_replay [--json out.jsonl] [--trace out.json] [--print] "
+                 "segment.evt [segment.evt ...]\n";
+}
+
+double secondsOf(rt::EventTime t) {
+    return std::chrono::duration<double>(t.time_since_epoch()).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string jsonOut, traceOut;
+    bool print = false;
+    std::vector<std::string> segments;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--json" && i + 1 < argc) jsonOut = argv[++i];
+        else if (a == "--trace" && i + 1 < argc) traceOut = argv[++i];
+        else if (a == "--print") print = true;
+        else if (a == "-h" || a == "--help") { usage(); return 0; }
+        else segments.push_back(a);
+    }
+    if (segments.empty()) { usage(); return 2; }
+    if (jsonOut.empty() && traceOut.empty()) print = true;
+
+    rt::EventReader reader;
+    if (!reader.open(segments)) {
+        std::cerr << "[event_replay] " << reader.error() << "\n";
+        return 1;
+    }
+
+    if (print) {
+        rt::EventBus bus;
+        bus.subscribe<rt::WorkflowStarted>([](const rt::WorkflowStarted& e) {
+            std::cout << secondsOf(e.ts) << " workflow started, " << e.taskCount << " tasks\n";
+        });
+        bus.subscribe<rt::TaskQueued>([](const rt::TaskQueued& e) {
+            std::cout << secondsOf(e.ts) << " queued   " << e.id << "\n";
+        });
+        bus.subscribe<rt::TaskStarted>([](const rt::TaskStarted& e) {
+            std::cout << secondsOf(e.ts) << " started  " << e.id << " (worker " << e.worker << ")\n";
+        });
+        bus.subscribe<rt::TaskFinished>([](const rt::TaskFinished& e) {
+            std::cout << secondsOf(e.ts) << " finished " << e.id << (e.success ? " ok" : " FAILED");
+            if (!e.message.empty()) std::cout << ": " << e.message;
+            std::cout << "\n";
+        });
+        bus.subscribe<rt::WorkflowFinished>([](const rt::WorkflowFinished& e) {
+            std::cout << secondsOf(e.ts) << " workflow " << (e.success ? "succeeded" : "failed") << "\n";
+        });
+        bus.subscribe<rt::OutputChunk>([](const rt::OutputChunk& e) {
+            std::cout << secondsOf(e.ts) << " output   " << e.id << ": " << e.data << "\n";
+        });
+        bus.subscribe<rt::MetricSample>([](const rt::MetricSample& e) {
+            std::cout << secondsOf(e.ts) << " metric   " << e.name << " = " << e.value << "\n";
+        });
+        std::size_t n = reader.replay(bus);
+        if (!reader.error().empty()) {
+            std::cerr << "[event_replay] " << reader.error() << "\n";
+            return 1;
+        }
+        std::cout << "[event_replay] " << n << " events\n";
+    }
+
+    if (!jsonOut.empty()) {
+        std::ofstream os(jsonOut);
+        if (!os || !rt::writeJsonLines(reader, os)) {
+            std::cerr << "[event_replay] JSON export failed: " << jsonOut << " " << reader.error() << "\n";
+            return 1;
+        }
+    }
+    if (!traceOut.empty()) {
+        std::ofstream os(traceOut);
+        if (!os || !rt::writeChromeTrace(reader, os)) {
+            std::cerr << "[event_replay] trace export failed: " << traceOut << " " << reader.error() << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+// Converts documents between JSON text and the binary interchange formats
+// the JSON plugins read and write.
+//
+//   json_convert [--from auto|json|cbor|msgpack|ubjson|bson] [--to FORMAT]
+//                [--indent n] in out
+//
+// --from defaults to auto (detected from the leading bytes); --to defaults
+// to the format of the output extension (.json, .cbor, .msgpack, .ubj,
+// .bson), JSON if it has none of those. --indent applies to JSON output.
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "core/JsonCodec.hpp"
+#include "runtime/MappedFile.hpp"
+
+using json = nlohmann::ordered_json;
+
+namespace {
+
+void usage() {
+    std::cerr << "usage: json_convert [--from auto|json|cbor|msgpack|ubjson|bson] [--to FORMAT]\n"
+                 "                    [--indent n] in out\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    core::JsonFormat from = core::JsonFormat::Auto;
+    core::JsonFormat to = core::JsonFormat::Auto;
+    int indent = -1;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        const bool hasValue = i + 1 < argc;
+        bool ok = true;
+        if (a == "-h" || a == "--help") { usage(); return 0; }
+        else if (a == "--from" && hasValue) ok = core::parseFormat(argv[++i], from);
+        else if (a == "--to" && hasValue) ok = core::parseFormat(argv[++i], to) && to != core::JsonFormat::Auto;
+        else if (a == "--indent" && hasValue) indent = std::atoi(argv[++i]);
+        else if (!a.empty() && a[0] == '-') ok = false;
+        else paths.push_back(a);
+        if (!ok) {
+            std::cerr << "[json_convert] bad option: " << a << "\n";
+            usage();
+            return 2;
+        }
+    }
+    if (paths.size() != 2) { usage(); return 2; }
+    if (to == core::JsonFormat::Auto) to = core::formatFromExtension(paths[1]);
+    if (to == core::JsonFormat::Auto) to = core::JsonFormat::Json;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    rt::MappedFile src;
+    if (!src.openRead(paths[0], rt::MappedFile::Access::Sequential)) {
+        std::cerr << "[json_convert] cannot map " << paths[0] << "\n";
+        return 1;
+    }
+    from = core::resolveFormat<json>(src.data(), src.data() + src.size(), from);
+    json doc;
+    std::string error;
+    if (!core::decodeJson(src.data(), src.data() + src.size(), from, doc, error)) {
+        std::cerr << "[json_convert] cannot read " << paths[0] << " as " << core::formatName(from)
+                  << ": " << error << "\n";
+        return 1;
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+
+    std::ofstream out(paths[1], std::ios::binary);
+    if (!out) {
+        std::cerr << "[json_convert] cannot open " << paths[1] << "\n";
+        return 1;
+    }
+    try {
+        core::encodeJson(doc, to, out, indent);
+    } catch (const std::exception& e) {
+        std::cerr << "[json_convert] cannot write " << core::formatName(to) << ": " << e.what() << "\n";
+        return 1;
+    }
+    out.flush();
+    if (!out) {
+        std::cerr << "[json_convert] write failed: " << paths[1] << "\n";
+        return 1;
+    }
+    const auto t2 = std::chrono::steady_clock::now();
+
+    using ms = std::chrono::milliseconds;
+    std::cerr << "[json_convert] " << core::formatName(from) << " " << src.size() << " bytes -> "
+              << core::formatName(to) << " " << static_cast<long long>(out.tellp()) << " bytes (read "
+              << std::chrono::duration_cast<ms>(t1 - t0).count() << " ms, write "
+              << std::chrono::duration_cast<ms>(t2 - t1).count() << " ms)\n";
+    return 0;
+}
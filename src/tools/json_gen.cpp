@@ -0,0 +1,117 @@
+// Synthetic workloads for benchmarks and scale tests, streamed to disk.
+//
+//   json_gen json     [options] out.json
+//   json_gen pair     [options] [--diff-rate 0.01] a.json b.json
+//   json_gen ndjson   [options] out.ndjson
+//   json_gen workflow [--shape wide|deep|random] [--tasks n] [--cmd "true"] out.json
+//
+// Options: --size 4G (or --items n), --depth n, --fanout n, --array-len n,
+// --keys n, --numeric 0.5, --string-len n, --seed n. Sizes take K/M/G.
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "gen/Generator.hpp"
+
+namespace {
+
+void usage() {
+    std::cerr << "usage: json_gen json|pair|ndjson [--size N[K|M|G] | --items n] [--depth n] [--fanout n]\n"
+                 "                [--array-len n] [--keys n] [--numeric r] [--string-len n] [--seed n]\n"
+                 "                [--diff-rate r] out [out2]\n"
+                 "       json_gen workflow [--shape wide|deep|random] [--tasks n] [--parents n]\n"
+                 "                [--window n] [--cmd c] [--seed n] out\n";
+}
+
+bool parseSize(const std::string& s, uint64_t& out) {
+    char* end = nullptr;
+    const unsigned long long v = std::strtoull(s.c_str(), &end, 10);
+    if (end == s.c_str()) return false;
+    uint64_t mul = 1;
+    switch (*end) {
+    case '\0': break;
+    case 'k': case 'K': mul = uint64_t(1) << 10; ++end; break;
+    case 'm': case 'M': mul = uint64_t(1) << 20; ++end; break;
+    case 'g': case 'G': mul = uint64_t(1) << 30; ++end; break;
+    default: return false;
+    }
+    if (*end != '\0') return false;
+    out = v * mul;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) { usage(); return 2; }
+    const std::string mode = argv[1];
+    if (mode == "-h" || mode == "--help") { usage(); return 0; }
+
+    gen::JsonSpec spec;
+    gen::WorkflowGenSpec wf;
+    double diffRate = 0.01;
+    std::vector<std::string> outs;
+
+    for (int i = 2; i < argc; ++i) {
+        std::string a = argv[i];
+        const bool hasValue = i + 1 < argc;
+        bool ok = true;
+        if (a == "--size" && hasValue) { ok = parseSize(argv[++i], spec.targetBytes); spec.items = 0; }
+        else if (a == "--items" && hasValue) { ok = parseSize(argv[++i], spec.items); spec.targetBytes = 0; }
+        else if (a == "--depth" && hasValue) spec.depth = std::atoi(argv[++i]);
+        else if (a == "--fanout" && hasValue) spec.fanout = std::atoi(argv[++i]);
+        else if (a == "--array-len" && hasValue) spec.arrayLen = std::atoi(argv[++i]);
+        else if (a == "--keys" && hasValue) spec.keyCardinality = std::atoi(argv[++i]);
+        else if (a == "--numeric" && hasValue) spec.numericRatio = std::atof(argv[++i]);
+        else if (a == "--string-len" && hasValue) spec.stringLen = std::atoi(argv[++i]);
+        else if (a == "--diff-rate" && hasValue) diffRate = std::atof(argv[++i]);
+        else if (a == "--seed" && hasValue) { spec.seed = std::strtoull(argv[++i], nullptr, 10); wf.seed = spec.seed; }
+        else if (a == "--shape" && hasValue) ok = gen::parseDagShape(argv[++i], wf.shape);
+        else if (a == "--tasks" && hasValue) ok = parseSize(argv[++i], wf.tasks);
+        else if (a == "--parents" && hasValue) wf.maxParents = std::atoi(argv[++i]);
+        else if (a == "--window" && hasValue) wf.window = std::atoi(argv[++i]);
+        else if (a == "--cmd" && hasValue) wf.cmd = argv[++i];
+        else if (!a.empty() && a[0] == '-') ok = false;
+        else outs.push_back(a);
+        if (!ok) {
+            std::cerr << "[json_gen] bad option: " << a << "\n";
+            usage();
+            return 2;
+        }
+    }
+
+    const size_t want = mode == "pair" ? 2 : 1;
+    if (outs.size() != want) { usage(); return 2; }
+
+    std::vector<std::ofstream> files;
+    for (const auto& path : outs) {
+        files.emplace_back(path, std::ios::binary);
+        if (!files.back()) {
+            std::cerr << "[json_gen] cannot open " << path << "\n";
+            return 1;
+        }
+    }
+
+    gen::GenStats st;
+    if (mode == "json") st = gen::writeJson(files[0], spec);
+    else if (mode == "pair") st = gen::writeJsonPair(files[0], files[1], spec, diffRate);
+    else if (mode == "ndjson") st = gen::writeNdjson(files[0], spec);
+    else if (mode == "workflow") st = gen::writeWorkflow(files[0], wf);
+    else { usage(); return 2; }
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        files[i].flush();
+        if (!files[i]) {
+            std::cerr << "[json_gen] write failed: " << outs[i] << "\n";
+            return 1;
+        }
+    }
+    if (mode == "workflow")
+        std::cerr << "[json_gen] " << st.items << " tasks, " << st.edges << " edges, " << st.bytes << " bytes\n";
+    else
+        std::cerr << "[json_gen] " << st.items << " items, " << st.leaves << " leaves, " << st.diffs
+                  << " differing, " << st.bytes << " bytes\n";
+    return 0;
+}
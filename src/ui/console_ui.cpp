@@ -1,18 +1,46 @@
 #include "../../include/ui/console_ui.hpp"
 #include <iostream>
-#include <iomanip>
+#include <cstdio>
 
 namespace ui {
 
-void printProgressBar(int percent, int width) {
+namespace {
+
+const char* taskMark(TaskStatus s) {
+    if (s == InProgress) return "[>]";
+    if (s == Done) return "[\xE2\x9C\x93]"; // Unicode checkmark ✓ (UTF-8 encoded)
+    return "[ ]";
+}
+
+void appendTask(std::string& out, const Task& t) {
+    out += taskMark(t.status);
+    out += ' ';
+    out += t.name;
+    out += '\n';
+}
+
+} // namespace
+
+std::string formatProgressBar(int percent, int width) {
     if (percent < 0) percent = 0;
     if (percent > 100) percent = 100;
+    if (width < 0) width = 0;
     int filled = (percent * width) / 100;
-    std::cout << "\r[";
-    for (int i = 0; i < filled; ++i) std::cout << "#";
-    for (int i = filled; i < width; ++i) std::cout << "-";
-    std::cout << "] ";
-    std::cout << std::setw(3) << percent << "%";
+    std::string out;
+    out.reserve(static_cast<size_t>(width) + 8);
+    out += '[';
+    out.append(static_cast<size_t>(filled), '#');
+    out.append(static_cast<size_t>(width - filled), '-');
+    char pct[8];
+    std::snprintf(pct, sizeof(pct), "] %3d%%", percent);
+    out += pct;
+    return out;
+}
+
+// One buffered write + flush per call instead of one stream op per character.
+void printProgressBar(int percent, int width) {
+    std::string line = "\r" + formatProgressBar(percent, width);
+    std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
     std::cout.flush();
 }
 
@@ -23,16 +51,17 @@ void printSpinnerFrame(int frame) {
 }
 
 void printTask(const Task& t) {
-    const char* mark = "[ ]";
-    if (t.status == InProgress) mark = "[>]";
-    else if (t.status == Done) mark = "[\xE2\x9C\x93]"; // Unicode checkmark ✓ (UTF-8 encoded)
-    std::cout << mark << " " << t.name << "\n";
+    std::string line;
+    appendTask(line, t);
+    std::cout << line;
 }
 
 void printTaskList(const std::vector<Task>& tasks) {
+    std::string out;
     for (size_t i = 0; i < tasks.size(); ++i) {
-        printTask(tasks[i]);
+        appendTask(out, tasks[i]);
     }
+    std::cout << out;
 }
 
 void markTaskDoneAndPrint(Task& t) {
@@ -0,0 +1,196 @@
+#include "ui/dashboard.hpp"
+#include "ui/console_ui.hpp"
+
+#include <cstdio>
+#include <iostream>
+
+namespace ui {
+
+namespace {
+
+std::string formatDuration(double sec) {
+    if (sec < 0) sec = 0;
+    long s = static_cast<long>(sec + 0.5);
+    char buf[32];
+    if (s >= 3600) std::snprintf(buf, sizeof(buf), "%ld:%02ld:%02ld", s / 3600, (s / 60) % 60, s % 60);
+    else std::snprintf(buf, sizeof(buf), "%02ld:%02ld", s / 60, s % 60);
+    return buf;
+}
+
+} // namespace
+
+Dashboard::Dashboard(rt::EventBus& bus)
+    : Dashboard(bus, Options{}, std::cout) {}
+
+Dashboard::Dashboard(rt::EventBus& bus, Options opt)
+    : Dashboard(bus, opt, std::cout) {}
+
+Dashboard::Dashboard(rt::EventBus& bus, Options opt, std::ostream& out)
+    : bus_(bus), opt_(opt), out_(out) {
+    if (opt_.maxFps <= 0) opt_.maxFps = 1;
+
+    subs_.push_back(bus_.subscribe<rt::WorkflowStarted>([this](const rt::WorkflowStarted& e) {
+        Update u{rt::EventKind::WorkflowStarted, e.ts, {}};
+        u.total = e.taskCount;
+        record(std::move(u));
+    }));
+    subs_.push_back(bus_.subscribe<rt::TaskQueued>([this](const rt::TaskQueued& e) {
+        record(Update{rt::EventKind::TaskQueued, e.ts, {}});
+    }));
+    subs_.push_back(bus_.subscribe<rt::TaskStarted>([this](const rt::TaskStarted& e) {
+        record(Update{rt::EventKind::TaskStarted, e.ts, e.id, e.worker});
+    }));
+    subs_.push_back(bus_.subscribe<rt::TaskFinished>([this](const rt::TaskFinished& e) {
+        record(Update{rt::EventKind::TaskFinished, e.ts, e.id, e.worker, e.success});
+    }));
+    subs_.push_back(bus_.subscribe<rt::WorkflowFinished>([this](const rt::WorkflowFinished& e) {
+        record(Update{rt::EventKind::WorkflowFinished, e.ts, {}});
+    }));
+}
+
+Dashboard::~Dashboard() {
+    stop();
+    for (auto id : subs_) bus_.unsubscribe(id);
+}
+
+void Dashboard::start() {
+    std::lock_guard<std::mutex> g(renderMtx_);
+    if (renderThread_.joinable()) return;
+    stopping_ = false;
+    renderThread_ = std::thread([this]{ renderLoop(); });
+}
+
+void Dashboard::stop() {
+    {
+        std::lock_guard<std::mutex> g(renderMtx_);
+        if (!renderThread_.joinable()) return;
+        stopping_ = true;
+    }
+    renderCv_.notify_all();
+    renderThread_.join();
+}
+
+void Dashboard::record(Update u) {
+    std::vector<Update> stale; // freed outside the lock
+    {
+        std::lock_guard<std::mutex> g(pendingMtx_);
+        // A new run resets the view, so nothing recorded before it matters.
+        if (u.kind == rt::EventKind::WorkflowStarted) stale.swap(pending_);
+        pending_.push_back(std::move(u));
+    }
+    dirty_.store(true, std::memory_order_relaxed);
+}
+
+void Dashboard::refresh() const {
+    {
+        std::lock_guard<std::mutex> g(pendingMtx_);
+        pending_.swap(drained_);
+    }
+    for (Update& u : drained_) {
+        switch (u.kind) {
+            case rt::EventKind::WorkflowStarted:
+                view_ = State{};
+                view_.total = u.total;
+                view_.started = true;
+                view_.startTs = u.ts;
+                break;
+            case rt::EventKind::TaskQueued:
+                ++view_.queued;
+                break;
+            case rt::EventKind::TaskStarted:
+                if (view_.queued) --view_.queued;
+                view_.running[std::move(u.id)] = Running{u.ts, u.worker};
+                break;
+            case rt::EventKind::TaskFinished:
+                view_.running.erase(u.id);
+                ++view_.done;
+                if (!u.success) ++view_.failed;
+                break;
+            case rt::EventKind::WorkflowFinished:
+                view_.finished = true;
+                break;
+            default:
+                break;
+        }
+        view_.lastTs = u.ts;
+    }
+    drained_.clear(); // keeps its capacity for the next swap
+}
+
+std::string Dashboard::renderFrame() const {
+    std::lock_guard<std::mutex> g(viewMtx_);
+    refresh();
+    return format(view_, opt_, Clock::now());
+}
+
+void Dashboard::renderLoop() {
+    const auto frame = std::chrono::microseconds(1000000 / opt_.maxFps);
+    std::string buf;
+    for (;;) {
+        bool last;
+        {
+            std::unique_lock<std::mutex> lk(renderMtx_);
+            renderCv_.wait_for(lk, frame, [this]{ return stopping_; });
+            last = stopping_;
+        }
+        // Redraw on changes; running tasks' elapsed time also ticks while busy.
+        bool changed = dirty_.exchange(false, std::memory_order_relaxed);
+        std::string body;
+        {
+            std::lock_guard<std::mutex> g(viewMtx_);
+            refresh();
+            if (changed || !view_.running.empty() || last) body = format(view_, opt_, Clock::now());
+        }
+        if (!body.empty()) {
+            buf.clear();
+            if (opt_.ansi && lastLines_ > 0) {
+                // Cursor to the first line of the previous frame, clear below.
+                buf += "\x1b[" + std::to_string(lastLines_) + "F\x1b[J";
+            }
+            buf += body;
+            std::size_t lines = 0;
+            for (char c : body) if (c == '\n') ++lines;
+            lastLines_ = lines;
+            out_.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+            out_.flush();
+        }
+        if (last) return;
+    }
+}
+
+std::string Dashboard::format(const State& s, const Options& opt, Clock::time_point now) {
+    std::string out;
+    out.reserve(256 + s.running.size() * 48);
+
+    const int percent = s.total ? static_cast<int>(s.done * 100 / s.total) : 0;
+    out += formatProgressBar(percent, opt.barWidth);
+    out += "  " + std::to_string(s.done) + "/" + std::to_string(s.total) + " done";
+    if (s.failed) out += ", " + std::to_string(s.failed) + " failed";
+    out += '\n';
+
+    const auto end = s.finished ? s.lastTs : now;
+    const double elapsed = s.started ? std::chrono::duration<double>(end - s.startTs).count() : 0.0;
+    const double rate = elapsed > 0 ? static_cast<double>(s.done) / elapsed : 0.0;
+    const std::size_t left = s.total > s.done ? s.total - s.done : 0;
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "running %zu | queued %zu | %.1f tasks/s | elapsed %s | ETA %s\n",
+                  s.running.size(), s.queued, rate, formatDuration(elapsed).c_str(),
+                  s.finished ? "done" : (rate > 0 ? formatDuration(left / rate).c_str() : "--:--"));
+    out += line;
+
+    std::size_t shown = 0;
+    for (const auto& kv : s.running) {
+        if (shown++ == opt.maxRunningRows) {
+            out += "  ... " + std::to_string(s.running.size() - opt.maxRunningRows) + " more\n";
+            break;
+        }
+        const double sec = std::chrono::duration<double>(now - kv.second.since).count();
+        std::snprintf(line, sizeof(line), "  [>] %s (worker %d, %.1fs)\n",
+                      kv.first.c_str(), kv.second.worker, sec);
+        out += line;
+    }
+    return out;
+}
+
+} // namespace ui
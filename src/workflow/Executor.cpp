@@ -1,66 +1,157 @@
 #include "workflow/Executor.hpp"
+#include "runtime/Services.hpp"
+#include "runtime/Future.hpp"
+#include <algorithm>
 #include <unordered_map>
 #include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
 
 namespace wf {
 
+namespace {
+
+// Per-run DAG state, addressed by node index so the per-node pool task only
+// captures (state pointer, index) and stays inside rt::Task's inline buffer.
+struct RunState {
+    rt::EventBus& bus;
+    rt::ThreadPool& pool;
+    ITaskContext& ctx;
+    std::vector<std::shared_ptr<ITask>> tasks;
+    std::vector<std::string> ids;
+    std::vector<std::vector<int>> adj;
+    std::vector<char> critical; // on a longest path to a sink
+    std::unique_ptr<std::atomic<int>[]> indeg;
+    std::atomic<bool> ok{true};
+    std::atomic<int> remaining{0};
+    rt::Promise<void> done;
+
+    RunState(rt::EventBus& b, rt::ThreadPool& p, ITaskContext& c)
+        : bus(b), pool(p), ctx(c) {}
+};
+
+void runNode(RunState* st, int idx);
+
+// Every publish below is guarded so that a topic without subscribers costs
+// neither the clock read nor the payload's string copies.
+void submitNode(RunState* st, int idx) {
+    if (st->bus.hasSubscribers<rt::TaskQueued>())
+        st->bus.publish(rt::TaskQueued{st->ids[idx], st->ctx.clock().now()});
+    const rt::Priority lane = st->critical[idx] ? rt::Priority::High : rt::Priority::Normal;
+    st->pool.post(lane, [st, idx]{ runNode(st, idx); });
+}
+
+void runNode(RunState* st, int idx) {
+    const std::string& id = st->ids[idx];
+    const int worker = rt::ThreadPool::currentWorker();
+    const bool timed = st->bus.hasSubscribers<rt::MetricSample>();
+    rt::EventTime started;
+    if (timed || st->bus.hasSubscribers<rt::TaskStarted>()) {
+        started = st->ctx.clock().now();
+        st->bus.publish(rt::TaskStarted{id, started, worker});
+    }
+    TaskResult res;
+    try {
+        res = st->tasks[idx]->run(st->ctx);
+    } catch (const std::exception& e) {
+        res.success = false;
+        res.message = e.what();
+    } catch (...) {
+        res.success = false;
+        res.message = "unknown exception";
+    }
+    if (timed || st->bus.hasSubscribers<rt::TaskFinished>() || st->bus.hasSubscribers<rt::OutputChunk>()) {
+        const rt::EventTime now = st->ctx.clock().now();
+        // A successful task's message is its output; a failure's stays on TaskFinished.
+        if (res.success && !res.message.empty())
+            st->bus.emit<rt::OutputChunk>(id, now, res.message);
+        st->bus.emit<rt::TaskFinished>(id, now, worker, res.success, res.message);
+        if (timed) {
+            const std::chrono::duration<double, std::milli> ms = now - started;
+            st->bus.publish(rt::MetricSample{"task_ms", now, ms.count()});
+        }
+    }
+    if (!res.success) st->ok.store(false);
+
+    // release successors straight from the worker
+    for (int v : st->adj[idx]) {
+        if (st->indeg[v].fetch_sub(1, std::memory_order_acq_rel) == 1) submitNode(st, v);
+    }
+    if (st->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) st->done.set_value();
+}
+
+// Marks nodes on a longest chain (by task count) from a root to a sink.
+// Without cost estimates, depth is the best proxy for the critical path:
+// delaying any of these nodes delays the whole run.
+void markCriticalPath(RunState& st) {
+    const size_t n = st.tasks.size();
+    std::vector<int> indeg(n, 0), order;
+    order.reserve(n);
+    for (size_t u = 0; u < n; ++u) for (int v : st.adj[u]) ++indeg[v];
+    for (size_t u = 0; u < n; ++u) if (indeg[u] == 0) order.push_back(static_cast<int>(u));
+    for (size_t i = 0; i < order.size(); ++i) {
+        for (int v : st.adj[order[i]]) if (--indeg[v] == 0) order.push_back(v);
+    }
+    // height = nodes on the longest chain starting here; depth likewise ending here
+    std::vector<int> height(n, 1), depth(n, 1);
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        for (int v : st.adj[*it]) height[*it] = std::max(height[*it], height[v] + 1);
+    }
+    for (int u : order) {
+        for (int v : st.adj[u]) depth[v] = std::max(depth[v], depth[u] + 1);
+    }
+    int longest = 0;
+    for (int u : order) longest = std::max(longest, height[u]);
+    st.critical.assign(n, 0);
+    for (int u : order) st.critical[u] = (depth[u] + height[u] - 1 == longest);
+}
+
+} // namespace
+
 bool Executor::run(const WorkflowSpec& spec, ITaskContext& ctx) {
-    // Build adjacency and indegree
-    std::unordered_map<std::string, int> indeg;
-    std::unordered_map<std::string, std::vector<std::string>> adj;
-    std::unordered_map<std::string, std::shared_ptr<ITask>> tasks;
+    RunState st(bus_, pool_, ctx);
+    const size_t n = spec.tasks.size();
+    std::unordered_map<std::string, int> index;
+    st.tasks.reserve(n);
+    st.ids.reserve(n);
     for (auto& t : spec.tasks) {
-        tasks[t->id()] = t;
-        indeg[t->id()] = 0;
+        std::string id = t->id();
+        auto ins = index.emplace(id, static_cast<int>(st.tasks.size()));
+        if (!ins.second) { st.tasks[ins.first->second] = t; continue; } // duplicate id: last one wins
+        st.tasks.push_back(t);
+        st.ids.push_back(std::move(id));
     }
+
+    const size_t count = st.tasks.size();
+    st.adj.resize(count);
+    st.indeg.reset(new std::atomic<int>[count]);
+    for (size_t i = 0; i < count; ++i) st.indeg[i].store(0, std::memory_order_relaxed);
     for (auto& e : spec.edges) {
-        adj[e.from].push_back(e.to);
-        indeg[e.to]++;
+        auto from = index.find(e.from);
+        auto to = index.find(e.to);
+        if (from == index.end() || to == index.end()) continue;
+        st.adj[from->second].push_back(to->second);
+        st.indeg[to->second].fetch_add(1, std::memory_order_relaxed);
     }
+    st.remaining.store(static_cast<int>(count));
+    markCriticalPath(st);
 
-    std::atomic<bool> ok{true};
-    std::mutex mtx;
-    std::queue<std::string> ready;
-    for (auto& kv : indeg) if (kv.second == 0) ready.push(kv.first);
-
-    std::atomic<int> remaining{ static_cast<int>(tasks.size()) };
-    std::condition_variable cv;
-
-    auto submitNode = [&](const std::string& id){
-        pool_.submit([&, id]{
-            rt::Event ev{ "task_started", id, true, "" };
-            bus_.publish(ev);
-            auto it = tasks.find(id);
-            auto res = it->second->run(ctx);
-            rt::Event ev2{ "task_finished", id, res.success, res.message };
-            bus_.publish(ev2);
-            if (!res.success) ok.store(false);
-
-            // update indegrees of neighbors
-            std::lock_guard<std::mutex> lg(mtx);
-            for (auto& v : adj[id]) {
-                if (--indeg[v] == 0) {
-                    ready.push(v);
-                    cv.notify_one();
-                }
-            }
-            remaining--;
-            cv.notify_one();
-        });
-    };
-
-    while (remaining > 0) {
-        std::string next;
-        {
-            std::unique_lock<std::mutex> lk(mtx);
-            if (ready.empty()) {
-                cv.wait(lk, [&]{ return !ready.empty() || remaining.load() == 0; });
-            }
-            if (!ready.empty()) { next = ready.front(); ready.pop(); }
-        }
-        if (!next.empty()) submitNode(next);
+    if (bus_.hasSubscribers<rt::WorkflowStarted>())
+        bus_.publish(rt::WorkflowStarted{count, ctx.clock().now()});
+
+    auto finished = st.done.get_future();
+    std::vector<int> roots;
+    for (size_t i = 0; i < count; ++i) {
+        if (st.indeg[i].load(std::memory_order_relaxed) == 0) roots.push_back(static_cast<int>(i));
     }
-    return ok.load();
+    for (int r : roots) submitNode(&st, r);
+
+    if (count == 0) st.done.set_value();
+    finished.get();
+    if (bus_.hasSubscribers<rt::WorkflowFinished>())
+        bus_.publish(rt::WorkflowFinished{ctx.clock().now(), st.ok.load()});
+    return st.ok.load();
 }
 
 } // namespace wf